@@ -0,0 +1,186 @@
+#!/usr/bin/env python3
+# 解析shell中"prof dump file"导出的采样文件，对照elf文件符号化后输出各函数的采样占比
+# 用法: prof_report.py prof.bin [--image dir] [--top n]
+
+import bisect
+import os
+import struct
+import sys
+
+PROF_FILE_MAGIC = 0x4652504b
+HEADER = struct.Struct("<6I")
+TASK = struct.Struct("<I32s")
+SAMPLE = struct.Struct("<III")
+PROF_NO_TASK = 0xffffffff
+MODE_USR = 0x10
+
+MODES = {
+    0x10: "usr",
+    0x11: "fiq",
+    0x12: "irq",
+    0x13: "svc",
+    0x17: "abt",
+    0x1b: "und",
+    0x1f: "sys",
+}
+
+
+class Symbols:
+    """elf32小端文件中的函数符号表"""
+
+    def __init__(self, path):
+        self.path = path
+        self.addrs = []
+        self.syms = []
+        with open(path, "rb") as f:
+            data = f.read()
+        if data[:4] != b"\x7fELF" or data[4] != 1 or data[5] != 1:
+            raise ValueError("%s: not a 32-bit little-endian elf file" % path)
+
+        shoff, = struct.unpack_from("<I", data, 32)
+        shentsize, shnum = struct.unpack_from("<HH", data, 46)
+        sections = [struct.unpack_from("<10I", data, shoff + i * shentsize)
+                    for i in range(shnum)]
+
+        funcs = []
+        for sh in sections:
+            # SHT_SYMTAB
+            if sh[1] != 2:
+                continue
+            strtab = sections[sh[6]]
+            for off in range(sh[4], sh[4] + sh[5], sh[9] or 16):
+                name, value, size, info = struct.unpack_from("<IIIB", data, off)
+                if info & 0xf != 2:  # STT_FUNC
+                    continue
+                start = strtab[4] + name
+                end = data.index(b"\0", start)
+                # thumb函数地址最低位为1
+                funcs.append((value & ~1, size, data[start:end].decode()))
+
+        if not funcs:
+            raise ValueError("%s: no symbol table, samples shown as address"
+                             % path)
+        funcs.sort()
+        for value, size, name in funcs:
+            self.addrs.append(value)
+            self.syms.append((value, size, name))
+
+    def lookup(self, pc):
+        i = bisect.bisect_right(self.addrs, pc) - 1
+        if i < 0:
+            return None
+        value, size, name = self.syms[i]
+        if size and pc >= value + size:
+            return None
+        return name
+
+
+def load(path):
+    with open(path, "rb") as f:
+        data = f.read()
+
+    magic, version, period_us, task_count, sample_count, dropped = \
+        HEADER.unpack_from(data, 0)
+    if magic != PROF_FILE_MAGIC:
+        sys.exit("%s: not a kernel profile file" % path)
+
+    offset = HEADER.size
+    tasks = []
+    for _ in range(task_count):
+        pid, name = TASK.unpack_from(data, offset)
+        tasks.append((pid, name.split(b"\0", 1)[0].decode(errors="replace")))
+        offset += TASK.size
+
+    samples = []
+    for _ in range(sample_count):
+        if offset + SAMPLE.size > len(data):
+            break
+        samples.append(SAMPLE.unpack_from(data, offset))
+        offset += SAMPLE.size
+    return version, period_us, dropped, tasks, samples
+
+
+def find_image(image_dir, name):
+    """任务名称为程序文件名，查找对应的elf文件"""
+    base = os.path.basename(name)
+    for candidate in (base, base + ".elf", os.path.splitext(base)[0] + ".elf"):
+        path = os.path.join(image_dir, candidate)
+        if os.path.isfile(path):
+            return path
+    return None
+
+
+def load_symbols(cache, path):
+    if path not in cache:
+        try:
+            cache[path] = Symbols(path) if path else None
+        except (OSError, ValueError) as e:
+            print("warning: %s" % e, file=sys.stderr)
+            cache[path] = None
+    return cache[path]
+
+
+def report(title, counts, total, top):
+    count = sum(counts.values())
+    print("\n%s: %d samples (%.1f%%)" % (title, count, count * 100.0 / total))
+    print("%8s %7s  %s" % ("samples", "%", "function"))
+    for name, n in sorted(counts.items(), key=lambda kv: -kv[1])[:top]:
+        print("%8d %6.1f%%  %s" % (n, n * 100.0 / count, name))
+
+
+def main():
+    args = sys.argv[1:]
+    image_dir = os.path.join(os.path.dirname(os.path.abspath(__file__)), "..",
+                             "image")
+    top = 20
+    files = []
+    while args:
+        arg = args.pop(0)
+        if arg == "--image" and args:
+            image_dir = args.pop(0)
+        elif arg == "--top" and args:
+            top = int(args.pop(0))
+        else:
+            files.append(arg)
+    if len(files) != 1:
+        sys.exit("usage: %s prof.bin [--image dir] [--top n]" % sys.argv[0])
+
+    version, period_us, dropped, tasks, samples = load(files[0])
+    print("prof version %d, %d samples, period %dus, %d dropped" %
+          (version, len(samples), period_us, dropped))
+    if not samples:
+        return
+
+    cache = {}
+    kernel = load_symbols(cache, os.path.join(image_dir, "kernel.elf"))
+
+    # 内核态样本合并统计，用户态样本按程序分别统计
+    profiles = {}
+    modes = {}
+    for pc, task, mode in samples:
+        mode_name = MODES.get(mode, "0x%x" % mode)
+        modes[mode_name] = modes.get(mode_name, 0) + 1
+
+        if mode != MODE_USR:
+            title, syms = "kernel", kernel
+        elif task == PROF_NO_TASK or task >= len(tasks):
+            title, syms = "user (unknown task)", None
+        else:
+            pid, name = tasks[task]
+            title = "user %s (pid 0x%x)" % (name, pid)
+            syms = load_symbols(cache, find_image(image_dir, name))
+
+        func = syms.lookup(pc) if syms else None
+        counts = profiles.setdefault(title, {})
+        key = func or "0x%08x" % pc
+        counts[key] = counts.get(key, 0) + 1
+
+    print("modes: " + ", ".join("%s %.1f%%" % (m, n * 100.0 / len(samples))
+                                for m, n in sorted(modes.items(),
+                                                   key=lambda kv: -kv[1])))
+    for title in sorted(profiles, key=lambda t: -sum(profiles[t].values())):
+        report(title, profiles[title], len(samples), top)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,377 @@
+/**
+ * @file tools_test.c
+ * @author kbpoyo (kbpoyo@qq.com)
+ * @brief 在主机上编译运行的哈希表与红黑树单元测试及基准测试
+ *        用法(在仓库根目录下):
+ *        gcc -O2 -Isrc/inc -o tools_test script/tools_test.c \
+ *            src/tools/hash.c src/tools/rbtree.c src/tools/list.c && ./tools_test
+ *        可在参数中指定随机数种子，用于复现失败的测试
+ *        主机上的uint32_t可能为64位，支持时加上-m32与内核的整数宽度保持一致
+ * @version 0.1
+ * @date 2023-09-23
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "tools/hash.h"
+#include "tools/rbtree.h"
+
+// 测试与基准测试的节点数
+#define TEST_NODE_COUNT 10000
+#define BENCH_NODE_COUNT 1024
+#define BENCH_ROUNDS 200
+
+// 测试用的结构体，同时嵌入哈希表与红黑树节点
+typedef struct _item_t {
+  int key;
+  hash_node_t hash_node;
+  rbtree_node_t tree_node;
+} item_t;
+
+static item_t item_table[TEST_NODE_COUNT];
+static int test_failed;
+
+#define CHECK(expr)                                                   \
+  do {                                                                \
+    if (!(expr)) {                                                    \
+      printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #expr); \
+      test_failed++;                                                  \
+    }                                                                 \
+  } while (0)
+
+/**
+ * @brief 内核中ASSERT失败时调用的函数，主机上直接退出
+ *
+ */
+void pannic(const char *file, int line, const char *func, const char *reason) {
+  printf("assert failed: %s:%d %s: %s\n", file, line, func, reason);
+  exit(1);
+}
+
+/**
+ * @brief 打乱数组，用于生成随机的插入与删除顺序
+ *
+ * @param array
+ * @param count
+ */
+static void shuffle(int *array, int count) {
+  for (int i = count - 1; i > 0; --i) {
+    int j = rand() % (i + 1);
+    int tmp = array[i];
+    array[i] = array[j];
+    array[j] = tmp;
+  }
+}
+
+/**
+ * @brief 获取经过的时间，单位为纳秒
+ *
+ * @param start
+ * @return double
+ */
+static double elapsed_ns(clock_t start) {
+  return (double)(clock() - start) * 1e9 / CLOCKS_PER_SEC;
+}
+
+static int item_cmp(rbtree_node_t *a, rbtree_node_t *b) {
+  return rbtree_node_parent(a, item_t, tree_node)->key -
+         rbtree_node_parent(b, item_t, tree_node)->key;
+}
+
+static int item_key_cmp(const void *key, rbtree_node_t *node) {
+  return *(const int *)key - rbtree_node_parent(node, item_t, tree_node)->key;
+}
+
+/**
+ * @brief 检查以node为根的子树满足红黑树性质
+ *
+ * @param node
+ * @return int 子树的黑高，不满足时返回-1
+ */
+static int rbtree_check_node(rbtree_node_t *node) {
+  if (!node) {
+    return 1;
+  }
+
+  // 红色节点的子节点必须为黑色，子节点的父指针必须正确
+  if (node->color == RBTREE_RED &&
+      ((node->left && node->left->color == RBTREE_RED) ||
+       (node->right && node->right->color == RBTREE_RED))) {
+    return -1;
+  }
+  if ((node->left && node->left->parent != node) ||
+      (node->right && node->right->parent != node)) {
+    return -1;
+  }
+
+  // 左右子树的黑高必须相等
+  int left = rbtree_check_node(node->left);
+  int right = rbtree_check_node(node->right);
+  if (left < 0 || left != right) {
+    return -1;
+  }
+
+  return left + (node->color == RBTREE_BLACK);
+}
+
+/**
+ * @brief 检查整棵红黑树的性质以及中序遍历的顺序与节点数
+ *
+ * @param tree
+ * @return int 1：正确，0：错误
+ */
+static int rbtree_check(rbtree_t *tree) {
+  if (tree->root &&
+      (tree->root->color != RBTREE_BLACK || tree->root->parent)) {
+    return 0;
+  }
+  if (rbtree_check_node(tree->root) < 0) {
+    return 0;
+  }
+
+  int count = 0;
+  rbtree_node_t *prev = (rbtree_node_t *)0;
+  for (rbtree_node_t *node = rbtree_first(tree); node;
+       node = rbtree_next(node)) {
+    if (prev && item_cmp(prev, node) > 0) {
+      return 0;
+    }
+    prev = node;
+    count++;
+  }
+
+  return count == rbtree_size(tree) && prev == rbtree_last(tree);
+}
+
+/**
+ * @brief 哈希表的插入、查找、重复键值、删除与扩容
+ *
+ */
+static void test_hash(void) {
+  static hash_node_t *small_buckets[4];
+  static hash_node_t *large_buckets[8192];
+  hash_table_t table;
+
+  // 1.FNV-1a的已知结果，只比较低32位，结果与uint32_t的宽度无关
+  CHECK((hash_string("") & 0xffffffffu) == 2166136261u);
+  CHECK((hash_string("a") & 0xffffffffu) == 0xe40c292cu);
+  CHECK(hash_mem("a", 1) == hash_string("a"));
+
+  // 2.在很小的桶数组中插入，负载超限后扩容
+  hash_init(&table, small_buckets, 4);
+  for (int i = 0; i < TEST_NODE_COUNT; ++i) {
+    item_table[i].key = i;
+    hash_insert(&table, &item_table[i].hash_node, hash_u32(i));
+  }
+  CHECK(hash_size(&table) == TEST_NODE_COUNT);
+  CHECK(hash_need_grow(&table));
+  CHECK(hash_resize(&table, large_buckets, 8192) == small_buckets);
+  CHECK(hash_size(&table) == TEST_NODE_COUNT);
+  CHECK(!hash_need_grow(&table));
+
+  // 3.所有节点都能找到，不存在的键值找不到
+  for (int i = 0; i < TEST_NODE_COUNT; ++i) {
+    hash_node_t *node = hash_find(&table, hash_u32(i));
+    while (node && hash_node_parent(node, item_t, hash_node)->key != i) {
+      node = hash_find_next(node);
+    }
+    CHECK(node == &item_table[i].hash_node);
+  }
+  CHECK(hash_find(&table, hash_u32(TEST_NODE_COUNT)) == (hash_node_t *)0);
+
+  // 4.重复的键值通过hash_find_next全部遍历到
+  static item_t dup[3];
+  for (int i = 0; i < 3; ++i) {
+    hash_insert(&table, &dup[i].hash_node, 0xdeadbeef);
+  }
+  int dup_count = 0;
+  for (hash_node_t *node = hash_find(&table, 0xdeadbeef); node;
+       node = hash_find_next(node)) {
+    dup_count++;
+  }
+  CHECK(dup_count == 3);
+
+  // 5.删除偶数节点后只剩奇数节点，重复删除返回0
+  for (int i = 0; i < 3; ++i) {
+    CHECK(hash_remove(&table, &dup[i].hash_node) == &dup[i].hash_node);
+  }
+  for (int i = 0; i < TEST_NODE_COUNT; i += 2) {
+    CHECK(hash_remove(&table, &item_table[i].hash_node) ==
+          &item_table[i].hash_node);
+    CHECK(hash_remove(&table, &item_table[i].hash_node) == (hash_node_t *)0);
+  }
+  CHECK(hash_size(&table) == TEST_NODE_COUNT / 2);
+  for (int i = 0; i < TEST_NODE_COUNT; ++i) {
+    hash_node_t *node = hash_find(&table, hash_u32(i));
+    while (node && hash_node_parent(node, item_t, hash_node)->key != i) {
+      node = hash_find_next(node);
+    }
+    CHECK((node != (hash_node_t *)0) == (i & 1));
+  }
+}
+
+/**
+ * @brief 红黑树按随机顺序插入与删除，每一步后检查红黑树的性质
+ *
+ */
+static void test_rbtree(void) {
+  static int order[TEST_NODE_COUNT];
+  rbtree_t tree;
+  rbtree_init(&tree, item_cmp);
+
+  // 1.以随机顺序插入偶数键值
+  for (int i = 0; i < TEST_NODE_COUNT; ++i) {
+    order[i] = i;
+  }
+  shuffle(order, TEST_NODE_COUNT);
+  for (int i = 0; i < TEST_NODE_COUNT; ++i) {
+    item_t *item = item_table + order[i];
+    item->key = order[i] * 2;
+    rbtree_insert(&tree, &item->tree_node);
+    if (i % 997 == 0) {
+      CHECK(rbtree_check(&tree));
+    }
+  }
+  CHECK(rbtree_check(&tree));
+  CHECK(rbtree_size(&tree) == TEST_NODE_COUNT);
+
+  // 2.查找、下界与首尾节点
+  for (int i = 0; i < TEST_NODE_COUNT; ++i) {
+    int key = i * 2;
+    CHECK(rbtree_find(&tree, &key, item_key_cmp) == &item_table[i].tree_node);
+    key = i * 2 - 1;
+    CHECK(rbtree_find(&tree, &key, item_key_cmp) == (rbtree_node_t *)0);
+    CHECK(rbtree_lower_bound(&tree, &key, item_key_cmp) ==
+          &item_table[i].tree_node);
+  }
+  int key = TEST_NODE_COUNT * 2;
+  CHECK(rbtree_lower_bound(&tree, &key, item_key_cmp) == (rbtree_node_t *)0);
+  CHECK(rbtree_first(&tree) == &item_table[0].tree_node);
+  CHECK(rbtree_last(&tree) == &item_table[TEST_NODE_COUNT - 1].tree_node);
+  CHECK(rbtree_prev(rbtree_first(&tree)) == (rbtree_node_t *)0);
+
+  // 3.以另一个随机顺序删除全部节点
+  shuffle(order, TEST_NODE_COUNT);
+  for (int i = 0; i < TEST_NODE_COUNT; ++i) {
+    rbtree_remove(&tree, &item_table[order[i]].tree_node);
+    if (i % 997 == 0) {
+      CHECK(rbtree_check(&tree));
+    }
+  }
+  CHECK(rbtree_size(&tree) == 0 && tree.root == (rbtree_node_t *)0);
+}
+
+/**
+ * @brief 对比链表线性扫描、哈希表与红黑树的查找耗时，以及插入删除的耗时
+ *        节点数与内核中任务表、设备表的规模相当
+ *
+ */
+static void bench(void) {
+  static hash_node_t *buckets[BENCH_NODE_COUNT / HASH_LOAD_FACTOR];
+  static int order[BENCH_NODE_COUNT];
+  hash_table_t table;
+  rbtree_t tree;
+  list_t list;
+  static list_node_t list_nodes[BENCH_NODE_COUNT];
+
+  for (int i = 0; i < BENCH_NODE_COUNT; ++i) {
+    order[i] = i;
+    item_table[i].key = i;
+  }
+  shuffle(order, BENCH_NODE_COUNT);
+
+  // 1.插入与删除
+  clock_t start = clock();
+  for (int r = 0; r < BENCH_ROUNDS; ++r) {
+    hash_init(&table, buckets, BENCH_NODE_COUNT / HASH_LOAD_FACTOR);
+    for (int i = 0; i < BENCH_NODE_COUNT; ++i) {
+      hash_insert(&table, &item_table[order[i]].hash_node, hash_u32(order[i]));
+    }
+    for (int i = 0; i < BENCH_NODE_COUNT; ++i) {
+      hash_remove(&table, &item_table[i].hash_node);
+    }
+  }
+  double hash_update = elapsed_ns(start) / (BENCH_ROUNDS * BENCH_NODE_COUNT);
+
+  start = clock();
+  for (int r = 0; r < BENCH_ROUNDS; ++r) {
+    rbtree_init(&tree, item_cmp);
+    for (int i = 0; i < BENCH_NODE_COUNT; ++i) {
+      rbtree_insert(&tree, &item_table[order[i]].tree_node);
+    }
+    for (int i = 0; i < BENCH_NODE_COUNT; ++i) {
+      rbtree_remove(&tree, &item_table[i].tree_node);
+    }
+  }
+  double tree_update = elapsed_ns(start) / (BENCH_ROUNDS * BENCH_NODE_COUNT);
+
+  // 2.建立三种结构后按随机顺序查找全部键值
+  hash_init(&table, buckets, BENCH_NODE_COUNT / HASH_LOAD_FACTOR);
+  rbtree_init(&tree, item_cmp);
+  list_init(&list);
+  for (int i = 0; i < BENCH_NODE_COUNT; ++i) {
+    hash_insert(&table, &item_table[i].hash_node, hash_u32(i));
+    rbtree_insert(&tree, &item_table[i].tree_node);
+    list_node_init(list_nodes + i);
+    list_insert_last(&list, list_nodes + i);
+  }
+
+  long found = 0;
+  start = clock();
+  for (int r = 0; r < BENCH_ROUNDS; ++r) {
+    for (int i = 0; i < BENCH_NODE_COUNT; ++i) {
+      for (list_node_t *node = list_get_first(&list); node;
+           node = list_node_next(node)) {
+        if (node - list_nodes == order[i]) {
+          found++;
+          break;
+        }
+      }
+    }
+  }
+  double list_find = elapsed_ns(start) / (BENCH_ROUNDS * BENCH_NODE_COUNT);
+
+  start = clock();
+  for (int r = 0; r < BENCH_ROUNDS; ++r) {
+    for (int i = 0; i < BENCH_NODE_COUNT; ++i) {
+      found += hash_find(&table, hash_u32(order[i])) != (hash_node_t *)0;
+    }
+  }
+  double hash_find_ns = elapsed_ns(start) / (BENCH_ROUNDS * BENCH_NODE_COUNT);
+
+  start = clock();
+  for (int r = 0; r < BENCH_ROUNDS; ++r) {
+    for (int i = 0; i < BENCH_NODE_COUNT; ++i) {
+      found += rbtree_find(&tree, order + i, item_key_cmp) !=
+               (rbtree_node_t *)0;
+    }
+  }
+  double tree_find = elapsed_ns(start) / (BENCH_ROUNDS * BENCH_NODE_COUNT);
+
+  CHECK(found == 3L * BENCH_ROUNDS * BENCH_NODE_COUNT);
+  printf("%d nodes, ns per operation:\n", BENCH_NODE_COUNT);
+  printf("  %-8s %10s %10s\n", "", "find", "ins+del");
+  printf("  %-8s %10.1f %10s\n", "list", list_find, "-");
+  printf("  %-8s %10.1f %10.1f\n", "hash", hash_find_ns, hash_update);
+  printf("  %-8s %10.1f %10.1f\n", "rbtree", tree_find, tree_update);
+}
+
+int main(int argc, char **argv) {
+  srand(argc > 1 ? atoi(argv[1]) : (int)time(0));
+
+  test_hash();
+  test_rbtree();
+  if (test_failed) {
+    printf("%d checks failed\n", test_failed);
+    return 1;
+  }
+  printf("hash and rbtree tests passed\n");
+
+  bench();
+  return test_failed ? 1 : 0;
+}
@@ -0,0 +1,157 @@
+#!/usr/bin/env python3
+# 解析shell中"trace dump file"导出的内核事件跟踪文件，输出时间线与耗时统计
+# 用法: trace_decode.py trace.bin [--summary]
+
+import os
+import re
+import struct
+import sys
+
+TRACE_FILE_MAGIC = 0x4354524b
+HEADER = struct.Struct("<5I")
+RECORD = struct.Struct("<IHHIII")
+TRACE_FLAG_IRQ = 1 << 0
+
+EVENTS = [
+    "sched_switch",
+    "sched_wakeup",
+    "syscall_enter",
+    "syscall_exit",
+    "irq_enter",
+    "irq_exit",
+    "disk_read",
+    "disk_write",
+    "disk_done",
+    "page_fault",
+]
+
+
+def load_syscall_names():
+    """从内核头文件中读取系统调用名称"""
+    path = os.path.join(os.path.dirname(os.path.abspath(__file__)), "..", "src",
+                        "kernel", "inc", "core", "syscall.h")
+    names = {}
+    try:
+        with open(path, encoding="utf-8") as f:
+            for line in f:
+                m = re.match(r"\s*#define\s+SYS_(\w+)\s+(\d+)", line)
+                if m:
+                    names[int(m.group(2))] = m.group(1)
+    except OSError:
+        pass
+    return names
+
+
+def describe(event, arg0, arg1, syscalls):
+    """将记录的参数解释为可读的描述"""
+    if event == 0:
+        return "0x%x -> 0x%x" % (arg0, arg1)
+    if event == 1:
+        return "task 0x%x (sem 0x%x)" % (arg0, arg1)
+    if event == 2:
+        return "%s(0x%x)" % (syscalls.get(arg0, str(arg0)), arg1)
+    if event == 3:
+        ret = arg1 - (1 << 32) if arg1 & 0x80000000 else arg1
+        return "%s = %d" % (syscalls.get(arg0, str(arg0)), ret)
+    if event in (4, 5):
+        return "irq %d" % arg0
+    if event in (6, 7):
+        return "sector %d, count %d" % (arg0, arg1)
+    if event == 8:
+        ret = arg1 - (1 << 32) if arg1 & 0x80000000 else arg1
+        return "sector %d, result %d" % (arg0, ret)
+    if event == 9:
+        return "addr 0x%08x, state 0x%x" % (arg0, arg1)
+    return "0x%x 0x%x" % (arg0, arg1)
+
+
+def load(path):
+    with open(path, "rb") as f:
+        data = f.read()
+
+    magic, version, record_size, unit_us, count = HEADER.unpack_from(data, 0)
+    if magic != TRACE_FILE_MAGIC:
+        sys.exit("%s: not a kernel trace file" % path)
+    if record_size < RECORD.size:
+        sys.exit("%s: unsupported record size %d" % (path, record_size))
+
+    records = []
+    offset = HEADER.size
+    for _ in range(count):
+        if offset + record_size > len(data):
+            break
+        records.append(RECORD.unpack_from(data, offset))
+        offset += record_size
+    return version, unit_us, records
+
+
+def timeline(unit_us, records, syscalls):
+    if not records:
+        return
+    start = prev = records[0][0]
+    print("%12s %10s  %-10s %-4s %-14s %s" %
+          ("time(ms)", "delta(us)", "pid", "ctx", "event", "detail"))
+    for time, event, flags, pid, arg0, arg1 in records:
+        # 时间戳为32位，按无符号差值处理回绕
+        elapsed = ((time - start) & 0xffffffff) * unit_us
+        delta = ((time - prev) & 0xffffffff) * unit_us
+        prev = time
+        name = EVENTS[event] if event < len(EVENTS) else "event_%d" % event
+        ctx = "irq" if flags & TRACE_FLAG_IRQ else "task"
+        print("%12.3f %10d  0x%-8x %-4s %-14s %s" %
+              (elapsed / 1000.0, delta, pid, ctx, name,
+               describe(event, arg0, arg1, syscalls)))
+
+
+def summary(unit_us, records, syscalls):
+    """统计系统调用、中断与磁盘操作的耗时"""
+    stats = {}
+    pending = {}
+
+    def add(key, cost):
+        s = stats.setdefault(key, [0, 0, 0])
+        s[0] += 1
+        s[1] += cost
+        s[2] = max(s[2], cost)
+
+    for time, event, flags, pid, arg0, arg1 in records:
+        if event == 2:
+            pending[("sys", pid)] = (time, arg0)
+        elif event == 3 and ("sys", pid) in pending:
+            begin, sid = pending.pop(("sys", pid))
+            add("syscall " + syscalls.get(sid, str(sid)),
+                (time - begin) & 0xffffffff)
+        elif event == 4:
+            pending[("irq", arg0)] = time
+        elif event == 5 and ("irq", arg0) in pending:
+            add("irq %d" % arg0, (time - pending.pop(("irq", arg0))) & 0xffffffff)
+        elif event in (6, 7):
+            pending[("disk", arg0)] = (time, event)
+        elif event == 8 and ("disk", arg0) in pending:
+            begin, kind = pending.pop(("disk", arg0))
+            add("disk " + ("read" if kind == 6 else "write"),
+                (time - begin) & 0xffffffff)
+
+    print("\n%-28s %8s %12s %12s" % ("operation", "count", "avg(us)", "max(us)"))
+    for key in sorted(stats, key=lambda k: -stats[k][1]):
+        count, total, peak = stats[key]
+        print("%-28s %8d %12d %12d" %
+              (key, count, total * unit_us // count, peak * unit_us))
+
+
+def main():
+    args = [a for a in sys.argv[1:] if not a.startswith("--")]
+    if len(args) != 1:
+        sys.exit("usage: %s trace.bin [--summary]" % sys.argv[0])
+
+    version, unit_us, records = load(args[0])
+    syscalls = load_syscall_names()
+    print("trace version %d, %d records, time unit %dus" %
+          (version, len(records), unit_us))
+    timeline(unit_us, records, syscalls)
+    if "--summary" in sys.argv:
+        summary(unit_us, records, syscalls)
+
+
+if __name__ == "__main__":
+    main()
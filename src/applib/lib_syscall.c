@@ -1,5 +1,6 @@
 #include "lib_syscall.h"
 
+#include <stdarg.h>
 #include <stdlib.h>
 
 #include "common/os_config.h"
@@ -419,3 +420,372 @@ int task_use_stat(char *buf, int size, int *task_count) {
 
   return err;
 }
+
+/**
+ * @brief 将文件映射到进程的虚拟空间中
+ *
+ * @param addr 期望的映射起始地址，为0时由内核选择
+ * @param length 映射长度
+ * @param prot 映射区的访问权限
+ * @param flags 映射方式，MAP_SHARED或MAP_PRIVATE
+ * @param fd 被映射文件的文件描述符
+ * @param offset 文件内的偏移量，按页对齐
+ * @return void* 映射区起始地址，失败返回MAP_FAILED
+ */
+void *mmap(void *addr, uint32_t length, int prot, int flags, int fd,
+           uint32_t offset) {
+  // 参数个数超过4个，通过结构体传递
+  mmap_args_t mmap_args;
+  mmap_args.addr = addr;
+  mmap_args.length = length;
+  mmap_args.prot = prot;
+  mmap_args.flags = flags;
+  mmap_args.fd = fd;
+  mmap_args.offset = offset;
+
+  syscall_args_t args;
+  args.id = SYS_mmap;
+  args.arg0 = (uint32_t)&mmap_args;
+
+  int ret = sys_call(&args);
+  if (ret == -1) {
+    return MAP_FAILED;
+  }
+
+  return (void *)ret;
+}
+
+/**
+ * @brief 解除进程[addr, addr + length)范围内的文件映射
+ *
+ * @param addr
+ * @param length
+ * @return int
+ */
+int munmap(void *addr, uint32_t length) {
+  syscall_args_t args;
+  args.id = SYS_munmap;
+  args.arg0 = (uint32_t)addr;
+  args.arg1 = length;
+
+  return sys_call(&args);
+}
+
+/**
+ * @brief 获取键值对应的共享内存段，不存在时按标志位创建
+ *
+ * @param key 键值，IPC_PRIVATE总是创建新的共享内存段
+ * @param size 共享内存段大小
+ * @param flags IPC_CREAT，IPC_EXCL
+ * @return int 共享内存段标识
+ */
+int shmget(int key, uint32_t size, int flags) {
+  syscall_args_t args;
+  args.id = SYS_shmget;
+  args.arg0 = key;
+  args.arg1 = size;
+  args.arg2 = flags;
+
+  return sys_call(&args);
+}
+
+/**
+ * @brief 将共享内存段挂接到进程的虚拟空间中
+ *
+ * @param shmid 共享内存段标识
+ * @param addr 期望的挂接地址，为0时由内核选择
+ * @param flags SHM_RDONLY
+ * @return void* 挂接的起始地址，失败返回(void *)-1
+ */
+void *shmat(int shmid, void *addr, int flags) {
+  syscall_args_t args;
+  args.id = SYS_shmat;
+  args.arg0 = shmid;
+  args.arg1 = (uint32_t)addr;
+  args.arg2 = flags;
+
+  return (void *)sys_call(&args);
+}
+
+/**
+ * @brief 将挂接在addr处的共享内存段从进程中分离
+ *
+ * @param addr
+ * @return int
+ */
+int shmdt(void *addr) {
+  syscall_args_t args;
+  args.id = SYS_shmdt;
+  args.arg0 = (uint32_t)addr;
+
+  return sys_call(&args);
+}
+
+/**
+ * @brief 控制共享内存段，目前仅支持IPC_RMID
+ *
+ * @param shmid
+ * @param cmd
+ * @return int
+ */
+int shmctl(int shmid, int cmd) {
+  syscall_args_t args;
+  args.id = SYS_shmctl;
+  args.arg0 = shmid;
+  args.arg1 = cmd;
+
+  return sys_call(&args);
+}
+
+/**
+ * @brief 控制内核事件跟踪
+ *
+ * @param cmd TRACE_CMD_SET_MASK，TRACE_CMD_READ，TRACE_CMD_CLEAR
+ * @param arg0
+ * @param arg1
+ * @return int
+ */
+int trace_ctl(int cmd, int arg0, int arg1) {
+  syscall_args_t args;
+  args.id = SYS_trace;
+  args.arg0 = cmd;
+  args.arg1 = arg0;
+  args.arg2 = arg1;
+
+  return sys_call(&args);
+}
+
+/**
+ * @brief 控制内核采样分析
+ *
+ * @param cmd PROF_CMD_START，PROF_CMD_STOP，PROF_CMD_READ，PROF_CMD_READ_TASKS，
+ *            PROF_CMD_DROPPED
+ * @param arg0
+ * @param arg1
+ * @return int
+ */
+int prof_ctl(int cmd, int arg0, int arg1) {
+  syscall_args_t args;
+  args.id = SYS_prof;
+  args.arg0 = cmd;
+  args.arg1 = arg0;
+  args.arg2 = arg1;
+
+  return sys_call(&args);
+}
+
+/**
+ * @brief 读取或清空内核锁竞争统计
+ *
+ * @param cmd LOCK_STAT_CMD_READ，LOCK_STAT_CMD_CLEAR
+ * @param arg0
+ * @param arg1
+ * @return int
+ */
+int lock_stat_ctl(int cmd, int arg0, int arg1) {
+  syscall_args_t args;
+  args.id = SYS_lock_stat;
+  args.arg0 = cmd;
+  args.arg1 = arg0;
+  args.arg2 = arg1;
+
+  return sys_call(&args);
+}
+
+/**
+ * @brief 读取或清空内核中断统计
+ *
+ * @param cmd IRQ_STAT_CMD_READ，IRQ_STAT_CMD_CLEAR
+ * @param stats
+ * @return int
+ */
+int irq_stat_ctl(int cmd, irq_stats_t *stats) {
+  syscall_args_t args;
+  args.id = SYS_irq_stat;
+  args.arg0 = cmd;
+  args.arg1 = (int)stats;
+
+  return sys_call(&args);
+}
+
+/**
+ * @brief 在内核中对比内存函数的汇编实现与逐字节实现的耗时
+ *
+ * @param bench 填写size、offset与loops，返回时包含各函数的总耗时
+ * @return int
+ */
+int klib_bench(klib_bench_t *bench) {
+  syscall_args_t args;
+  args.id = SYS_klib_bench;
+  args.arg0 = (int)bench;
+
+  return sys_call(&args);
+}
+
+/**
+ * @brief 获取时钟的当前时间，分辨率为定时器的分辨率
+ *
+ * @param clock_id CLOCK_REALTIME或CLOCK_MONOTONIC，没有实时时钟，二者都为系统启动后经过的时间
+ * @param tp
+ * @return int
+ */
+int clock_gettime(clockid_t clock_id, struct timespec *tp) {
+  syscall_args_t args;
+  args.id = SYS_clock_gettime;
+  args.arg0 = (int)clock_id;
+  args.arg1 = (int)tp;
+
+  return sys_call(&args);
+}
+
+/**
+ * @brief 提供给newlib的gettimeofday与time
+ *
+ * @param tv
+ * @param tz 忽略
+ * @return int
+ */
+int _gettimeofday(struct timeval *tv, void *tz) {
+  syscall_args_t args;
+  args.id = SYS_gettimeofday;
+  args.arg0 = (int)tv;
+  args.arg1 = (int)tz;
+
+  return sys_call(&args);
+}
+
+/**
+ * @brief 从时间页读取单调时间，不进入内核，分辨率为一个时间片
+ *        读取期间时间页可能被时钟中断更新，读取前后序号不同或序号为奇数时重新读取
+ *
+ * @param tp
+ * @return int
+ */
+int clock_gettime_coarse(struct timespec *tp) {
+  const clock_page_t *page = (const clock_page_t *)CLOCK_PAGE_ADDR;
+
+  uint32_t seq, sec, usec;
+  do {
+    seq = page->seq;
+    __asm__ __volatile__("" ::: "memory");
+    sec = page->sec;
+    usec = page->usec;
+    __asm__ __volatile__("" ::: "memory");
+  } while ((seq & 1) || seq != page->seq);
+
+  tp->tv_sec = sec;
+  tp->tv_nsec = usec * 1000;
+  return 0;
+}
+
+/**
+ * @brief 获取或设置文件的打开标志，只支持F_GETFL与F_SETFL
+ *
+ * @param file
+ * @param cmd
+ * @param ... F_SETFL时为新的打开标志
+ * @return int
+ */
+int fcntl(int file, int cmd, ...) {
+  va_list ap;
+  va_start(ap, cmd);
+  int arg = va_arg(ap, int);
+  va_end(ap);
+
+  syscall_args_t args;
+  args.id = SYS_fcntl;
+  args.arg0 = file;
+  args.arg1 = cmd;
+  args.arg2 = arg;
+
+  return sys_call(&args);
+}
+
+/**
+ * @brief 等待一组文件中任一文件可读写
+ *
+ * @param fds
+ * @param nfds 不超过POLL_FD_MAX
+ * @param timeout 超时时间，单位毫秒，为0时不等待，为负数时一直等待
+ * @return int 有事件发生的文件数，超时为0
+ */
+int poll(struct pollfd *fds, int nfds, int timeout) {
+  syscall_args_t args;
+  args.id = SYS_poll;
+  args.arg0 = (uint32_t)fds;
+  args.arg1 = nfds;
+  args.arg2 = timeout;
+
+  return sys_call(&args);
+}
+
+/**
+ * @brief 通过poll实现的select，最多等待POLL_FD_MAX个文件，exceptfds总是被清空
+ *
+ * @param nfds
+ * @param readfds
+ * @param writefds
+ * @param exceptfds
+ * @param timeout 为0时一直等待
+ * @return int 就绪的文件在各集合中的总数，失败为-1
+ */
+int select(int nfds, fd_set *readfds, fd_set *writefds, fd_set *exceptfds,
+           struct timeval *timeout) {
+  // 1.将集合转换为poll的等待项
+  struct pollfd fds[POLL_FD_MAX];
+  int count = 0;
+  for (int fd = 0; fd < nfds; ++fd) {
+    short events = 0;
+    if (readfds && FD_ISSET(fd, readfds)) {
+      events |= POLLIN;
+    }
+    if (writefds && FD_ISSET(fd, writefds)) {
+      events |= POLLOUT;
+    }
+    if (!events) {
+      continue;
+    }
+
+    if (count >= POLL_FD_MAX) {
+      return -1;
+    }
+    fds[count].fd = fd;
+    fds[count].events = events;
+    count++;
+  }
+
+  int ms = timeout ? timeout->tv_sec * 1000 + timeout->tv_usec / 1000 : -1;
+  if (poll(fds, count, ms) < 0) {
+    return -1;
+  }
+
+  // 2.集合中只保留已就绪的文件
+  if (readfds) {
+    FD_ZERO(readfds);
+  }
+  if (writefds) {
+    FD_ZERO(writefds);
+  }
+  if (exceptfds) {
+    FD_ZERO(exceptfds);
+  }
+
+  int ready = 0;
+  for (int i = 0; i < count; ++i) {
+    short revents = fds[i].revents;
+    if (revents & POLLNVAL) {
+      return -1;
+    }
+
+    if ((fds[i].events & POLLIN) && (revents & (POLLIN | POLLERR | POLLHUP))) {
+      FD_SET(fds[i].fd, readfds);
+      ready++;
+    }
+    if ((fds[i].events & POLLOUT) && (revents & (POLLOUT | POLLERR))) {
+      FD_SET(fds[i].fd, writefds);
+      ready++;
+    }
+  }
+
+  return ready;
+}
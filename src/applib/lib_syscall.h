@@ -13,10 +13,21 @@
 #define LIB_SYSCALL_H
 
 #include <sys/stat.h>
+#include <sys/time.h>
+#include <time.h>
 
 #include "common/os_config.h"
 #include "common/types.h"
+#include "core/clock.h"
+#include "core/irq.h"
+#include "core/klib_bench.h"
+#include "core/mmap.h"
+#include "core/prof.h"
+#include "core/trace.h"
 #include "core/tty.h"
+#include "fs/poll.h"
+#include "ipc/lock_stat.h"
+#include "ipc/shm.h"
 
 #pragma pack(1)
 /**
@@ -88,4 +99,36 @@ int closedir(DIR *dir);
 int memory_use_stat(char *buf, int size);
 int task_use_stat(char *buf, int size, int *task_count);
 
+// 文件映射的系统调用
+void *mmap(void *addr, uint32_t length, int prot, int flags, int fd,
+           uint32_t offset);
+int munmap(void *addr, uint32_t length);
+
+// 共享内存的系统调用
+int shmget(int key, uint32_t size, int flags);
+void *shmat(int shmid, void *addr, int flags);
+int shmdt(void *addr);
+int shmctl(int shmid, int cmd);
+
+// 内核事件跟踪的系统调用
+int trace_ctl(int cmd, int arg0, int arg1);
+int prof_ctl(int cmd, int arg0, int arg1);
+int lock_stat_ctl(int cmd, int arg0, int arg1);
+int irq_stat_ctl(int cmd, irq_stats_t *stats);
+int klib_bench(klib_bench_t *bench);
+
+// 时钟相关的系统调用，newlib未开启_POSIX_MONOTONIC_CLOCK时补充单调时钟的编号
+#ifndef CLOCK_MONOTONIC
+#define CLOCK_MONOTONIC (clockid_t)CLOCK_ID_MONOTONIC
+#endif
+int clock_gettime(clockid_t clock_id, struct timespec *tp);
+int _gettimeofday(struct timeval *tv, void *tz);
+int clock_gettime_coarse(struct timespec *tp);
+
+// 文件多路等待的系统调用，select基于poll实现，不支持exceptfds
+int fcntl(int file, int cmd, ...);
+int poll(struct pollfd *fds, int nfds, int timeout);
+int select(int nfds, fd_set *readfds, fd_set *writefds, fd_set *exceptfds,
+           struct timeval *timeout);
+
 #endif
\ No newline at end of file
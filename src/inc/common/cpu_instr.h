@@ -3,6 +3,8 @@
 
 #include "common/types.h"
 
+#define CPU_CACHE_LINE_SIZE 32  // ARM920T的数据cache行大小
+
 __attribute__((always_inline)) static uint32_t cpu_get_cpser(void) {
   uint32_t ret = 0;
 
@@ -174,6 +176,50 @@ __attribute__((always_inline)) static void disable_tlb() {
       : "r0");
 }
 
+/**
+ * @brief 写入cr8，使虚拟地址vaddr对应的tlb项无效
+ *
+ * @param vaddr
+ */
+__attribute__((always_inline)) static void disable_tlb_entry(uint32_t vaddr) {
+  __asm__ __volatile__("mcr p15, 0, %[vaddr], c8, c7, 1\n"
+                       :
+                       : [vaddr] "r"(vaddr)
+                       : "memory");
+}
+
+/**
+ * @brief 排空写缓冲区，保证之前的写操作都已到达内存，DMA读取内存前调用
+ *
+ */
+__attribute__((always_inline)) static void drain_write_buffer() {
+  __asm__ __volatile__(
+      "mov r0, #0\n"
+      "mcr p15, 0, r0, c7, c10, 4\n"
+      :
+      :
+      : "r0", "memory");
+}
+
+/**
+ * @brief 使[start, start + size)范围内的数据cache行无效，DMA写入内存后调用
+ *        内核空间为写通cache，无效化不会丢失数据
+ *
+ * @param start
+ * @param size
+ */
+__attribute__((always_inline)) static void disable_dcache_range(uint32_t start,
+                                                                uint32_t size) {
+  uint32_t end = start + size;
+  for (start &= ~(CPU_CACHE_LINE_SIZE - 1); start < end;
+       start += CPU_CACHE_LINE_SIZE) {
+    __asm__ __volatile__("mcr p15, 0, %[mva], c7, c6, 1\n"
+                         :
+                         : [mva] "r"(start)
+                         : "memory");
+  }
+}
+
 /**
  * @brief 清空数据cache并使无效指令和数据cache
  *
@@ -37,6 +37,8 @@
 #define EXCEPTION_DATA_ABORT 4
 #define EXCEPTION_IRQ 5
 #define EXCEPTION_FIQ 6
+// 异常入口保存上下文时访问到内核栈的保护页，即内核栈溢出
+#define EXCEPTION_STACK_OVERFLOW 7
 
 // 内核堆栈配置
 #define STACK_SVC_SIZE 0x4000
@@ -51,8 +53,39 @@
 #define TASK_TIME_SLICE_MS 10  // ms，最大支持1.3107s
 
 #define TASK_SVC_STACK_SIZE (2 * 1024)
+// 是否在任务内核栈下方放置一页不映射的保护页，1：放置，0：不放置
+#define TASK_SVC_STACK_GUARD 1
 #define TASK_USER_STACK_SIZE (2 * 1024 * 1024)
 
+// 内核日志环形缓冲区的大小，必须为2的幂
+#define LOG_BUF_SIZE (16 * 1024)
+
+// 是否编译内核事件跟踪点，1：编译，0：不编译
+#define TRACE_ENABLE 1
+// 事件跟踪环形缓冲区可容纳的记录数
+#define TRACE_BUF_COUNT 2048
+
+// 采样分析的采样周期，不是时间片长度的约数，避免与时钟中断同步而总在同一相位采样
+#define PROF_SAMPLE_PERIOD_US 970
+// 采样分析可保存的样本数
+#define PROF_SAMPLE_COUNT 8192
+
+// 是否统计互斥锁与信号量的竞争情况，1：统计，0：不统计
+#define LOCK_STAT_ENABLE 1
+// 可注册的锁名称数量，同名的锁合并统计
+#define LOCK_STAT_COUNT 32
+
+// 是否统计每个中断源的次数、处理时间与进入延迟，1：统计，0：不统计
+#define IRQ_STAT_ENABLE 1
+
+// 是否在启动时将中断、系统调用与任务切换的关键路径锁定到cache与tlb中，1：锁定，0：不锁定
+#define CACHE_LOCKDOWN_ENABLE 1
+
+// 是否记录内核空间每次分配页的调用位置，用于查找内存泄漏，1：记录，0：不记录
+#define MEM_TRACE_ENABLE 0
+// 可同时记录的未释放的分配次数
+#define MEM_TRACE_COUNT 128
+
 // 定义操作系统版本
 #define OS_VERSION "0.1"
 
@@ -323,6 +323,18 @@
 
 
 
+// DMA，4个通道的寄存器组依次间隔0x40
+#define DMA_CHANNEL_BASE(ch) (0x4b000000 + (ch) * 0x40)
+#define rDISRC(ch) (*(volatile unsigned *)(DMA_CHANNEL_BASE(ch) + 0x00))     // DMA initial source
+#define rDISRCC(ch) (*(volatile unsigned *)(DMA_CHANNEL_BASE(ch) + 0x04))    // DMA initial source control
+#define rDIDST(ch) (*(volatile unsigned *)(DMA_CHANNEL_BASE(ch) + 0x08))     // DMA initial destination
+#define rDIDSTC(ch) (*(volatile unsigned *)(DMA_CHANNEL_BASE(ch) + 0x0c))    // DMA initial destination control
+#define rDCON(ch) (*(volatile unsigned *)(DMA_CHANNEL_BASE(ch) + 0x10))      // DMA control
+#define rDSTAT(ch) (*(volatile unsigned *)(DMA_CHANNEL_BASE(ch) + 0x14))     // DMA status
+#define rDCSRC(ch) (*(volatile unsigned *)(DMA_CHANNEL_BASE(ch) + 0x18))     // DMA current source
+#define rDCDST(ch) (*(volatile unsigned *)(DMA_CHANNEL_BASE(ch) + 0x1c))     // DMA current destination
+#define rDMASKTRIG(ch) (*(volatile unsigned *)(DMA_CHANNEL_BASE(ch) + 0x20)) // DMA mask/trigger
+
 // SD Interface
 #define rSDICON     (*(volatile unsigned *)0x5a000000)	//SDI control
 #define rSDIPRE     (*(volatile unsigned *)0x5a000004)	//SDI baud rate prescaler
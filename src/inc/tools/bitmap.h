@@ -14,20 +14,33 @@
 
 #include "common/types.h"
 
+// 位图数组按字存储，计算count个位所需的字数
+#define BITMAP_WORDS(count) (((count) + 31) / 32)
+// 第二级摘要每一位对应位图数组中的一个字
+#define BITMAP_SUMMARY_WORDS(count) ((BITMAP_WORDS(count) + 31) / 32)
+// 位图数组与摘要所需的总字节数，可用于静态分配位图数组
+#define BITMAP_BYTES(count) \
+  ((BITMAP_WORDS(count) + BITMAP_SUMMARY_WORDS(count)) * 4)
+
 /**
  * @brief  位图数据结构
  * @param bit_count 位图对象管理的内存的分页数量
  * @param bits 位图数组，记录某一页是否被分配
  */
 typedef struct _bitmap_t {
-  uint32_t bit_count;  // 位图管理的bit数量
-  uint8_t *bits;       // 位图管理的内存空间起始地址
+  uint32_t bit_count;   // 位图管理的bit数量
+  uint32_t word_count;  // 位图数组的字数
+  uint32_t *bits;       // 位图管理的内存空间起始地址
+  uint32_t *summary;    // 第二级摘要，第i位为1表示第i个字中存在值为0的位
+  uint32_t hint;        // 下次适应的起始字索引，即上次分配结束的位置
+  uint32_t set_count;   // 值为1的位的数量
 } bitmap_t;
 
 void bitmap_init(bitmap_t *bitmap, uint8_t *bits, uint32_t count, int init_bit);
 uint8_t bitmap_get_bit(bitmap_t *bitmap, int index);
 void bitmap_set_bit(bitmap_t *bitmap, int index, uint32_t count, int bit);
 int bitmap_is_set(bitmap_t *bitmap, int index);
+uint32_t bitmap_count_set(bitmap_t *bitmap);
 int bitmap_alloc_nbits(bitmap_t *bitmap, int bit, uint32_t count);
 int bitmap_alloc_nbits_align(bitmap_t *bitmap, int bit, uint32_t count,
                              int align);
@@ -0,0 +1,89 @@
+/**
+ * @file hash.h
+ * @author kbpoyo (kbpoyo@qq.com)
+ * @brief  定义侵入式哈希表，冲突的节点以单链表串在同一个桶中
+ * @version 0.1
+ * @date 2023-09-15
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#ifndef HASH_H
+#define HASH_H
+
+#include "common/types.h"
+#include "tools/list.h"
+
+// 平均每个桶中的节点数超过该值时应扩容
+#define HASH_LOAD_FACTOR 2
+
+// 哈希表节点，嵌入到所属结构体中
+typedef struct _hash_node_t {
+  struct _hash_node_t *next;  // 同一个桶中的下一个节点
+  uint32_t key;               // 节点的键值
+} hash_node_t;
+
+// 哈希表，桶的存储空间由使用者提供，桶数必须为2的幂
+typedef struct _hash_table_t {
+  hash_node_t **buckets;  // 桶数组
+  uint32_t bucket_count;  // 桶数
+  uint32_t size;          // 节点数
+} hash_table_t;
+
+/**
+ * @brief  获取哈希表中的节点数
+ *
+ * @param table
+ * @return uint32_t
+ */
+static inline uint32_t hash_size(hash_table_t *table) { return table->size; }
+
+/**
+ * @brief  判断哈希表的负载是否已超过HASH_LOAD_FACTOR，需要扩容
+ *
+ * @param table
+ * @return int
+ */
+static inline int hash_need_grow(hash_table_t *table) {
+  return table->size > table->bucket_count * HASH_LOAD_FACTOR;
+}
+
+/**
+ * @brief  对32位整数做混合，使相近的键值分散到不同的桶中
+ *
+ * @param key
+ * @return uint32_t
+ */
+static inline uint32_t hash_u32(uint32_t key) {
+  key ^= key >> 16;
+  key *= 0x7feb352d;
+  key ^= key >> 15;
+  key *= 0x846ca68b;
+  key ^= key >> 16;
+  return key;
+}
+
+uint32_t hash_string(const char *str);
+uint32_t hash_mem(const void *buf, int size);
+
+void hash_init(hash_table_t *table, hash_node_t **buckets,
+               uint32_t bucket_count);
+void hash_insert(hash_table_t *table, hash_node_t *node, uint32_t key);
+hash_node_t *hash_remove(hash_table_t *table, hash_node_t *node);
+hash_node_t *hash_find(hash_table_t *table, uint32_t key);
+hash_node_t *hash_find_next(hash_node_t *node);
+hash_node_t **hash_resize(hash_table_t *table, hash_node_t **buckets,
+                          uint32_t bucket_count);
+
+/**
+ * @brief  得到哈希表节点所属结构体的指针
+ *
+ * @param node 当前node类型的变量名
+ * @param parnet_type 所属结构体的类型
+ * @param node_name node类型在所属结构体中的变量名
+ */
+#define hash_node_parent(node, parent_type, node_name) \
+  list_node_parent(node, parent_type, node_name)
+
+#endif
@@ -13,4 +13,7 @@
 void log_init();
 void log_printf(const char *fmt, ...);
 void log_error(const char *fmt, ...);
+int log_tx_byte(char *c);
+void log_flush(void);
+int log_read(char *buf, int size);
 #endif
\ No newline at end of file
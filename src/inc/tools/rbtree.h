@@ -0,0 +1,83 @@
+/**
+ * @file rbtree.h
+ * @author kbpoyo (kbpoyo@qq.com)
+ * @brief  定义侵入式红黑树
+ * @version 0.1
+ * @date 2023-09-15
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#ifndef RBTREE_H
+#define RBTREE_H
+
+#include "common/types.h"
+#include "tools/list.h"
+
+#define RBTREE_RED 0
+#define RBTREE_BLACK 1
+
+// 红黑树节点，嵌入到所属结构体中
+typedef struct _rbtree_node_t {
+  struct _rbtree_node_t *parent;
+  struct _rbtree_node_t *left;
+  struct _rbtree_node_t *right;
+  int color;
+} rbtree_node_t;
+
+// 比较两个节点，a < b：返回负数，a == b：返回0，a > b：返回正数
+typedef int (*rbtree_cmp_t)(rbtree_node_t *a, rbtree_node_t *b);
+
+// 比较键值与节点，返回值的含义同上
+typedef int (*rbtree_key_cmp_t)(const void *key, rbtree_node_t *node);
+
+// 红黑树
+typedef struct _rbtree_t {
+  rbtree_node_t *root;
+  rbtree_cmp_t cmp;  // 插入时使用的节点比较函数
+  int size;          // 节点数
+} rbtree_t;
+
+/**
+ * @brief  初始化红黑树
+ *
+ * @param tree
+ * @param cmp 节点比较函数
+ */
+static inline void rbtree_init(rbtree_t *tree, rbtree_cmp_t cmp) {
+  tree->root = (rbtree_node_t *)0;
+  tree->cmp = cmp;
+  tree->size = 0;
+}
+
+/**
+ * @brief  获取红黑树中的节点数
+ *
+ * @param tree
+ * @return int
+ */
+static inline int rbtree_size(rbtree_t *tree) { return tree->size; }
+
+void rbtree_insert(rbtree_t *tree, rbtree_node_t *node);
+void rbtree_remove(rbtree_t *tree, rbtree_node_t *node);
+rbtree_node_t *rbtree_find(rbtree_t *tree, const void *key,
+                           rbtree_key_cmp_t key_cmp);
+rbtree_node_t *rbtree_lower_bound(rbtree_t *tree, const void *key,
+                                  rbtree_key_cmp_t key_cmp);
+rbtree_node_t *rbtree_first(rbtree_t *tree);
+rbtree_node_t *rbtree_last(rbtree_t *tree);
+rbtree_node_t *rbtree_next(rbtree_node_t *node);
+rbtree_node_t *rbtree_prev(rbtree_node_t *node);
+
+/**
+ * @brief  得到红黑树节点所属结构体的指针
+ *
+ * @param node 当前node类型的变量名
+ * @param parnet_type 所属结构体的类型
+ * @param node_name node类型在所属结构体中的变量名
+ */
+#define rbtree_node_parent(node, parent_type, node_name) \
+  list_node_parent(node, parent_type, node_name)
+
+#endif
@@ -0,0 +1,55 @@
+/**
+ * @file ring.h
+ * @author kbpoyo (kbpoyo@qq.com)
+ * @brief  单生产者单消费者的无锁环形缓冲区
+ * @version 0.1
+ * @date 2023-09-14
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#ifndef RING_H
+#define RING_H
+
+#include "common/types.h"
+
+/**
+ * @brief  环形缓冲区，缓冲区大小必须为2的幂
+ *         head只由生产者修改，tail只由消费者修改，二者均单调递增，
+ *         通过与mask相与得到实际位置，因此生产者与消费者之间无需加锁或关中断
+ */
+typedef struct _ring_t {
+  uint8_t *buf;             // 缓冲区起始地址
+  uint32_t mask;            // 缓冲区大小 - 1
+  volatile uint32_t head;   // 写入位置，只由生产者修改
+  volatile uint32_t tail;   // 读取位置，只由消费者修改
+} ring_t;
+
+/**
+ * @brief  获取环形缓冲区中未读数据的字节数
+ *
+ * @param ring
+ * @return uint32_t
+ */
+static inline uint32_t ring_count(ring_t *ring) {
+  return ring->head - ring->tail;
+}
+
+/**
+ * @brief  获取环形缓冲区中可写入的字节数
+ *
+ * @param ring
+ * @return uint32_t
+ */
+static inline uint32_t ring_free(ring_t *ring) {
+  return ring->mask + 1 - (ring->head - ring->tail);
+}
+
+void ring_init(ring_t *ring, uint8_t *buf, uint32_t size);
+int ring_put(ring_t *ring, uint8_t c);
+int ring_get(ring_t *ring, uint8_t *c);
+uint32_t ring_put_bulk(ring_t *ring, const uint8_t *buf, uint32_t size);
+uint32_t ring_get_bulk(ring_t *ring, uint8_t *buf, uint32_t size);
+
+#endif
@@ -0,0 +1,117 @@
+/**
+ * @file clock.c
+ * @author kbpoyo (kbpoyo@qq.com)
+ * @brief 单调时钟，由时间片数与定时器4的计数组合出微秒分辨率的时间
+ *        时间页在每个时间片更新一次，映射到所有进程中，用户程序无需系统调用即可读取
+ *        开发板没有使用实时时钟，实时时间即系统启动后经过的时间
+ * @version 0.1
+ * @date 2023-09-21
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#include "core/clock.h"
+
+#include "common/os_config.h"
+#include "core/mmap.h"
+#include "core/mmu.h"
+#include "dev/timer.h"
+#include "tools/klib.h"
+
+// 每个时间片的微秒数与每秒的时间片数
+#define CLOCK_TICK_US (TASK_TIME_SLICE_MS * 1000)
+#define CLOCK_TICKS_PER_SEC (1000 / TASK_TIME_SLICE_MS)
+
+// 时间页的物理空间，在create_kernal_table中映射到CLOCK_PAGE_ADDR，
+// 内核也只通过CLOCK_PAGE_ADDR访问，避免虚拟cache中出现同一物理页的两个别名
+uint8_t clock_page_buf[MEM_PAGE_SIZE]
+    __attribute__((section(".data"), aligned(MEM_PAGE_SIZE)));
+
+static clock_page_t *const clock_page = (clock_page_t *)CLOCK_PAGE_ADDR;
+
+/**
+ * @brief 初始化时间页，需在开启mmu后调用
+ *
+ */
+void clock_init(void) {
+  kernel_memset((void *)clock_page, 0, MEM_PAGE_SIZE);
+  clock_page->tick_us = CLOCK_TICK_US;
+}
+
+/**
+ * @brief 更新时间页，由时钟中断处理函数在每个时间片调用一次
+ *
+ * @param tick 当前的时间片数
+ */
+void clock_tick(uint32_t tick) {
+  // 用户程序不会打断中断处理函数，只需保证序号与内容的写入顺序
+  clock_page->seq++;
+  __asm__ __volatile__("" ::: "memory");
+
+  clock_page->tick = tick;
+  clock_page->usec += CLOCK_TICK_US;
+  if (clock_page->usec >= 1000000) {
+    clock_page->usec -= 1000000;
+    clock_page->sec++;
+  }
+
+  __asm__ __volatile__("" ::: "memory");
+  clock_page->seq++;
+}
+
+/**
+ * @brief 获取系统启动后经过的单调时间，分辨率为定时器的分辨率
+ *
+ * @param time
+ */
+void clock_monotonic(clock_time_t *time) {
+  uint32_t tick, elapsed_us;
+  timer_get_tick(&tick, &elapsed_us);
+
+  uint32_t sec = tick / CLOCK_TICKS_PER_SEC;
+  uint32_t usec = (tick % CLOCK_TICKS_PER_SEC) * CLOCK_TICK_US + elapsed_us;
+  if (usec >= 1000000) {
+    usec -= 1000000;
+    sec++;
+  }
+
+  time->sec = sec;
+  time->nsec = usec * 1000;
+}
+
+/**
+ * @brief 获取时钟的当前时间
+ *
+ * @param clock_id
+ * @param time 用户空间中的struct timespec
+ * @return int 0：成功，-1：不支持的时钟或参数错误
+ */
+int sys_clock_gettime(int clock_id, clock_time_t *time) {
+  if (!time ||
+      (clock_id != CLOCK_ID_REALTIME && clock_id != CLOCK_ID_MONOTONIC)) {
+    return -1;
+  }
+
+  clock_time_t now;
+  clock_monotonic(&now);
+  return copy_to_user(time, &now, sizeof(clock_time_t));
+}
+
+/**
+ * @brief 获取当前的实时时间，不支持时区
+ *
+ * @param tv 用户空间中的struct timeval，与clock_time_t布局一致，第二项为微秒
+ * @param tz 忽略
+ * @return int
+ */
+int sys_gettimeofday(clock_time_t *tv, void *tz) {
+  if (!tv) {
+    return -1;
+  }
+
+  clock_time_t now;
+  clock_monotonic(&now);
+  now.nsec /= 1000;
+  return copy_to_user(tv, &now, sizeof(clock_time_t));
+}
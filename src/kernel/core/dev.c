@@ -13,21 +13,15 @@
 
 #include "core/irq.h"
 #include "core/task.h"
+#include "fs/poll.h"
 #include "tools/klib.h"
+#include "tools/log.h"
 
 // 定义设备表大小
 #define DEV_TABLE_SIZE 128
 
-// 声明外部的disk设备描述结构
-extern dev_desc_t dev_disk_desc;
-// 声明外部的tty设备描述结构
-extern dev_desc_t dev_tty_desc;
-
-// 设备描述结构表，用来获取某一类型设备的操作方法
-static dev_desc_t *dev_des_table[] = {
-    [DEV_TTY] = &dev_tty_desc,
-    [DEV_DISK] = &dev_disk_desc,
-};
+// 设备描述结构表，用来获取某一类型设备的操作方法，由各驱动初始化时注册
+static dev_desc_t *dev_des_table[DEV_TYPE_COUNT];
 
 // 设备表，用于获取特定设备
 static device_t dev_table[DEV_TABLE_SIZE]
@@ -54,6 +48,30 @@ static int is_dev_exist(int dev_id) {
   return 1;
 }
 
+/**
+ * @brief 注册一种设备类型的描述结构，由驱动在初始化时调用
+ *
+ * @param dev_type 设备类型
+ * @param desc 设备描述结构
+ * @return int 0：成功，-1：类型无效或已注册
+ */
+int dev_register(int dev_type, dev_desc_t *desc) {
+  if (dev_type <= DEV_UNKNOWN || dev_type >= DEV_TYPE_COUNT || !desc) {
+    return -1;
+  }
+
+  cpu_state_t state = task_enter_protection();
+  if (dev_des_table[dev_type]) {
+    task_leave_protection(state);
+    log_printf("device type %d already registered\n", dev_type);
+    return -1;
+  }
+
+  dev_des_table[dev_type] = desc;
+  task_leave_protection(state);
+  return 0;
+}
+
 /**
  * @brief 打开一个设备
  *
@@ -86,8 +104,8 @@ int dev_open(int dev_type, int dev_index, void *data) {
   }
 
   // 3.设备描述结构存在，设备空间分配成功，进行设备的初始化
-  if (free_dev && dev_type > DEV_UNKNOWN &&
-      dev_type < sizeof(dev_des_table) / sizeof(dev_des_table[0])) {
+  if (free_dev && dev_type > DEV_UNKNOWN && dev_type < DEV_TYPE_COUNT &&
+      dev_des_table[dev_type]) {
     free_dev->dev_type = dev_type;
     free_dev->desc = dev_des_table[dev_type];
     free_dev->data = data;
@@ -169,6 +187,27 @@ int dev_control(int dev_id, int cmd, int arg0, int arg1) {
   return dev->desc->control(dev, cmd, arg0, arg1);
 }
 
+/**
+ * @brief 获取设备当前的可读写状态
+ *
+ * @param dev_id 设备描述符
+ * @param entry 不为0时加入设备的等待队列，设备状态变化时被唤醒
+ * @return int POLLIN等事件的组合
+ */
+int dev_poll(int dev_id, struct _wait_entry_t *entry) {
+  if (!is_dev_exist(dev_id)) {
+    return POLLNVAL;
+  }
+
+  // 没有实现poll的设备读写都不会阻塞，总是可读写
+  device_t *dev = dev_table + dev_id;
+  if (!dev->desc->poll) {
+    return POLLIN | POLLOUT;
+  }
+
+  return dev->desc->poll(dev, entry);
+}
+
 /**
  * @brief 关闭设备
  *
@@ -14,13 +14,17 @@
 #include "common/boot_info.h"
 #include "common/cpu_instr.h"
 #include "core/irq.h"
+#include "core/trace.h"
 #include "dev/nandflash.h"
+#include "fs/devfs/devfs.h"
 #include "tools/klib.h"
 #include "tools/log.h"
 
 // 外部磁盘操作函数表
 extern disk_opt_t sd_opt;
 extern disk_opt_t nand_opt;
+// 磁盘设备的函数表，定义在文件末尾
+extern dev_desc_t dev_disk_desc;
 
 // 系统磁盘表
 static disk_t disk_table[DISK_CNT]
@@ -147,12 +151,64 @@ void disk_init(void) {
     kernel_sprintf(disk->name, "sd-%c", i + 'a');
     // 初始化磁盘锁与操作信号量
     mutex_init(&(disk->mutex));
+    mutex_set_name(&(disk->mutex), "disk");
 
     int err = identify_disk(disk);
     if (err == 0) {
       print_disk_info(disk);
     }
   }
+
+  // 向设备管理层注册磁盘设备，并为每个分区发布块设备文件
+  dev_register(DEV_DISK, &dev_disk_desc);
+  for (int i = 0; i < DISK_CNT; ++i) {
+    disk_t *disk = disk_table + i;
+    if (disk->sector_count == 0) {
+      continue;
+    }
+
+    // 0分区包含整个磁盘，设备文件为sda，其余分区为sda1、sda2...
+    for (int j = 0; j < DISK_PRIMARY_PART_CNT; ++j) {
+      if (!disk->partinfo[j].disk) {
+        continue;
+      }
+
+      char name[DEVFS_NAME_SIZE];
+      if (j == 0) {
+        kernel_sprintf(name, "sd%c", i + 'a');
+      } else {
+        kernel_sprintf(name, "sd%c%d", i + 'a', j);
+      }
+      devfs_register(name, DEV_DISK, ((i + 0xa) << 4) | j, FILE_BLOCK);
+    }
+  }
+}
+
+/**
+ * @brief 查找第一个类型为type的分区
+ *
+ * @param type 分区类型
+ * @param dev_index 返回该分区对应的设备索引编号，如0xa2
+ * @return partinfo_t* 0：不存在该类型的分区
+ */
+partinfo_t *disk_find_part(int type, int *dev_index) {
+  for (int i = 0; i < DISK_CNT; ++i) {
+    disk_t *disk = disk_table + i;
+    if (disk->sector_count == 0) {
+      continue;
+    }
+
+    // 0分区包含整个磁盘，不参与查找
+    for (int j = 1; j < DISK_PRIMARY_PART_CNT; ++j) {
+      partinfo_t *part_info = disk->partinfo + j;
+      if (part_info->disk && part_info->type == type) {
+        *dev_index = ((i + 0xa) << 4) | j;
+        return part_info;
+      }
+    }
+  }
+
+  return (partinfo_t *)0;
 }
 
 /**
@@ -194,6 +250,30 @@ int disk_open(device_t *dev) {
   dev->data = (void *)part_info;
   return 0;
 }
+/**
+ * @brief 将从分区内偏移addr开始的size个扇区的读写范围限制在分区内
+ *
+ * @param part_info 分区信息
+ * @param addr 起始扇区相对于分区的偏移量
+ * @param size 扇区数
+ * @return int 可读写的扇区数，参数非法时返回-1，起始扇区超出分区时返回0
+ */
+static int disk_clamp(partinfo_t *part_info, int addr, int size) {
+  if (addr < 0 || size < 0) {
+    return -1;
+  }
+
+  if (addr >= part_info->total_sectors) {
+    return 0;
+  }
+
+  if (size > part_info->total_sectors - addr) {
+    size = part_info->total_sectors - addr;
+  }
+
+  return size;
+}
+
 /**
  * @brief 读磁盘
  *
@@ -218,10 +298,19 @@ int disk_read(device_t *dev, int addr, char *buf, int size) {
     return -1;
   }
 
+  // 将读取范围限制在分区内，起始扇区位于分区末尾及之后时返回0
+  size = disk_clamp(part_info, addr, size);
+  if (size <= 0) {
+    return size;
+  }
+
   // TODO:加锁
   mutex_lock(&(disk->mutex));  // 确保磁盘io操作的原子性
 
-  int cnt = disk_read_data(disk, part_info->start_sector + addr, buf, size);
+  uint32_t sector = part_info->start_sector + addr;
+  trace_event(TRACE_DISK_READ, sector, size);
+  int cnt = disk_read_data(disk, sector, buf, size);
+  trace_event(TRACE_DISK_DONE, sector, cnt);
   if (cnt < 0) {
     log_error("disk[%s] read error: start sector %d, count: %d", disk->name,
               addr, size);
@@ -258,10 +347,18 @@ int disk_write(device_t *dev, int addr, char *buf, int size) {
     return -1;
   }
 
+  // 将写入范围限制在分区内，避免越界写坏相邻分区
+  size = disk_clamp(part_info, addr, size);
+  if (size <= 0) {
+    return size;
+  }
+
   // TODO:加锁
   mutex_lock(&(disk->mutex));  // 确保磁盘io操作的原子性
-  //
-  int cnt = disk_write_data(disk, part_info->start_sector + addr, buf, size);
+  uint32_t sector = part_info->start_sector + addr;
+  trace_event(TRACE_DISK_WRITE, sector, size);
+  int cnt = disk_write_data(disk, sector, buf, size);
+  trace_event(TRACE_DISK_DONE, sector, cnt);
 
   if (cnt < 0) {
     log_error("disk[%s] read error: start sector %d, count: %d", disk->name,
@@ -293,6 +390,11 @@ int disk_control(device_t *dev, int cmd, int arg0, int arg1) {
   }
   disk_t *disk = part_info->disk;
 
+  // 扇区大小由磁盘结构记录，无需交给具体的磁盘驱动
+  if (cmd == DISK_CMD_SECTOR_SIZE) {
+    return disk->sector_size;
+  }
+
   return disk->opt->control(disk, cmd, arg0, arg1);
 }
 
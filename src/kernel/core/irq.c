@@ -1,11 +1,99 @@
 #include "core/irq.h"
 
 #include "common/types.h"
+#include "core/mmap.h"
+#include "core/softirq.h"
+#include "core/task.h"
+#include "core/trace.h"
+#include "dev/timer.h"
 #include "tools/assert.h"
+#include "tools/klib.h"
 #include "tools/log.h"
 
 static irq_handler_t irq_handler_call[IRQ_NUM_MAX];
 
+// 当前正在处理的中断所打断的指令地址与状态寄存器，中断不嵌套
+static uint32_t irq_pc, irq_spsr;
+
+// 伪中断次数
+static uint32_t irq_spurious;
+
+// 是否正在执行中断处理函数
+static int irq_in_handler;
+
+#if IRQ_STAT_ENABLE
+// 各中断源的名称，与中断偏移寄存器的值一一对应
+static const char *irq_name[IRQ_NUM_MAX] = {
+    "eint0",   "eint1",  "eint2",  "eint3",  "eint4_7", "eint8_23", "cam",
+    "batt",    "tick",   "wdt",    "timer0", "timer1",  "timer2",   "timer3",
+    "timer4",  "uart2",  "lcd",    "dma0",   "dma1",    "dma2",     "dma3",
+    "sdi",     "spi0",   "uart1",  "nfcon",  "usbd",    "usbh",     "iic",
+    "uart0",   "spi1",   "rtc",    "adc",
+};
+
+static irq_latency_t irq_latency_call[IRQ_NUM_MAX];
+static irq_stat_t irq_stat_table[IRQ_NUM_MAX];
+static uint32_t irq_stat_start;  // 清空统计的时间
+
+// 正在计时的中断源，-1：没有
+static int irq_curr = -1;
+static uint32_t irq_curr_start;
+
+/**
+ * @brief 将进入延迟计入直方图
+ *
+ * @param stat
+ * @param latency_us
+ */
+static void irq_stat_latency(irq_stat_t *stat, uint32_t latency_us) {
+  int bucket = 0;
+  uint32_t bound = IRQ_LAT_BUCKET0_US;
+  while (bucket < IRQ_LAT_BUCKETS - 1 && latency_us >= bound) {
+    bucket++;
+    bound <<= 1;
+  }
+
+  stat->latency[bucket]++;
+}
+
+/**
+ * @brief 结束当前中断处理函数的计时
+ *
+ */
+static void irq_stat_end(void) {
+  if (irq_curr < 0) {
+    return;
+  }
+
+  irq_stat_t *stat = irq_stat_table + irq_curr;
+  uint32_t time = timer_get_count() - irq_curr_start;
+  irq_curr = -1;
+
+  // 单次时间只有定时器的分辨率，总时间与平均时间在多次统计后是准确的
+  stat->count++;
+  stat->time_total += time;
+  if (time < stat->time_min) {
+    stat->time_min = time;
+  }
+  if (time > stat->time_max) {
+    stat->time_max = time;
+  }
+}
+
+/**
+ * @brief 清空所有中断源的统计
+ *
+ */
+static void irq_stat_clear(void) {
+  kernel_memset(irq_stat_table, 0, sizeof(irq_stat_table));
+  for (int i = 0; i < IRQ_NUM_MAX; ++i) {
+    irq_stat_table[i].time_min = 0xffffffff;
+  }
+  irq_spurious = 0;
+  irq_stat_start = timer_get_count();
+}
+#endif
+
 /**
  * @brief 使能某一中断
  *
@@ -107,13 +195,85 @@ void irq_clear_all() {
 /**
  * @brief 中断处理函数
  *
+ * @param pc 被中断的指令地址
+ * @param spsr 被中断时的状态寄存器
  */
-void irq_handler() {
+void irq_handler(uint32_t pc, uint32_t spsr) {
   int irq_num = rINTOFFSET;
+  irq_pc = pc;
+  irq_spsr = spsr;
 
+  irq_in_handler = 1;
+
+  // 1.没有挂起的中断，或中断源没有注册处理函数，屏蔽该中断源防止反复触发
+  if (rINTPND == 0 || irq_num >= IRQ_NUM_MAX || !irq_handler_call[irq_num]) {
+    irq_spurious++;
+    if (rINTPND && irq_num < IRQ_NUM_MAX) {
+      irq_disable(irq_num, NOSUBINT);
+      irq_clear(irq_num, NOSUBINT);
+      log_printf("spurious irq %d masked\n", irq_num);
+    }
+    irq_in_handler = 0;
+    return;
+  }
+
+  // 2.开始计时并测量进入延迟
+#if IRQ_STAT_ENABLE
+  irq_curr = irq_num;
+  irq_curr_start = timer_get_count();
+  if (irq_latency_call[irq_num]) {
+    irq_stat_latency(irq_stat_table + irq_num, irq_latency_call[irq_num]());
+  }
+#endif
+
+  trace_event(TRACE_IRQ_ENTER, irq_num, 0);
   irq_handler_call[irq_num]();
+  trace_event(TRACE_IRQ_EXIT, irq_num, 0);
+
+#if IRQ_STAT_ENABLE
+  irq_stat_end();
+#endif
+
+  irq_in_handler = 0;
+}
+
+/**
+ * @brief 判断当前是否处于中断上下文，即正在执行中断处理函数或下半部
+ *        中断上下文中不可进行任务切换
+ *
+ * @return int
+ */
+int irq_in_interrupt(void) { return irq_in_handler || softirq_in_progress(); }
+
+/**
+ * @brief 中断返回前调用，关中断时调用并返回
+ *        先打开中断执行下半部，再进行处理期间被推迟的任务切换，
+ *        下半部执行期间嵌套产生的中断不再重复执行，由外层的下半部继续处理
+ *
+ */
+void irq_exit(void) {
+  if (softirq_in_progress()) {
+    return;
+  }
+
+  softirq_run();
+  task_resched();
 }
 
+/**
+ * @brief 获取当前中断所打断的指令地址，只能在中断处理函数中调用
+ *
+ * @return uint32_t
+ */
+uint32_t irq_return_pc(void) { return irq_pc; }
+
+/**
+ * @brief 获取当前中断所打断的状态寄存器，只能在中断处理函数中调用
+ *
+ * @return uint32_t
+ */
+uint32_t irq_return_spsr(void) { return irq_spsr; }
+
 /**
  * @brief 为中断向量号注册中断函数
  *
@@ -126,6 +286,70 @@ void irq_handler_register(int irq_num, irq_handler_t handler_for_irq) {
   irq_handler_call[irq_num] = handler_for_irq;
 }
 
+/**
+ * @brief 为中断源注册进入延迟的测量函数
+ *
+ * @param irq_num
+ * @param latency
+ */
+void irq_latency_register(int irq_num, irq_latency_t latency) {
+  ASSERT(irq_num >= 0 && irq_num < IRQ_NUM_MAX);
+
+#if IRQ_STAT_ENABLE
+  irq_latency_call[irq_num] = latency;
+#endif
+}
+
+/**
+ * @brief 读取或清空中断统计
+ *
+ * @param cmd IRQ_STAT_CMD_READ，IRQ_STAT_CMD_CLEAR
+ * @param arg0
+ * @return int -1：失败
+ */
+int sys_irq_stat(int cmd, int arg0) {
+#if IRQ_STAT_ENABLE
+  switch (cmd) {
+    case IRQ_STAT_CMD_READ: {
+      irq_stats_t *stats = (irq_stats_t *)arg0;
+      // 用户缓冲区可能位于文件映射区，先使其成为可写的私有页
+      if (!stats ||
+          mmap_prepare_write((uint32_t)stats, sizeof(irq_stats_t)) < 0) {
+        return -1;
+      }
+
+      // 逐项在关中断时拷贝出一致的统计值，再写入用户缓冲区，写入时可能产生缺页
+      for (int i = 0; i < IRQ_NUM_MAX; ++i) {
+        irq_stat_t stat;
+        cpu_state_t state = task_enter_protection();
+        kernel_memcpy(&stat, irq_stat_table + i, sizeof(irq_stat_t));
+        task_leave_protection(state);
+
+        kernel_strncpy(stat.name, irq_name[i], IRQ_STAT_NAME_SIZE);
+        if (stat.count == 0) {
+          stat.time_min = 0;
+        }
+        kernel_memcpy(stats->irq + i, &stat, sizeof(irq_stat_t));
+      }
+
+      stats->spurious = irq_spurious;
+      stats->elapsed = timer_get_count() - irq_stat_start;
+      return 0;
+    }
+    case IRQ_STAT_CMD_CLEAR: {
+      cpu_state_t state = task_enter_protection();
+      irq_stat_clear();
+      task_leave_protection(state);
+      return 0;
+    }
+    default:
+      break;
+  }
+#endif
+
+  return -1;
+}
+
 /**
  * @brief 外部中断8-23的中断处理函数
  *
@@ -162,6 +386,10 @@ void irq_init() {
   rPRIORITY = 0x7f;
 
   irq_clear_all();
+#if IRQ_STAT_ENABLE
+  irq_stat_clear();
+#endif
+  softirq_init();
 
   irq_enable(EINT8_PRIM, EINT8_SUB);
   irq_enable(EINT11_PRIM, EINT11_SUB);
@@ -0,0 +1,152 @@
+/**
+ * @file klib_bench.c
+ * @author kbpoyo (kbpoyo@qq.com)
+ * @brief 内存拷贝、赋值与比较函数的基准测试，
+ *        保留klib.c中原有的逐字节实现作为对照，在内核中用定时器计数计时
+ * @version 0.1
+ * @date 2023-09-23
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#include "core/klib_bench.h"
+
+#include "core/memory.h"
+#include "core/mmap.h"
+#include "dev/timer.h"
+#include "tools/klib.h"
+
+// 防止比较结果未被使用而被优化掉
+static volatile int bench_sink;
+
+/**
+ * @brief 原逐字节的内存复制
+ *
+ */
+static void byte_memcpy(void *dest, const void *src, int size) {
+  if (!dest || !src || !size) return;
+
+  uint8_t *d = (uint8_t *)dest;
+  uint8_t *s = (uint8_t *)src;
+
+  while (size--) {
+    *(d++) = *(s++);
+  }
+}
+
+/**
+ * @brief 原逐字节的内存赋值
+ *
+ */
+static void byte_memset(void *dest, uint8_t v, int size) {
+  if (!dest || !size) return;
+
+  uint8_t *d = (uint8_t *)dest;
+
+  while (size--) {
+    *(d++) = v;
+  }
+}
+
+/**
+ * @brief 原逐字节的内存比较
+ *
+ */
+static int byte_memcmp(const void *dest1, const void *dest2, int size) {
+  if (!dest1 || !dest2 || !size) return 0;
+
+  uint8_t *d1 = (uint8_t *)dest1;
+  uint8_t *d2 = (uint8_t *)dest2;
+
+  while (--size && *d1 == *d2) {
+    d1++;
+    d2++;
+  }
+
+  if (*d1 > *d2)
+    return 1;
+  else if (*d1 < *d2)
+    return -1;
+  else
+    return 0;
+}
+
+/**
+ * @brief 对两块缓冲区运行一轮测试，结果写入内核中的bench结构
+ *
+ * @param bench
+ * @param dest 按字对齐的目的缓冲区
+ * @param src 已加上偏移的源缓冲区，内容与dest相同，使比较扫描全部字节
+ */
+static void bench_run(klib_bench_t *bench, uint8_t *dest, uint8_t *src) {
+  int size = bench->size;
+  uint32_t start;
+
+  start = timer_get_count();
+  for (uint32_t i = 0; i < bench->loops; ++i) kernel_memcpy(dest, src, size);
+  bench->asm_memcpy = timer_get_count() - start;
+
+  start = timer_get_count();
+  for (uint32_t i = 0; i < bench->loops; ++i) byte_memcpy(dest, src, size);
+  bench->byte_memcpy = timer_get_count() - start;
+
+  start = timer_get_count();
+  for (uint32_t i = 0; i < bench->loops; ++i) kernel_memset(dest, 0x5a, size);
+  bench->asm_memset = timer_get_count() - start;
+
+  start = timer_get_count();
+  for (uint32_t i = 0; i < bench->loops; ++i) byte_memset(dest, 0x5a, size);
+  bench->byte_memset = timer_get_count() - start;
+
+  kernel_memset(src, 0x5a, size);
+  start = timer_get_count();
+  for (uint32_t i = 0; i < bench->loops; ++i) {
+    bench_sink += kernel_memcmp(dest, src, size);
+  }
+  bench->asm_memcmp = timer_get_count() - start;
+
+  start = timer_get_count();
+  for (uint32_t i = 0; i < bench->loops; ++i) {
+    bench_sink += byte_memcmp(dest, src, size);
+  }
+  bench->byte_memcmp = timer_get_count() - start;
+}
+
+/**
+ * @brief 分别运行汇编实现与原逐字节实现，测试期间不关中断，结果包含中断的开销
+ *
+ * @param bench 调用者填写size、offset与loops，返回时填写各函数的总耗时
+ * @return int 0：成功，-1：参数错误或内存不足
+ */
+int sys_klib_bench(klib_bench_t *bench) {
+  if (!bench || mmap_prepare_write((uint32_t)bench, sizeof(klib_bench_t)) < 0) {
+    return -1;
+  }
+
+  klib_bench_t args;
+  kernel_memcpy(&args, bench, sizeof(klib_bench_t));
+  if (args.size == 0 || args.size > KLIB_BENCH_SIZE_MAX || args.offset > 3 ||
+      args.loops == 0) {
+    return -1;
+  }
+
+  // 1.分配测试用的两块缓冲区，源缓冲区多分配一页以容纳偏移
+  int dest_pages = up2(args.size, MEM_PAGE_SIZE) / MEM_PAGE_SIZE;
+  int src_pages = dest_pages + 1;
+  uint8_t *dest = (uint8_t *)memory_alloc_page(dest_pages, MEM_TAG_OTHER);
+  uint8_t *src = (uint8_t *)memory_alloc_page(src_pages, MEM_TAG_OTHER);
+  if (!dest || !src) {
+    if (dest) memory_free_page((uint32_t)dest, dest_pages);
+    if (src) memory_free_page((uint32_t)src, src_pages);
+    return -1;
+  }
+
+  // 2.运行测试，再将结果写回用户缓冲区
+  bench_run(&args, dest, src + args.offset);
+  kernel_memcpy(bench, &args, sizeof(klib_bench_t));
+
+  memory_free_page((uint32_t)dest, dest_pages);
+  memory_free_page((uint32_t)src, src_pages);
+  return 0;
+}
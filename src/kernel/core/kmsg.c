@@ -0,0 +1,89 @@
+/**
+ * @file kmsg.c
+ * @author kbpoyo (kbpoyo@qq.com)
+ * @brief kmsg设备，读取内核日志环形缓冲区
+ * @version 0.1
+ * @date 2023-09-16
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#include "core/dev.h"
+#include "fs/devfs/devfs.h"
+#include "tools/log.h"
+
+/**
+ * @brief 打开kmsg设备
+ *
+ */
+int kmsg_open(device_t *dev) { return 0; }
+
+/**
+ * @brief 读取kmsg设备，所有读取者共享同一个读取位置，已读取的日志不会再次读到
+ *
+ */
+int kmsg_read(device_t *dev, int addr, char *buf, int size) {
+  if (size < 0) {
+    return -1;
+  }
+
+  return log_read(buf, size);
+}
+
+/**
+ * @brief 写入kmsg设备，写入的内容作为一条内核日志
+ *
+ */
+int kmsg_write(device_t *dev, int addr, char *buf, int size) {
+  if (size < 0) {
+    return -1;
+  }
+
+  // 按行切分，每次最多写入一行的前200个字节
+  int len = 0;
+  while (len < size) {
+    char line[200 + 1];
+    int n = 0;
+    while (len < size && n < sizeof(line) - 1) {
+      line[n++] = buf[len++];
+      if (line[n - 1] == '\n') {
+        break;
+      }
+    }
+
+    line[n] = '\0';
+    log_printf("%s", line);
+  }
+
+  return len;
+}
+
+/**
+ * @brief 向kmsg设备发送控制指令
+ *
+ */
+int kmsg_control(device_t *dev, int cmd, int arg0, int arg1) { return -1; }
+
+/**
+ * @brief 关闭kmsg设备
+ *
+ */
+void kmsg_close(device_t *dev) {}
+
+// 操作kmsg设备的函数表
+dev_desc_t dev_kmsg_desc = {.dev_name = "kmsg",
+                            .open = kmsg_open,
+                            .read = kmsg_read,
+                            .write = kmsg_write,
+                            .control = kmsg_control,
+                            .close = kmsg_close};
+
+/**
+ * @brief 注册kmsg设备，设备文件为kmsg
+ *
+ */
+void kmsg_init(void) {
+  dev_register(DEV_KMSG, &dev_kmsg_desc);
+  devfs_register("kmsg", DEV_KMSG, 0, FILE_CHAR);
+}
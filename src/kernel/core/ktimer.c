@@ -0,0 +1,249 @@
+/**
+ * @file ktimer.c
+ * @author kbpoyo (kbpoyo@qq.com)
+ * @brief 内核定时器
+ *        定时器队列按到期时间排序，定时器2以单次模式在队首到期时产生中断，
+ *        到期的回调函数在下半部中执行，分辨率为定时器的分辨率
+ * @version 0.1
+ * @date 2023-09-21
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#include "core/ktimer.h"
+
+#include "core/irq.h"
+#include "core/softirq.h"
+#include "core/task.h"
+#include "dev/timer.h"
+#include "ipc/sem.h"
+#include "tools/assert.h"
+
+static list_t ktimer_list;  // 等待到期的定时器，按到期时间从早到晚排列
+
+/**
+ * @brief 判断计数a是否早于计数b，计数回绕后仍可正确比较
+ *
+ * @param a
+ * @param b
+ * @return int
+ */
+static inline int ktimer_before(uint32_t a, uint32_t b) {
+  return (int)(a - b) < 0;
+}
+
+/**
+ * @brief 定时器2的中断处理函数，只清除中断，到期处理交给下半部
+ *
+ */
+static void irq_handler_for_timer2(void) {
+  irq_clear(INT_TIMER2, NOSUBINT);
+  softirq_raise(SOFTIRQ_KTIMER);
+}
+
+/**
+ * @brief 按队首定时器的到期时间重新设置定时器2，需在关中断时调用
+ *
+ */
+static void ktimer_program(void) {
+  list_node_t *node = list_get_first(&ktimer_list);
+  if (!node) {
+    timer2_stop();
+    return;
+  }
+
+  ktimer_t *first = list_node_parent(node, ktimer_t, node);
+  uint32_t now = timer_get_count();
+  uint32_t count =
+      ktimer_before(now, first->expire) ? first->expire - now : 1;
+
+  // 超出定时器2的最大定时时间时，先在最大时间处中断一次，再重新设置
+  timer2_oneshot(count * TIMER_RESOLVING_POWER, irq_handler_for_timer2);
+}
+
+/**
+ * @brief 内核定时器的下半部处理函数，依次执行已到期定时器的回调函数
+ *
+ */
+static void softirq_handler_for_ktimer(void) {
+  cpu_state_t state = task_enter_protection();
+
+  list_node_t *node;
+  while ((node = list_get_first(&ktimer_list)) != (list_node_t *)0) {
+    ktimer_t *timer = list_node_parent(node, ktimer_t, node);
+    if (ktimer_before(timer_get_count(), timer->expire)) {
+      break;
+    }
+
+    // 回调函数中可能重新启动该定时器，先将其移出队列
+    list_remove(&ktimer_list, node);
+    timer->active = 0;
+
+    task_leave_protection(state);
+    timer->func(timer->arg);
+    state = task_enter_protection();
+  }
+
+  ktimer_program();
+  task_leave_protection(state);
+}
+
+/**
+ * @brief 初始化内核定时器
+ *
+ * @param timer
+ * @param func 到期时的回调函数
+ * @param arg 传给回调函数的参数
+ */
+void ktimer_init(ktimer_t *timer, void (*func)(void *arg), void *arg) {
+  list_node_init(&timer->node);
+  timer->expire = 0;
+  timer->func = func;
+  timer->arg = arg;
+  timer->active = 0;
+}
+
+/**
+ * @brief 启动定时器，us微秒后到期，已启动的定时器重新计时
+ *
+ * @param timer
+ * @param us
+ */
+void ktimer_start_us(ktimer_t *timer, uint32_t us) {
+  ASSERT(timer->func != 0);
+
+  cpu_state_t state = task_enter_protection();
+
+  if (timer->active) {
+    list_remove(&ktimer_list, &timer->node);
+  }
+
+  // 1.计算到期时间，不足一个计数的部分向上取整，保证至少等待us微秒
+  timer->expire = timer_get_count() +
+                  (us + TIMER_RESOLVING_POWER - 1) / TIMER_RESOLVING_POWER;
+  timer->active = 1;
+
+  // 2.按到期时间插入队列
+  list_node_t *node = list_get_first(&ktimer_list);
+  while (node && !ktimer_before(
+                     timer->expire,
+                     list_node_parent(node, ktimer_t, node)->expire)) {
+    node = list_node_next(node);
+  }
+
+  if (node) {
+    list_insert_before(&ktimer_list, node, &timer->node);
+  } else {
+    list_insert_last(&ktimer_list, &timer->node);
+  }
+
+  // 3.成为队首时重新设置定时器2
+  if (list_get_first(&ktimer_list) == &timer->node) {
+    ktimer_program();
+  }
+
+  task_leave_protection(state);
+}
+
+/**
+ * @brief 启动定时器，ms毫秒后到期
+ *
+ * @param timer
+ * @param ms
+ */
+void ktimer_start_ms(ktimer_t *timer, uint32_t ms) {
+  ktimer_start_us(timer, ms * 1000);
+}
+
+/**
+ * @brief 取消定时器
+ *
+ * @param timer
+ * @return int 1：定时器在到期前被取消，0：定时器未启动或已到期
+ */
+int ktimer_cancel(ktimer_t *timer) {
+  cpu_state_t state = task_enter_protection();
+
+  int active = timer->active;
+  if (active) {
+    list_remove(&ktimer_list, &timer->node);
+    timer->active = 0;
+  }
+
+  task_leave_protection(state);
+  return active;
+}
+
+/**
+ * @brief 睡眠定时器的回调函数，唤醒等待的任务
+ *
+ * @param arg 任务等待的信号量
+ */
+static void ktimer_wakeup(void *arg) { sem_notify((sem_t *)arg); }
+
+/**
+ * @brief 当前任务睡眠us微秒，期间其他任务可以运行
+ *        没有任务或处于中断上下文时无法睡眠，改为忙等待
+ *
+ * @param us
+ */
+void ktimer_sleep_us(uint32_t us) {
+  if (!task_current() || irq_in_interrupt()) {
+    timer_delay_us(us);
+    return;
+  }
+
+  sem_t sem;
+  ktimer_t timer;
+  sem_init(&sem, 0);
+  ktimer_init(&timer, ktimer_wakeup, &sem);
+
+  ktimer_start_us(&timer, us);
+  sem_wait(&sem);
+}
+
+/**
+ * @brief 当前任务睡眠ms毫秒
+ *
+ * @param ms
+ */
+void ktimer_sleep_ms(uint32_t ms) { ktimer_sleep_us(ms * 1000); }
+
+/**
+ * @brief 等待条件成立，条件不成立时睡眠一段时间后再次检查，睡眠间隔逐渐增大
+ *        用于等待没有中断通知的硬件状态，等待期间其他任务可以运行
+ *
+ * @param done 检查条件是否成立
+ * @param arg 传给done的参数
+ * @param timeout_us 超时时间，只累计睡眠的时间，实际等待的时间不少于该值
+ * @return int 0：条件成立，-1：超时
+ */
+int ktimer_wait(int (*done)(void *arg), void *arg, uint32_t timeout_us) {
+  uint32_t waited = 0;
+  uint32_t interval = KTIMER_POLL_MIN_US;
+
+  while (!done(arg)) {
+    if (waited >= timeout_us) {
+      // 超时前最后检查一次，防止睡眠期间条件已成立
+      return done(arg) ? 0 : -1;
+    }
+
+    ktimer_sleep_us(interval);
+    waited += interval;
+    if (interval < KTIMER_POLL_MAX_US) {
+      interval <<= 1;
+    }
+  }
+
+  return 0;
+}
+
+/**
+ * @brief 初始化内核定时器队列
+ *
+ */
+void ktimer_system_init(void) {
+  list_init(&ktimer_list);
+  softirq_register(SOFTIRQ_KTIMER, softirq_handler_for_ktimer);
+}
@@ -0,0 +1,79 @@
+/**
+ * @file mem_dev.c
+ * @author kbpoyo (kbpoyo@qq.com)
+ * @brief 内存字符设备，null丢弃所有写入且读取为空，zero读取时返回全0
+ * @version 0.1
+ * @date 2023-09-23
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#include "core/dev.h"
+#include "fs/devfs/devfs.h"
+#include "tools/klib.h"
+
+/**
+ * @brief 打开内存设备
+ *
+ */
+static int mem_dev_open(device_t *dev) {
+  if (dev->dev_index != DEV_MEM_NULL && dev->dev_index != DEV_MEM_ZERO) {
+    return -1;
+  }
+
+  return 0;
+}
+
+/**
+ * @brief 读取内存设备，null总是读到文件末尾，zero总是读满缓冲区
+ *
+ */
+static int mem_dev_read(device_t *dev, int addr, char *buf, int size) {
+  if (dev->dev_index == DEV_MEM_NULL) {
+    return 0;
+  }
+
+  kernel_memset(buf, 0, size);
+  return size;
+}
+
+/**
+ * @brief 写入内存设备，数据直接丢弃
+ *
+ */
+static int mem_dev_write(device_t *dev, int addr, char *buf, int size) {
+  return size;
+}
+
+/**
+ * @brief 向内存设备发送控制指令
+ *
+ */
+static int mem_dev_control(device_t *dev, int cmd, int arg0, int arg1) {
+  return -1;
+}
+
+/**
+ * @brief 关闭内存设备
+ *
+ */
+static void mem_dev_close(device_t *dev) {}
+
+// 操作内存设备的函数表
+static dev_desc_t dev_mem_desc = {.dev_name = "mem",
+                                  .open = mem_dev_open,
+                                  .read = mem_dev_read,
+                                  .write = mem_dev_write,
+                                  .control = mem_dev_control,
+                                  .close = mem_dev_close};
+
+/**
+ * @brief 注册内存设备，设备文件为null与zero
+ *
+ */
+void mem_dev_init(void) {
+  dev_register(DEV_MEM, &dev_mem_desc);
+  devfs_register("null", DEV_MEM, DEV_MEM_NULL, FILE_CHAR);
+  devfs_register("zero", DEV_MEM, DEV_MEM_ZERO, FILE_CHAR);
+}
@@ -1,11 +1,16 @@
 #include "core/memory.h"
 
 #include "common/boot_info.h"
+#include "core/clock.h"
 #include "core/mmu.h"
+#include "core/swap.h"
 #include "tools/bitmap.h"
 #include "tools/klib.h"
 #include "tools/log.h"
 
+// 内存使用情况中每一行输出的最大字节数
+#define MEM_STAT_LINE_SIZE 64
+
 // TODO:暂时固定内存容量信息
 static boot_info_t boot_info = {
     // .ram_region_cfg[0] = {.start = 0, .size = 4 * 1024},
@@ -15,6 +20,73 @@ static boot_info_t boot_info = {
 // 定义全局内存页分配对象
 static addr_alloc_t paddr_alloc __attribute__((section(".data"), aligned(4)));
 
+// 各用途的名称，与mem_tag_t一一对应
+static const char *mem_tag_name[MEM_TAG_COUNT] = {
+    [MEM_TAG_OTHER] = "other",
+    [MEM_TAG_PAGE_TABLE] = "page_table",
+    [MEM_TAG_TASK] = "task",
+    [MEM_TAG_KSTACK] = "kstack",
+    [MEM_TAG_FILE] = "file",
+    [MEM_TAG_FAT_TABLE] = "fat_table",
+    [MEM_TAG_FAT_BUF] = "fat_buffer",
+    [MEM_TAG_PAGE_CACHE] = "page_cache",
+    [MEM_TAG_SHM] = "shm",
+    [MEM_TAG_USER] = "user",
+};
+
+#if MEM_TRACE_ENABLE
+// 内核空间一次未释放的分配
+typedef struct _mem_trace_t {
+  uint32_t addr;        // 起始地址，0：空闲
+  uint32_t site;        // 调用分配函数的指令地址
+  uint16_t page_count;  // 页数
+  uint16_t tag;         // 用途
+} mem_trace_t;
+
+static mem_trace_t mem_trace_table[MEM_TRACE_COUNT]
+    __attribute__((section(".data"), aligned(4))) = {{0}};
+// 记录表已满而未能记录的分配次数
+static uint32_t mem_trace_lost __attribute__((section(".data"))) = 0;
+
+/**
+ * @brief 记录一次内核空间的分配，需在锁定paddr_alloc后调用
+ *
+ * @param addr
+ * @param page_count
+ * @param tag
+ * @param site
+ */
+static void mem_trace_add(uint32_t addr, int page_count, mem_tag_t tag,
+                          uint32_t site) {
+  for (int i = 0; i < MEM_TRACE_COUNT; ++i) {
+    mem_trace_t *trace = mem_trace_table + i;
+    if (trace->addr == 0) {
+      trace->addr = addr;
+      trace->site = site;
+      trace->page_count = page_count;
+      trace->tag = tag;
+      return;
+    }
+  }
+
+  mem_trace_lost++;
+}
+
+/**
+ * @brief 起始页被释放时删除对应的分配记录，需在锁定paddr_alloc后调用
+ *
+ * @param addr
+ */
+static void mem_trace_remove(uint32_t addr) {
+  for (int i = 0; i < MEM_TRACE_COUNT; ++i) {
+    if (mem_trace_table[i].addr == addr) {
+      mem_trace_table[i].addr = 0;
+      return;
+    }
+  }
+}
+#endif
+
 // 声明页目录表结构，并且使该页目录的起始地址按页大小对齐
 // 页目录项的高12位为页表的物理地址位，及4096个子页表
 static pde_t kernel_page_dir[PDE_CNT]
@@ -152,7 +224,7 @@ static void addr_alloc_init(addr_alloc_t *alloc, uint8_t *bitmap_start,
  * @return uint32_t 申请的第一个页的起始地址， 0：分配失败
  */
 static uint32_t addr_alloc_page_align(addr_alloc_t *alloc, int page_count,
-                                      int align) {
+                                      int align, mem_tag_t tag) {
   uint32_t addr = 0;  // 记录分配的页的起始地址
 
   // TODO：加锁
@@ -164,6 +236,10 @@ static uint32_t addr_alloc_page_align(addr_alloc_t *alloc, int page_count,
   if (page_count >= 1 && page_index >= 0) {
     // 计算出申请到的第一个页的起始地址
     addr = alloc->start + page_index * alloc->page_size;
+
+    // 记录每一页的用途
+    kernel_memset(alloc->page_tag + page_index, tag, page_count);
+    alloc->tag_pages[tag] += page_count;
   }
 
   // TODO：解锁
@@ -176,11 +252,13 @@ static uint32_t addr_alloc_page_align(addr_alloc_t *alloc, int page_count,
  *
  * @param alloc
  * @param page_count 申请页的数量
+ * @param tag 页的用途
  * @return uint32_t 申请的第一个页的起始地址， 0：分配失败
  */
-static uint32_t addr_alloc_page(addr_alloc_t *alloc, int page_count) {
-  return addr_alloc_page_align(alloc, page_count,
-                               1 * 1024);  // 默认按1kb对齐方式分配页
+static uint32_t addr_alloc_page(addr_alloc_t *alloc, int page_count,
+                                mem_tag_t tag) {
+  return addr_alloc_page_align(alloc, page_count, 1 * 1024,
+                               tag);  // 默认按1kb对齐方式分配页
 }
 
 /**
@@ -202,7 +280,12 @@ static void addr_free_page(addr_alloc_t *alloc, uint32_t addr, int page_count) {
     // 获取当前页引用
     int ref = get_page_ref(alloc, page_addr);
     if (ref == 0) {  // 引用为0，释放该页
-      bitmap_set_bit(&alloc->bitmap, page_index(alloc, page_addr), 1, 0);
+      int index = page_index(alloc, page_addr);
+      bitmap_set_bit(&alloc->bitmap, index, 1, 0);
+      alloc->tag_pages[alloc->page_tag[index]]--;
+#if MEM_TRACE_ENABLE
+      mem_trace_remove(page_addr);
+#endif
     }
   }
 
@@ -268,8 +351,9 @@ pte_t *find_pte(pde_t *page_dir, uint32_t vstart, int is_alloc) {
 
     // 为该目录项分配空间作为页表, 且页表基地址按4kb对齐
     uint32_t page_count = PTE_CNT * sizeof(pte_t) / MEM_PAGE_SIZE;
-    uint32_t pg_addr = addr_alloc_page_align(&paddr_alloc, page_count,
-                                             SECOND_LEVEL_PAGE_TABLE_ALIGN);
+    uint32_t pg_addr =
+        addr_alloc_page_align(&paddr_alloc, page_count,
+                              SECOND_LEVEL_PAGE_TABLE_ALIGN, MEM_TAG_PAGE_TABLE);
     if (pg_addr == 0) {  // 分配失败
       return (pte_t *)0;
     }
@@ -346,6 +430,7 @@ void create_kernal_table(void) {
 
   // 声明内核只读段的起始与结束地址和数据段的起始地址
   extern char s_text, e_text, s_data;
+  extern uint8_t clock_page_buf[];
 
   // 对内核的虚拟空间进行一一映射，即物理地址=虚拟地址，以预防使能mmu时的未知错误
   static memory_map_t kernal_map[] = {
@@ -371,7 +456,12 @@ void create_kernal_table(void) {
        (void *)MEM_NADNFLASH_START,
        PTE_AP_SYS},  // 映射nandflash相关寄存器地址范围
       {(void *)MEM_SD_START, (void *)MEM_SD_END, (void *)MEM_SD_START,
-       PTE_AP_SYS}  // 映射SD控制器相关寄存器组
+       PTE_AP_SYS},  // 映射SD控制器相关寄存器组
+      {(void *)MEM_DMA_START, (void *)MEM_DMA_END, (void *)MEM_DMA_START,
+       PTE_AP_SYS},  // 映射DMA控制器相关寄存器组
+      {(void *)CLOCK_PAGE_ADDR, (void *)(CLOCK_PAGE_ADDR + MEM_PAGE_SIZE),
+       clock_page_buf,
+       PTE_AP_USR_READONLY | PTE_C}  // 映射时间页，用户模式只读
   };
 
   // memory_show_bitmap();
@@ -423,19 +513,27 @@ void memory_init() {
 
   log_printf("free memory: 0x%x, size: 0x%x\n", MEM_EXT_START, mem_up1MB_free);
 
-  // mem_free_start被分配的地址在链接文件中定义，紧邻着first_task段
-  uint8_t *mem_free = (uint8_t *)&mem_kernel_end;
+  // mem_free_start被分配的地址在链接文件中定义，紧邻着first_task段，位图按字访问需4字节对齐
+  uint8_t *mem_free = (uint8_t *)up2((uint32_t)&mem_kernel_end, 4);
 
   // 用paddr_alloc，内存页分配对象管理1mb以上的所有空闲空间，页大小为MEM_PAGE_SIZE=4kb
   addr_alloc_init(&paddr_alloc, mem_free, MEM_EXT_START, mem_up1MB_free,
                   MEM_PAGE_SIZE);
+  mutex_set_name(&paddr_alloc.mutex, "paddr_alloc");
 
   // 跳过存储位图的内存区域,
   // 位图的每一位表示一个页，计算位图所站的字节数即可跳过该区域
   mem_free += bitmap_byte_count(paddr_alloc.size / MEM_PAGE_SIZE);
 
-  log_printf("bitmap start addr: 0x%x, end addr: 0x%x\n", &mem_kernel_end,
-             mem_free);
+  log_printf("bitmap start addr: 0x%x, end addr: 0x%x\n",
+             paddr_alloc.bitmap.bits, mem_free);
+
+  // 位图之后存放每一页的用途，每页一个字节
+  int page_total = paddr_alloc.size / MEM_PAGE_SIZE;
+  paddr_alloc.page_tag = mem_free;
+  kernel_memset(paddr_alloc.page_tag, MEM_TAG_OTHER, page_total);
+  kernel_memset(paddr_alloc.tag_pages, 0, sizeof(paddr_alloc.tag_pages));
+  mem_free += up2(page_total, 4);
 
   // 判断mem_free是否已越过可用数据区
   ASSERT(mem_free < ((uint8_t *)MEM_EXT_START - 2 * STACK_SVC_SIZE));
@@ -447,29 +545,60 @@ void memory_init() {
   mmu_set_page_dir(kernel_page_dir);
   // 使能mmu
   enable_mmu();
+  // 锁定关键路径到cache与tlb中
+  mmu_lockdown_init();
 
   log_printf("memory init success...\n");
 }
 
+/**
+ * @brief 在内核空间分配page_count页内存，并记录调用位置
+ *
+ * @param page_count
+ * @param align
+ * @param tag
+ * @param site 调用者的指令地址
+ * @return uint32_t
+ */
+static uint32_t memory_alloc(int page_count, int align, mem_tag_t tag,
+                             uint32_t site) {
+  mutex_lock(&paddr_alloc.mutex);
+
+  uint32_t addr = addr_alloc_page_align(&paddr_alloc, page_count, align, tag);
+#if MEM_TRACE_ENABLE
+  if (addr) {
+    mem_trace_add(addr, page_count, tag, site);
+  }
+#endif
+
+  mutex_unlock(&paddr_alloc.mutex);
+  return addr;
+}
+
 /**
  * @brief 为进程的内核空间分配一页内存，需特权级0访问
  *
+ * @param page_count
+ * @param tag 页的用途
  * @return uint32_t 内存的起始地址
  */
-uint32_t memory_alloc_page(int page_count) {
-  uint32_t addr = addr_alloc_page(&paddr_alloc, page_count);
-  return addr;
+uint32_t memory_alloc_page(int page_count, mem_tag_t tag) {
+  return memory_alloc(page_count, MEM_PAGE_SIZE, tag,
+                      (uint32_t)__builtin_return_address(0));
 }
 
 /**
  * @brief 为进程的内核空间分配page_count页内存
  * 并让起始页按align对齐
  *
+ * @param page_count
+ * @param align
+ * @param tag 页的用途
  * @return uint32_t 内存的起始地址
  */
-uint32_t memory_alloc_page_align(int page_count, int align) {
-  uint32_t addr = addr_alloc_page_align(&paddr_alloc, page_count, align);
-  return addr;
+uint32_t memory_alloc_page_align(int page_count, int align, mem_tag_t tag) {
+  return memory_alloc(page_count, align, tag,
+                      (uint32_t)__builtin_return_address(0));
 }
 
 /**
@@ -495,6 +624,11 @@ void memory_free_page(uint32_t addr, int page_count) {
     } else {   // 释放用户空间的一页内存
       // 1.用虚拟地址找到该页对应的页表项
       pte_t *pte = find_pte(curr_page_dir(), addr, 0);
+      if (pte && pte_is_swap(pte)) {  // 该页已被换出，释放其槽位即可
+        swap_free_slot(pte);
+        addr += MEM_PAGE_SIZE;
+        continue;
+      }
       if (pte == (pte_t *)0 || pte->domain.flag == 0) {  // 未找到对应的页表项
         log_error("free page failed. no pte i =%d\n", i);
       }
@@ -511,6 +645,111 @@ void memory_free_page(uint32_t addr, int page_count) {
   }
 }
 
+/**
+ * @brief 为用户空间分配一页物理内存，内存不足时先换出其他进程的页
+ *
+ * @return uint32_t 0：分配失败
+ */
+static uint32_t alloc_user_page(void) {
+  uint32_t page = addr_alloc_page(&paddr_alloc, 1, MEM_TAG_USER);
+  if (page == 0 && swap_reclaim(SWAP_RECLAIM_BATCH) > 0) {
+    page = addr_alloc_page(&paddr_alloc, 1, MEM_TAG_USER);
+  }
+
+  return page;
+}
+
+/**
+ * @brief 增加物理页的引用计数，供页缓存等需要长期持有页的模块使用
+ *
+ * @param paddr
+ */
+void memory_page_ref_add(uint32_t paddr) { page_ref_add(&paddr_alloc, paddr); }
+
+/**
+ * @brief 获取物理页的引用计数
+ *
+ * @param paddr
+ * @return int
+ */
+int memory_page_ref(uint32_t paddr) { return get_page_ref(&paddr_alloc, paddr); }
+
+/**
+ * @brief 将内核空间中addr处的一页设置为保护页，或恢复其一一映射
+ *        所有进程共享内核的页表，修改对所有进程立即生效
+ *
+ * @param addr 按页对齐的内核空间地址
+ * @param is_guard 1：解除映射作为保护页，0：恢复映射
+ */
+void memory_set_guard_page(uint32_t addr, int is_guard) {
+  pte_t *pte = find_pte(kernel_page_dir, addr, 0);
+  ASSERT(pte != (pte_t *)0);
+
+  pte->v = is_guard ? 0 : (addr | PTE_AP_SYS | PTE_C | PTE_FLAG);
+  disable_tlb_entry(addr);
+}
+
+/**
+ * @brief 解除页目录表中从vaddr开始的page_count页的映射关系，并释放对应的物理页
+ *        与memory_free_page不同，未建立映射的页会被直接跳过
+ *
+ * @param page_dir
+ * @param vaddr
+ * @param page_count
+ */
+void memory_unmap_for_page_dir(uint32_t page_dir, uint32_t vaddr,
+                               int page_count) {
+  for (int i = 0; i < page_count; ++i, vaddr += MEM_PAGE_SIZE) {
+    pte_t *pte = find_pte((pde_t *)page_dir, vaddr, 0);
+    if (pte && pte_is_swap(pte)) {  // 已被换出的页只需释放槽位
+      swap_free_slot(pte);
+      continue;
+    }
+    if (pte == (pte_t *)0 || pte->domain.flag == 0) {
+      continue;
+    }
+
+    addr_free_page(&paddr_alloc, pte_to_pg_addr(pte), 1);
+    pte->v = 0;
+    // 页表项已被修改，需使对应的tlb项无效
+    disable_tlb_entry(vaddr);
+  }
+}
+
+/**
+ * @brief 对vaddr所在的页进行写时复制，即为其分配新的物理页并拷贝原页内容，
+ *        再以privilege权限重新建立映射，原物理页的引用计数-1
+ *
+ * @param page_dir
+ * @param vaddr
+ * @param privilege
+ * @return int 0：成功，-1：失败
+ */
+int memory_copy_page(uint32_t page_dir, uint32_t vaddr, uint32_t privilege) {
+  vaddr = down2(vaddr, MEM_PAGE_SIZE);
+  pte_t *pte = find_pte((pde_t *)page_dir, vaddr, 0);
+  if (pte == (pte_t *)0 || pte->domain.flag == 0) {
+    return -1;
+  }
+
+  // 1.分配新页并拷贝原页内容
+  uint32_t old_page = pte_to_pg_addr(pte);
+  uint32_t new_page = alloc_user_page();
+  if (new_page == 0) {
+    log_error("copy page failed. no memory\n");
+    return -1;
+  }
+  kernel_memcpy((void *)new_page, (void *)old_page, MEM_PAGE_SIZE);
+
+  // 2.解除原页的映射，再将新页映射到vaddr处
+  addr_free_page(&paddr_alloc, old_page, 1);
+  pte->v = 0;
+  int err = memory_creat_map((pde_t *)page_dir, vaddr, new_page, 1, privilege);
+  disable_tlb_entry(vaddr);
+
+  return err < 0 ? -1 : 0;
+}
+
 /**
  * @brief 为进程在物理地址空间中分配对应的页空间，并进行映射，
  *        使进程的虚拟地址与物理地址对应起来
@@ -530,7 +769,7 @@ int memory_alloc_for_page_dir(uint32_t page_dir, uint32_t vaddr,
 
   // 3.逐页进行映射
   for (int i = 0; i < page_count; ++i) {
-    uint32_t paddr = addr_alloc_page(&paddr_alloc, 1);
+    uint32_t paddr = alloc_user_page();
     if (paddr == 0) {  // 分配失败
       log_error("mem alloc failed. no memory\n");
       // TODO:当分配失败时应该将之前分配的页全部归还，且将映射关系也全部解除
@@ -578,10 +817,10 @@ uint32_t memory_creat_uvm() {
   // 1.分配一页作为页目录表
   pde_t *page_dir = (pde_t *)addr_alloc_page_align(
       &paddr_alloc, sizeof(pde_t) * PDE_CNT / MEM_PAGE_SIZE,
-      FIRST_LEVEL_PAGE_TABLE_ALIGN);
+      FIRST_LEVEL_PAGE_TABLE_ALIGN, MEM_TAG_PAGE_TABLE);
   if (page_dir == 0) return 0;
 
-  // 2.将该页的内容清空
+  // 2.将该页的内容清空，在缺页、换出与fork的路径上，不交给DMA以免睡眠等待
   kernel_memset((void *)page_dir, 0, sizeof(pde_t) * PDE_CNT);
 
   // 3.获取用户进程空间的第一个页目录项索引, 用户进程空间的起始地址MEM_TASK_BASE
@@ -603,6 +842,9 @@ uint32_t memory_creat_uvm() {
  * @param is_read_share 是否开启了读共享策略，1开启，0未开启
  */
 void memory_destroy_uvm(uint32_t page_dir) {
+  // 回收扫描可能正在访问该页目录表，等待其结束后再释放
+  swap_lock();
+
   // 1.获取用户进程虚拟地址的起始地址对应的该页目录项
   uint32_t user_task_start = pde_index(MEM_TASK_BASE);
   pde_t *pde = (pde_t *)page_dir + user_task_start;
@@ -616,6 +858,10 @@ void memory_destroy_uvm(uint32_t page_dir) {
 
     // 4.遍历所有页表项，清理对应资源
     for (int j = 0; j < PTE_CNT; ++j, ++pte) {
+      if (pte_is_swap(pte)) {  // 已被换出的页只需释放槽位
+        swap_free_slot(pte);
+        continue;
+      }
       if (!pte->domain.flag) continue;
 
       // 5.释放该物理页
@@ -630,6 +876,8 @@ void memory_destroy_uvm(uint32_t page_dir) {
   // 7.释放存储该页目录表的物理页
   addr_free_page(&paddr_alloc, page_dir,
                  PDE_CNT * sizeof(pde_t) / MEM_PAGE_SIZE);
+
+  swap_unlock();
 }
 
 /**
@@ -654,16 +902,29 @@ int memory_copy_uvm(uint32_t to_page_dir, uint32_t from_page_dir) {
 
     // 4.遍历页表的页表项，进行读共享写复制的映射操作
     for (int j = 0; j < PTE_CNT; ++j, ++pte) {
-      if (!pte->domain.flag)  // 当前页表项不存在
-        continue;
-
       // 5.获取该页表项对应的虚拟地址
       uint32_t vaddr = (i << 20) | (j << 10);
 
+      if (pte_is_swap(pte)) {  // 已被换出的页，将其内容读入子进程的新页中
+        uint32_t page = alloc_user_page();
+        if (page == 0) goto copy_uvm_failed;
+
+        if (swap_read_page(pte, page) < 0 ||
+            memory_creat_map((pde_t *)to_page_dir, vaddr, page, 1,
+                             PTE_FLAG | PTE_AP_USR) < 0) {
+          addr_free_page(&paddr_alloc, page, 1);
+          goto copy_uvm_failed;
+        }
+        continue;
+      }
+
+      if (!pte->domain.flag)  // 当前页表项不存在
+        continue;
+
       // 6.判断当前页表项指向的页是否支持写操作
       if (pte->v & PTE_AP_USR) {  // 7当前页支持写操作，需进行复制操作
         // 7.1分配一个新的页，进行拷贝
-        uint32_t page = addr_alloc_page(&paddr_alloc, 1);
+        uint32_t page = alloc_user_page();
         if (page == 0)  // 分配失败
           goto copy_uvm_failed;
 
@@ -831,14 +1092,7 @@ char *sys_sbrk(int incr) {
  * @return int
  */
 static int memory_used() {
-  int cnt = 0;
-  for (int i = 0; i < paddr_alloc.bitmap.bit_count; ++i) {
-    if (bitmap_is_set(&paddr_alloc.bitmap, i)) {
-      cnt++;
-    }
-  }
-
-  return cnt * paddr_alloc.page_size;
+  return bitmap_count_set(&paddr_alloc.bitmap) * paddr_alloc.page_size;
 }
 
 /**
@@ -847,7 +1101,8 @@ static int memory_used() {
  * @return int
  */
 int sys_memory_stat(char *buf, int size) {
-  if (size <= (sizeof(int) * 6 * 8 + 60)) {
+  // 每一行输出不超过MEM_STAT_LINE_SIZE个字节
+  if (size <= MEM_STAT_LINE_SIZE * (5 + MEM_TAG_COUNT)) {
     return -1;
   }
   kernel_memset(buf, 0, size);
@@ -860,6 +1115,34 @@ int sys_memory_stat(char *buf, int size) {
                  (mem_used / (1024 * 1024)), (mem_used % (1024 * 1024)) / 1024,
                  (mem_free / (1024 * 1024)), (mem_free % (1024 * 1024)) / 1024);
 
+  // 1.各用途占用的内存
+  mutex_lock(&paddr_alloc.mutex);
+  char *curr = buf + kernel_strlen(buf);
+  for (int i = 0; i < MEM_TAG_COUNT; ++i) {
+    kernel_sprintf(curr, "  %s:\t%dKB.\n", mem_tag_name[i],
+                   paddr_alloc.tag_pages[i] * MEM_PAGE_SIZE / 1024);
+    curr += kernel_strlen(curr);
+  }
+
+#if MEM_TRACE_ENABLE
+  // 2.内核空间未释放的分配及其调用位置，缓冲区不足时截断
+  kernel_sprintf(curr, "alloc trace (lost %d):\n", mem_trace_lost);
+  curr += kernel_strlen(curr);
+  for (int i = 0; i < MEM_TRACE_COUNT; ++i) {
+    mem_trace_t *trace = mem_trace_table + i;
+    if (trace->addr == 0) {
+      continue;
+    }
+    if (buf + size - curr <= MEM_STAT_LINE_SIZE) {
+      break;
+    }
+    kernel_sprintf(curr, "  0x%x: %d pages at 0x%x, %s\n", trace->site,
+                   trace->page_count, trace->addr, mem_tag_name[trace->tag]);
+    curr += kernel_strlen(curr);
+  }
+#endif
+  mutex_unlock(&paddr_alloc.mutex);
+
   return 0;
 }
 
@@ -0,0 +1,511 @@
+/**
+ * @file mmap.c
+ * @author kbpoyo (kbpoyo@qq.com)
+ * @brief 进程的文件映射区管理，映射区的页在首次访问时经页缓存按需调入
+ * @version 0.1
+ * @date 2023-09-02
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#include "core/mmap.h"
+
+#include <sys/fcntl.h>
+
+#include "core/memory.h"
+#include "core/swap.h"
+#include "core/sys_exception.h"
+#include "core/task.h"
+#include "fs/fs.h"
+#include "fs/page_cache.h"
+#include "ipc/mutex.h"
+#include "ipc/shm.h"
+#include "tools/klib.h"
+#include "tools/log.h"
+
+// 静态分配的映射区表
+static mmap_area_t area_table[MMAP_AREA_COUNT];
+// 空闲的映射区链表
+static list_t free_area_list;
+// 保护映射区表的互斥锁
+static mutex_t area_table_mutex;
+
+/**
+ * @brief 从映射区表中分配一个映射区
+ *
+ * @return mmap_area_t*
+ */
+static mmap_area_t *area_alloc(void) {
+  mmap_area_t *area = (mmap_area_t *)0;
+
+  mutex_lock(&area_table_mutex);
+
+  list_node_t *node = list_remove_first(&free_area_list);
+  if (node) {
+    area = list_node_parent(node, mmap_area_t, node);
+    kernel_memset(area, 0, sizeof(mmap_area_t));
+  }
+
+  mutex_unlock(&area_table_mutex);
+
+  return area;
+}
+
+/**
+ * @brief 将映射区归还到映射区表中，并释放映射区对共享内存段的引用
+ *
+ * @param area
+ */
+static void area_free(mmap_area_t *area) {
+  if (area->shm) {
+    shm_put(area->shm);
+    area->shm = (struct _shm_t *)0;
+  }
+
+  mutex_lock(&area_table_mutex);
+
+  list_insert_last(&free_area_list, &area->node);
+
+  mutex_unlock(&area_table_mutex);
+}
+
+/**
+ * @brief 查找任务中与[start, end)有重叠的映射区
+ *
+ * @param task
+ * @param start
+ * @param end
+ * @return mmap_area_t*
+ */
+static mmap_area_t *area_find(task_t *task, uint32_t start, uint32_t end) {
+  list_node_t *node = list_get_first(&task->mmap_list);
+  while (node) {
+    mmap_area_t *area = list_node_parent(node, mmap_area_t, node);
+    if (area->start < end && start < area->end) {
+      return area;
+    }
+
+    node = list_node_next(node);
+  }
+
+  return (mmap_area_t *)0;
+}
+
+/**
+ * @brief 在任务的映射区范围内寻找一段大小为size的空闲虚拟空间
+ *
+ * @param task
+ * @param hint 用户期望的起始地址，不可用时自动选择
+ * @param size
+ * @return uint32_t 起始地址，0：没有足够的空间
+ */
+static uint32_t area_find_free(task_t *task, uint32_t hint, uint32_t size) {
+  // 1.期望地址可用则直接使用
+  if (hint && (hint % MEM_PAGE_SIZE) == 0 && hint >= MEM_TASK_MMAP_START &&
+      hint + size <= MEM_TASK_MMAP_END && hint + size > hint &&
+      !area_find(task, hint, hint + size)) {
+    return hint;
+  }
+
+  // 2.从映射区起始位置开始，跳过已有的映射区寻找空闲空间
+  uint32_t start = MEM_TASK_MMAP_START;
+  while (start + size <= MEM_TASK_MMAP_END && start + size > start) {
+    mmap_area_t *area = area_find(task, start, start + size);
+    if (!area) {
+      return start;
+    }
+
+    start = area->end;
+  }
+
+  return 0;
+}
+
+/**
+ * @brief 初始化映射区表
+ *
+ */
+void mmap_init(void) {
+  mutex_init(&area_table_mutex);
+  mutex_set_name(&area_table_mutex, "mmap_area");
+  list_init(&free_area_list);
+
+  kernel_memset(area_table, 0, sizeof(area_table));
+  for (int i = 0; i < MMAP_AREA_COUNT; ++i) {
+    list_insert_last(&free_area_list, &area_table[i].node);
+  }
+}
+
+/**
+ * @brief 在任务的映射区范围内分配一段大小为size的虚拟空间，并记录为新的映射区
+ *        此时并不建立任何页映射
+ *
+ * @param task
+ * @param hint 期望的起始地址，为0或不可用时自动选择
+ * @param size 按页对齐的映射区大小
+ * @param prot
+ * @param flags
+ * @return mmap_area_t* 0：没有足够的虚拟空间或映射区
+ */
+mmap_area_t *mmap_area_creat(task_t *task, uint32_t hint, uint32_t size,
+                             int prot, int flags) {
+  uint32_t start = area_find_free(task, hint, size);
+  if (start == 0) {
+    log_printf("mmap: no virtual space.\n");
+    return (mmap_area_t *)0;
+  }
+
+  mmap_area_t *area = area_alloc();
+  if (!area) {
+    log_printf("mmap: no mmap area.\n");
+    return (mmap_area_t *)0;
+  }
+
+  area->start = start;
+  area->end = start + size;
+  area->prot = prot;
+  area->flags = flags;
+  list_node_init(&area->node);
+  list_insert_last(&task->mmap_list, &area->node);
+
+  return area;
+}
+
+/**
+ * @brief 查找任务中包含vaddr的映射区
+ *
+ * @param task
+ * @param vaddr
+ * @return mmap_area_t*
+ */
+mmap_area_t *mmap_area_find(task_t *task, uint32_t vaddr) {
+  return area_find(task, vaddr, vaddr + 1);
+}
+
+/**
+ * @brief 将from任务的映射区复制给to任务，映射的页由memory_copy_uvm负责复制或共享
+ *
+ * @param to
+ * @param from
+ * @return int
+ */
+int mmap_copy(task_t *to, task_t *from) {
+  list_node_t *node = list_get_first(&from->mmap_list);
+  while (node) {
+    mmap_area_t *area = list_node_parent(node, mmap_area_t, node);
+    mmap_area_t *copy = area_alloc();
+    if (!copy) {
+      log_printf("no mmap area for fork.\n");
+      return -1;
+    }
+
+    kernel_memcpy(copy, area, sizeof(mmap_area_t));
+    list_node_init(&copy->node);
+    list_insert_last(&to->mmap_list, &copy->node);
+
+    // 共享内存段的页已被memory_copy_uvm复制为子进程的私有页，需重新映射为共享页
+    if (copy->shm) {
+      shm_get(copy->shm);
+      int page_count = (copy->end - copy->start) / MEM_PAGE_SIZE;
+      memory_unmap_for_page_dir(to->task_sw.page_dir, copy->start, page_count);
+      if (shm_map(copy->shm, to->task_sw.page_dir, copy->start, copy->offset,
+                  page_count, copy->prot) < 0) {
+        return -1;
+      }
+    }
+
+    node = list_node_next(node);
+  }
+
+  return 0;
+}
+
+/**
+ * @brief 释放任务的所有映射区结构，映射的页由memory_destroy_uvm负责释放
+ *
+ * @param task
+ */
+void mmap_destroy(task_t *task) {
+  list_node_t *node;
+  while ((node = list_remove_first(&task->mmap_list)) != (list_node_t *)0) {
+    area_free(list_node_parent(node, mmap_area_t, node));
+  }
+}
+
+/**
+ * @brief 处理当前任务访问映射区时产生的数据访问异常
+ *        缺页时从页缓存中调入文件页并只读映射，
+ *        私有可写映射区写入只读页时进行写时复制
+ *
+ * @param vaddr 出错的虚拟地址
+ * @param fault_state mmu失效状态寄存器的值
+ * @return int 0：异常已处理，可重新执行出错指令，-1：无法处理
+ */
+int mmap_handle_fault(uint32_t vaddr, uint32_t fault_state) {
+  task_t *task = task_current();
+  if (!task) {
+    return -1;
+  }
+
+  // 1.出错地址必须位于某个文件映射区内，共享内存段的页在挂接时已全部映射
+  mmap_area_t *area = area_find(task, vaddr, vaddr + 1);
+  if (!area || area->shm) {
+    return -1;
+  }
+
+  uint32_t page_vaddr = down2(vaddr, MEM_PAGE_SIZE);
+  uint32_t page_dir = task->task_sw.page_dir;
+  uint32_t state = fault_state & 0xf;
+
+  // 2.缺页异常，从页缓存获取该页，先以只读方式映射，写入时再进行复制
+  if (state == MMU_ERR_FIRST_PAGE_ENTRY || state == MMU_ERR_SECOND_PAGE_ENTRY) {
+    uint32_t offset = area->offset + (page_vaddr - area->start);
+    uint32_t page = page_cache_get(&area->file, offset);
+    if (page == 0) {
+      return -1;
+    }
+
+    int err = memory_creat_map((pde_t *)page_dir, page_vaddr, page, 1,
+                               PTE_FLAG | PTE_AP_USR_READONLY);
+    // 释放页缓存为本次调用增加的引用，映射关系已持有该页
+    memory_free_page(page, 1);
+    return err < 0 ? -1 : 0;
+  }
+
+  // 3.写只读页产生的权限异常，私有可写映射区进行写时复制
+  if (state == MMU_ERR_PAGE_ACCESS && (area->prot & PROT_WRITE) &&
+      (area->flags & MAP_PRIVATE)) {
+    return memory_copy_page(page_dir, page_vaddr, PTE_FLAG | PTE_AP_USR);
+  }
+
+  return -1;
+}
+
+/**
+ * @brief 内核向当前进程[vaddr, vaddr + size)范围内的用户缓冲区写入前调用
+ *        用户只读的页对特权模式依然可写，内核直接写入文件映射区的只读页
+ *        会修改所有进程共享的页缓存，因此私有可写映射区的页先进行写时复制，
+ *        其余用户只读的页不允许写入
+ *
+ * @param vaddr
+ * @param size
+ * @return int 0：可以写入，-1：缓冲区不可写
+ */
+int mmap_prepare_write(uint32_t vaddr, uint32_t size) {
+  task_t *task = task_current();
+  uint32_t end = vaddr + size;
+  if (!task || end < vaddr) {
+    return -1;
+  }
+
+  uint32_t page_dir = task->task_sw.page_dir;
+  for (uint32_t page_vaddr = down2(vaddr, MEM_PAGE_SIZE); page_vaddr < end;
+       page_vaddr += MEM_PAGE_SIZE) {
+    // 1.只读的映射区不可写入
+    mmap_area_t *area = area_find(task, page_vaddr, page_vaddr + 1);
+    if (area && !(area->prot & PROT_WRITE)) {
+      return -1;
+    }
+
+    // 2.文件映射区中尚未调入的页，先从页缓存调入
+    pte_t *pte = find_pte((pde_t *)page_dir, page_vaddr, 0);
+    if (area && !area->shm &&
+        (!pte || (!pte->domain.flag && !pte_is_swap(pte)))) {
+      if (mmap_handle_fault(page_vaddr, MMU_ERR_SECOND_PAGE_ENTRY) < 0) {
+        return -1;
+      }
+      pte = find_pte((pde_t *)page_dir, page_vaddr, 0);
+    }
+
+    // 未映射或已被换出的页由缺页异常处理，换入的页都是进程私有的可写页
+    if (!pte || !pte->domain.flag) {
+      continue;
+    }
+
+    // 3.用户只读的页，只有私有可写映射区的页可以复制后写入
+    if ((pte->v & PTE_AP_USR) == PTE_AP_USR_READONLY) {
+      if (!area || area->shm || !(area->flags & MAP_PRIVATE) ||
+          memory_copy_page(page_dir, page_vaddr, PTE_FLAG | PTE_AP_USR) < 0) {
+        return -1;
+      }
+    }
+  }
+
+  return 0;
+}
+
+/**
+ * @brief 将内核中的数据复制到当前进程的用户缓冲区，复制前使缓冲区可写
+ *
+ * @param dest 用户缓冲区
+ * @param src
+ * @param size
+ * @return int 0：复制成功，-1：缓冲区不可写
+ */
+int copy_to_user(void *dest, const void *src, uint32_t size) {
+  if (mmap_prepare_write((uint32_t)dest, size) < 0) {
+    return -1;
+  }
+
+  kernel_memcpy(dest, src, size);
+  return 0;
+}
+
+/**
+ * @brief 文件被截断或删除时调用，其簇链即将被释放，
+ *        使映射该文件的所有映射区失效，之后的缺页不再从该文件读取
+ *        已调入的页仍持有原内容，不受影响，调用者需持有文件系统锁
+ *
+ * @param fs
+ * @param sblk 文件起始簇号
+ */
+void mmap_revoke(struct _fs_t *fs, int sblk) {
+  mutex_lock(&area_table_mutex);
+
+  // 将文件大小置0，页缓存获取页时视为越过文件末尾
+  for (int i = 0; i < MMAP_AREA_COUNT; ++i) {
+    mmap_area_t *area = area_table + i;
+    if (!area->shm && area->file.fs == fs && area->file.sblk == sblk) {
+      area->file.size = 0;
+    }
+  }
+
+  mutex_unlock(&area_table_mutex);
+}
+
+/**
+ * @brief 文件被写入而变大后调用，更新映射该文件的映射区中记录的文件快照，
+ *        使越过原文件末尾的页在之后缺页时可以调入，调用者需持有文件系统锁
+ *
+ * @param sblk 写入前文件的起始簇号，空文件写入时才分配起始簇
+ * @param file 写入后的文件
+ */
+void mmap_update_file(int sblk, file_t *file) {
+  mutex_lock(&area_table_mutex);
+
+  for (int i = 0; i < MMAP_AREA_COUNT; ++i) {
+    mmap_area_t *area = area_table + i;
+    if (!area->shm && area->file.fs == file->fs && area->file.sblk == sblk &&
+        area->file.p_index == file->p_index && area->file.size < file->size) {
+      area->file.sblk = file->sblk;
+      area->file.size = file->size;
+    }
+  }
+
+  mutex_unlock(&area_table_mutex);
+}
+
+/**
+ * @brief 将文件映射到当前进程的虚拟空间中，映射区的页在首次访问时才调入
+ *
+ * @param args 映射参数
+ * @return int 映射区起始地址，-1：映射失败
+ */
+int sys_mmap(mmap_args_t *args) {
+  if (!args || args->length == 0 || (args->offset % MEM_PAGE_SIZE)) {
+    return -1;
+  }
+
+  // 1.映射方式必须为共享或私有之一，共享可写映射暂不支持
+  int flags = args->flags & (MAP_SHARED | MAP_PRIVATE);
+  if (flags != MAP_SHARED && flags != MAP_PRIVATE) {
+    return -1;
+  }
+  if (flags == MAP_SHARED && (args->prot & PROT_WRITE)) {
+    log_printf("mmap: shared writable mapping is not supported.\n");
+    return -1;
+  }
+
+  // 2.获取被映射的文件，必须为支持页缓存的普通文件
+  file_t *file = task_file(args->fd);
+  if (!file || file->type != FILE_NORMAL || !file->fs->op->read_page) {
+    log_printf("mmap: file can't be mapped.\n");
+    return -1;
+  }
+  if ((file->mode & O_ACCMODE) == O_WRONLY) {
+    return -1;
+  }
+
+  // 3.在映射区范围内分配虚拟空间并记录映射区，此时并不分配物理页
+  mmap_area_t *area =
+      mmap_area_creat(task_current(), (uint32_t)args->addr,
+                      up2(args->length, MEM_PAGE_SIZE), args->prot, flags);
+  if (!area) {
+    return -1;
+  }
+
+  area->offset = args->offset;
+  kernel_memcpy(&area->file, file, sizeof(file_t));
+
+  return area->start;
+}
+
+/**
+ * @brief 解除当前进程[addr, addr + length)范围内的映射
+ *
+ * @param addr 按页对齐的起始地址
+ * @param length
+ * @return int
+ */
+int sys_munmap(void *addr, uint32_t length) {
+  uint32_t start = (uint32_t)addr;
+  uint32_t end = start + up2(length, MEM_PAGE_SIZE);
+  if ((start % MEM_PAGE_SIZE) || length == 0 || end <= start) {
+    return -1;
+  }
+
+  task_t *task = task_current();
+
+  // 解除映射区中间部分需将其一分为二，先分配好新映射区，避免解除到一半时失败
+  // 映射区互不重叠，最多只有一个映射区需要拆分
+  mmap_area_t *tail = (mmap_area_t *)0;
+  mmap_area_t *area = area_find(task, start, end);
+  if (area && area->start < start && end < area->end) {
+    tail = area_alloc();
+    if (!tail) {
+      return -1;
+    }
+  }
+
+  list_node_t *node = list_get_first(&task->mmap_list);
+  while (node) {
+    list_node_t *next = list_node_next(node);
+    area = list_node_parent(node, mmap_area_t, node);
+    if (area->end <= start || end <= area->start) {
+      node = next;
+      continue;
+    }
+
+    // 1.计算需要解除映射的部分，并释放已调入的页
+    uint32_t s = start > area->start ? start : area->start;
+    uint32_t e = end < area->end ? end : area->end;
+    memory_unmap_for_page_dir(task->task_sw.page_dir, s,
+                              (e - s) / MEM_PAGE_SIZE);
+
+    // 2.调整映射区的范围
+    if (s == area->start && e == area->end) {  // 整个映射区被解除
+      list_remove(&task->mmap_list, &area->node);
+      area_free(area);
+    } else if (s == area->start) {  // 解除映射区头部
+      area->offset += e - area->start;
+      area->start = e;
+    } else if (e == area->end) {  // 解除映射区尾部
+      area->end = s;
+    } else {  // 解除映射区中间部分，将映射区一分为二
+      kernel_memcpy(tail, area, sizeof(mmap_area_t));
+      list_node_init(&tail->node);
+      if (tail->shm) {
+        shm_get(tail->shm);
+      }
+      tail->offset = area->offset + (e - area->start);
+      tail->start = e;
+      area->end = s;
+      list_insert_last(&task->mmap_list, &tail->node);
+    }
+
+    node = next;
+  }
+
+  return 0;
+}
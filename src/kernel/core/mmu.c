@@ -1,8 +1,19 @@
 #include "core/mmu.h"
 
 #include "common/cpu_instr.h"
+#include "common/os_config.h"
+#include "core/task.h"
+#include "tools/klib.h"
 #include "tools/log.h"
 
+// 已锁定的cache路数与tlb项数，锁定只能依次增加
+static struct {
+  int icache_way;
+  int dcache_way;
+  int itlb_entry;
+  int dtlb_entry;
+} lockdown;
+
 void enable_mmu() {
   uint32_t cr1 = cpu_cr1_read();
   uint32_t cr3 = cpu_cr3_read();
@@ -15,4 +26,191 @@ void enable_mmu() {
 
   cpu_cr3_write(cr3);
   cpu_cr1_write(cr1);
-}
\ No newline at end of file
+}
+
+/**
+ * @brief 将[start, end)范围内的指令锁定到指令cache中，范围按CACHE_LOCK_WAY_SIZE扩展
+ *
+ * @param start
+ * @param end
+ * @return int 使用的路数，-1：超出可锁定的路数
+ */
+int cache_lock_text(uint32_t start, uint32_t end) {
+  start = down2(start, CACHE_LOCK_WAY_SIZE);
+  end = up2(end, CACHE_LOCK_WAY_SIZE);
+  int ways = (end - start) / CACHE_LOCK_WAY_SIZE;
+  if (lockdown.icache_way + ways > CACHE_LOCK_WAY_MAX) {
+    return -1;
+  }
+
+  cpu_state_t state = task_enter_protection();
+  for (uint32_t addr = start; addr < end; addr += CPU_CACHE_LINE_SIZE) {
+    // 1.每256字节的8行分属8个组，放入同一路
+    uint32_t way = lockdown.icache_way + (addr - start) / CACHE_LOCK_WAY_SIZE;
+
+    // 2.先使该行无效，已在cache中的行预取时不会重新载入到替换指针所指的路
+    __asm__ __volatile__(
+        "mcr p15, 0, %[addr], c7, c5, 1\n"
+        "mcr p15, 0, %[index], c9, c0, 1\n"
+        "mcr p15, 0, %[addr], c7, c13, 1\n"  // 预取该行到指令cache
+        :
+        : [addr] "r"(addr), [index] "r"(CR9_INDEX(way))
+        : "memory");
+  }
+
+  // 3.将锁定基址移到已锁定的路之后，这些路不再被替换
+  lockdown.icache_way += ways;
+  __asm__ __volatile__("mcr p15, 0, %[index], c9, c0, 1\n"
+                       :
+                       : [index] "r"(CR9_INDEX(lockdown.icache_way)));
+  task_leave_protection(state);
+  return ways;
+}
+
+/**
+ * @brief 将[start, end)范围内的数据锁定到数据cache中，范围按CACHE_LOCK_WAY_SIZE扩展
+ *
+ * @param start
+ * @param end
+ * @return int 使用的路数，-1：超出可锁定的路数
+ */
+int cache_lock_data(uint32_t start, uint32_t end) {
+  start = down2(start, CACHE_LOCK_WAY_SIZE);
+  end = up2(end, CACHE_LOCK_WAY_SIZE);
+  int ways = (end - start) / CACHE_LOCK_WAY_SIZE;
+  if (lockdown.dcache_way + ways > CACHE_LOCK_WAY_MAX) {
+    return -1;
+  }
+
+  cpu_state_t state = task_enter_protection();
+  for (uint32_t addr = start; addr < end; addr += CPU_CACHE_LINE_SIZE) {
+    uint32_t way = lockdown.dcache_way + (addr - start) / CACHE_LOCK_WAY_SIZE;
+    uint32_t tmp;
+
+    // 清空并使该行无效后再读取，使其载入到替换指针所指的路
+    __asm__ __volatile__(
+        "mcr p15, 0, %[addr], c7, c14, 1\n"
+        "mcr p15, 0, %[index], c9, c0, 0\n"
+        "ldr %[tmp], [%[addr]]\n"
+        : [tmp] "=&r"(tmp)
+        : [addr] "r"(addr), [index] "r"(CR9_INDEX(way))
+        : "memory");
+  }
+
+  lockdown.dcache_way += ways;
+  __asm__ __volatile__("mcr p15, 0, %[index], c9, c0, 0\n"
+                       :
+                       : [index] "r"(CR9_INDEX(lockdown.dcache_way)));
+  task_leave_protection(state);
+  return ways;
+}
+
+/**
+ * @brief 将[start, end)范围内每一页的映射锁定到指令tlb中
+ *        锁定的项设置了保留位，切换页目录表时不会被清除，只用于所有任务共享的内核映射
+ *
+ * @param start
+ * @param end
+ * @return int 使用的项数，-1：超出可锁定的项数
+ */
+int tlb_lock_text(uint32_t start, uint32_t end) {
+  start = down2(start, MEM_PAGE_SIZE);
+  end = up2(end, MEM_PAGE_SIZE);
+  int count = (end - start) / MEM_PAGE_SIZE;
+  if (lockdown.itlb_entry + count > TLB_LOCK_ENTRY_MAX) {
+    return -1;
+  }
+
+  cpu_state_t state = task_enter_protection();
+  for (uint32_t addr = start; addr < end; addr += MEM_PAGE_SIZE) {
+    int entry = lockdown.itlb_entry++;
+
+    // 使该页原有的项无效，再通过预取指令触发页表遍历，载入到替换指针所指的项
+    __asm__ __volatile__(
+        "mcr p15, 0, %[addr], c8, c5, 1\n"
+        "mcr p15, 0, %[lock], c10, c0, 1\n"
+        "mcr p15, 0, %[addr], c7, c13, 1\n"
+        :
+        : [addr] "r"(addr), [lock] "r"(CR10_ENTRY(entry, entry, 1))
+        : "memory");
+  }
+
+  __asm__ __volatile__(
+      "mcr p15, 0, %[lock], c10, c0, 1\n"
+      :
+      : [lock] "r"(CR10_ENTRY(lockdown.itlb_entry, lockdown.itlb_entry, 0)));
+  task_leave_protection(state);
+  return count;
+}
+
+/**
+ * @brief 将[start, end)范围内每一页的映射锁定到数据tlb中
+ *
+ * @param start
+ * @param end
+ * @return int 使用的项数，-1：超出可锁定的项数
+ */
+int tlb_lock_data(uint32_t start, uint32_t end) {
+  start = down2(start, MEM_PAGE_SIZE);
+  end = up2(end, MEM_PAGE_SIZE);
+  int count = (end - start) / MEM_PAGE_SIZE;
+  if (lockdown.dtlb_entry + count > TLB_LOCK_ENTRY_MAX) {
+    return -1;
+  }
+
+  cpu_state_t state = task_enter_protection();
+  for (uint32_t addr = start; addr < end; addr += MEM_PAGE_SIZE) {
+    int entry = lockdown.dtlb_entry++;
+    uint32_t tmp;
+
+    // 使该页原有的项无效，再通过读取触发页表遍历
+    __asm__ __volatile__(
+        "mcr p15, 0, %[addr], c8, c6, 1\n"
+        "mcr p15, 0, %[lock], c10, c0, 0\n"
+        "ldr %[tmp], [%[addr]]\n"
+        : [tmp] "=&r"(tmp)
+        : [addr] "r"(addr), [lock] "r"(CR10_ENTRY(entry, entry, 1))
+        : "memory");
+  }
+
+  __asm__ __volatile__(
+      "mcr p15, 0, %[lock], c10, c0, 0\n"
+      :
+      : [lock] "r"(CR10_ENTRY(lockdown.dtlb_entry, lockdown.dtlb_entry, 0)));
+  task_leave_protection(state);
+  return count;
+}
+
+/**
+ * @brief 启动时的锁定策略，在使能mmu后调用
+ *        锁定异常向量所在页、锁定段中的中断、系统调用与任务切换路径，
+ *        使这些路径不受用户程序挤占cache与tlb的影响
+ *        启动栈在任务运行后不再使用，任务的内核栈又随任务切换而变化，故不锁定任何栈
+ *
+ */
+void mmu_lockdown_init(void) {
+#if CACHE_LOCKDOWN_ENABLE
+  extern char s_lockdown, e_lockdown;
+  uint32_t text_start = (uint32_t)&s_lockdown;
+  uint32_t text_end = (uint32_t)&e_lockdown;
+  uint32_t vector_end = SDRAM_INSIDE_START + CACHE_LOCK_VECTOR_SIZE;
+
+  // 1.锁定cache
+  if (cache_lock_text(SDRAM_INSIDE_START, vector_end) < 0 ||
+      cache_lock_text(text_start, text_end) < 0) {
+    log_error("cache lockdown failed. lockdown text size = %d\n",
+              text_end - text_start);
+  }
+
+  // 2.锁定tlb
+  if (tlb_lock_text(SDRAM_INSIDE_START, vector_end) < 0 ||
+      tlb_lock_text(text_start, text_end) < 0) {
+    log_error("tlb lockdown failed. lockdown text size = %d\n",
+              text_end - text_start);
+  }
+
+  log_printf("lockdown: icache %d ways, dcache %d ways, itlb %d, dtlb %d\n",
+             lockdown.icache_way, lockdown.dcache_way, lockdown.itlb_entry,
+             lockdown.dtlb_entry);
+#endif
+}
@@ -0,0 +1,131 @@
+/**
+ * @file prof.c
+ * @author kbpoyo (kbpoyo@qq.com)
+ * @brief 采样分析，定时器3以PROF_SAMPLE_PERIOD_US为周期中断，记录被中断的指令地址
+ *        关中断期间到来的采样会推迟到开中断时，这部分时间会被计入开中断的位置
+ * @version 0.1
+ * @date 2023-09-18
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#include "core/prof.h"
+
+#include "core/irq.h"
+#include "core/mmap.h"
+#include "core/task.h"
+#include "dev/timer.h"
+#include "tools/klib.h"
+#include "tools/log.h"
+
+static struct {
+  int running;       // 是否正在采样
+  uint32_t count;    // 已记录的样本数
+  uint32_t dropped;  // 样本缓冲区满后丢弃的样本数
+  int task_count;    // 任务信息表中的任务数
+  prof_task_t tasks[PROF_TASK_COUNT];
+  prof_sample_t samples[PROF_SAMPLE_COUNT];
+} prof;
+
+/**
+ * @brief 获取任务在任务信息表中的索引，不存在时加入
+ *
+ * @param task
+ * @return uint32_t 表已满时返回PROF_NO_TASK
+ */
+static uint32_t prof_task_index(task_t *task) {
+  for (int i = 0; i < prof.task_count; ++i) {
+    prof_task_t *info = prof.tasks + i;
+    if (info->pid == task->pid &&
+        kernel_strncmp(info->name, task->name, PROF_NAME_SIZE) == 0) {
+      return i;
+    }
+  }
+
+  if (prof.task_count >= PROF_TASK_COUNT) {
+    return PROF_NO_TASK;
+  }
+
+  prof_task_t *info = prof.tasks + prof.task_count;
+  info->pid = task->pid;
+  kernel_strncpy(info->name, task->name, PROF_NAME_SIZE);
+  return prof.task_count++;
+}
+
+/**
+ * @brief 定时器3中断处理函数，记录一个样本
+ *
+ */
+static void irq_handler_for_prof(void) {
+  irq_clear(INT_TIMER3, NOSUBINT);
+
+  if (prof.count >= PROF_SAMPLE_COUNT) {
+    prof.dropped++;
+    return;
+  }
+
+  task_t *curr = task_current();
+  prof_sample_t *sample = prof.samples + prof.count;
+  sample->pc = irq_return_pc();
+  sample->mode = irq_return_spsr() & 0x1f;
+  sample->task = curr ? prof_task_index(curr) : PROF_NO_TASK;
+  prof.count++;
+}
+
+/**
+ * @brief 控制采样分析
+ *
+ * @param cmd PROF_CMD_START，PROF_CMD_STOP，PROF_CMD_READ，PROF_CMD_READ_TASKS，
+ *            PROF_CMD_DROPPED
+ * @param arg0
+ * @param arg1
+ * @return int -1：失败
+ */
+int sys_prof(int cmd, int arg0, int arg1) {
+  switch (cmd) {
+    case PROF_CMD_START:
+      if (prof.running) {
+        timer3_stop();
+      }
+      prof.count = prof.dropped = 0;
+      prof.task_count = 0;
+      prof.running = 1;
+      timer3_start(PROF_SAMPLE_PERIOD_US, irq_handler_for_prof);
+      return 0;
+    case PROF_CMD_STOP:
+      if (prof.running) {
+        timer3_stop();
+        prof.running = 0;
+      }
+      return prof.count;
+    case PROF_CMD_READ: {
+      // 样本只会追加，已记录的部分可以直接拷贝
+      int count = prof.count < arg1 ? prof.count : arg1;
+      if (!arg0 || count < 0) {
+        return -1;
+      }
+      if (copy_to_user((void *)arg0, prof.samples,
+                       count * sizeof(prof_sample_t)) < 0) {
+        return -1;
+      }
+      return count;
+    }
+    case PROF_CMD_READ_TASKS: {
+      int count = prof.task_count < arg1 ? prof.task_count : arg1;
+      if (!arg0 || count < 0) {
+        return -1;
+      }
+      if (copy_to_user((void *)arg0, prof.tasks,
+                       count * sizeof(prof_task_t)) < 0) {
+        return -1;
+      }
+      return count;
+    }
+    case PROF_CMD_DROPPED:
+      return prof.dropped;
+    default:
+      log_printf("prof: unknown cmd %d\n", cmd);
+      return -1;
+  }
+}
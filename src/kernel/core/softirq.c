@@ -0,0 +1,143 @@
+/**
+ * @file softirq.c
+ * @author kbpoyo (kbpoyo@qq.com)
+ * @brief 中断下半部与小任务
+ *        下半部在中断返回前由irq_exit调用，执行期间打开中断，不会嵌套执行，
+ *        下半部中不可睡眠，唤醒任务引起的任务切换推迟到下半部执行完毕后进行
+ * @version 0.1
+ * @date 2023-09-20
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#include "core/softirq.h"
+
+#include "common/cpu_instr.h"
+#include "core/task.h"
+#include "tools/assert.h"
+
+static softirq_handler_t softirq_vec[SOFTIRQ_COUNT];
+static volatile uint32_t softirq_pending;  // 待执行的下半部位图
+static int softirq_running;                // 是否正在执行下半部
+
+static list_t tasklet_list;  // 待执行的小任务队列
+
+/**
+ * @brief 注册下半部处理函数
+ *
+ * @param nr
+ * @param handler
+ */
+void softirq_register(softirq_nr_t nr, softirq_handler_t handler) {
+  ASSERT(nr >= 0 && nr < SOFTIRQ_COUNT);
+  softirq_vec[nr] = handler;
+}
+
+/**
+ * @brief 标记下半部待执行，在本次或下一次中断返回前执行
+ *
+ * @param nr
+ */
+void softirq_raise(softirq_nr_t nr) {
+  cpu_state_t state = task_enter_protection();
+  softirq_pending |= 1 << nr;
+  task_leave_protection(state);
+}
+
+/**
+ * @brief 判断是否正在执行下半部
+ *
+ * @return int
+ */
+int softirq_in_progress(void) { return softirq_running; }
+
+/**
+ * @brief 执行所有待执行的下半部，需在关中断时调用，返回时仍为关中断
+ *
+ */
+void softirq_run(void) {
+  if (softirq_running || !softirq_pending) {
+    return;
+  }
+
+  softirq_running = 1;
+
+  // 执行期间产生的中断可能再次标记下半部，最多重复SOFTIRQ_RESTART_MAX轮
+  for (int round = 0; round < SOFTIRQ_RESTART_MAX && softirq_pending;
+       ++round) {
+    uint32_t pending = softirq_pending;
+    softirq_pending = 0;
+
+    cpu_irq_start();
+    for (int nr = 0; nr < SOFTIRQ_COUNT; ++nr) {
+      if ((pending & (1 << nr)) && softirq_vec[nr]) {
+        softirq_vec[nr]();
+      }
+    }
+    cpu_irq_close();
+  }
+
+  softirq_running = 0;
+}
+
+/**
+ * @brief 初始化小任务
+ *
+ * @param tasklet
+ * @param func
+ * @param arg
+ */
+void tasklet_init(tasklet_t *tasklet, void (*func)(void *arg), void *arg) {
+  list_node_init(&tasklet->node);
+  tasklet->func = func;
+  tasklet->arg = arg;
+  tasklet->scheduled = 0;
+}
+
+/**
+ * @brief 调度小任务，已在待执行队列中的小任务不会重复加入
+ *
+ * @param tasklet
+ */
+void tasklet_schedule(tasklet_t *tasklet) {
+  cpu_state_t state = task_enter_protection();
+
+  if (!tasklet->scheduled) {
+    tasklet->scheduled = 1;
+    list_insert_last(&tasklet_list, &tasklet->node);
+    softirq_pending |= 1 << SOFTIRQ_TASKLET;
+  }
+
+  task_leave_protection(state);
+}
+
+/**
+ * @brief 小任务的下半部处理函数，依次执行待执行队列中的小任务
+ *        执行前清除调度标记，小任务执行期间可再次被调度
+ *
+ */
+static void softirq_handler_for_tasklet(void) {
+  while (1) {
+    cpu_state_t state = task_enter_protection();
+    list_node_t *node = list_remove_first(&tasklet_list);
+    if (!node) {
+      task_leave_protection(state);
+      return;
+    }
+    tasklet_t *tasklet = list_node_parent(node, tasklet_t, node);
+    tasklet->scheduled = 0;
+    task_leave_protection(state);
+
+    tasklet->func(tasklet->arg);
+  }
+}
+
+/**
+ * @brief 初始化下半部
+ *
+ */
+void softirq_init(void) {
+  list_init(&tasklet_list);
+  softirq_register(SOFTIRQ_TASKLET, softirq_handler_for_tasklet);
+}
@@ -0,0 +1,325 @@
+/**
+ * @file swap.c
+ * @author kbpoyo (kbpoyo@qq.com)
+ * @brief 交换空间，内存不足时以时钟算法选出进程的匿名页换出到交换分区，
+ *        被换出的页表项置为无效，再次访问时通过数据访问异常换入
+ * @version 0.1
+ * @date 2023-09-08
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#include "core/swap.h"
+
+#include "common/cpu_instr.h"
+#include "core/dev.h"
+#include "core/disk.h"
+#include "core/memory.h"
+#include "core/sys_exception.h"
+#include "core/task.h"
+#include "ipc/mutex.h"
+#include "tools/bitmap.h"
+#include "tools/klib.h"
+#include "tools/log.h"
+
+// 交换空间管理结构
+static struct {
+  int dev_id;       // 交换分区的设备描述符，-1：没有交换分区
+  int slot_count;   // 槽位总数
+  int free_count;   // 空闲槽位数
+  bitmap_t bitmap;  // 槽位位图，1：已使用
+
+  // 时钟指针，记录上次回收停止的位置
+  int hand_pid;         // 任务的pid，任务已退出时从队列头部开始
+  uint32_t hand_vaddr;  // 任务中的虚拟地址
+
+  mutex_t mutex;  // 换入换出操作互斥，防止换出过程中同一页被换入
+} swap = {.dev_id = -1};
+
+// 槽位位图的存储空间
+static uint32_t slot_bits[BITMAP_BYTES(SWAP_SLOT_MAX) / 4];
+
+/**
+ * @brief 初始化交换空间，使用找到的第一个交换分区
+ *
+ */
+void swap_init(void) {
+  mutex_init(&swap.mutex);
+  mutex_set_name(&swap.mutex, "swap");
+  swap.hand_pid = 0;
+  swap.hand_vaddr = MEM_TASK_BASE;
+
+  // 1.查找交换分区
+  int dev_index;
+  partinfo_t *part_info = disk_find_part(FS_SWAP, &dev_index);
+  if (!part_info) {
+    log_printf("no swap partition.\n");
+    return;
+  }
+
+  // 2.打开交换分区
+  swap.dev_id = dev_open(DEV_DISK, dev_index, (void *)0);
+  if (swap.dev_id < 0) {
+    log_error("open swap partition %s failed.\n", part_info->name);
+    return;
+  }
+
+  // 3.初始化槽位位图
+  swap.slot_count = part_info->total_sectors / SWAP_SECTORS_PER_SLOT;
+  if (swap.slot_count > SWAP_SLOT_MAX) {
+    swap.slot_count = SWAP_SLOT_MAX;
+  }
+  swap.free_count = swap.slot_count;
+  bitmap_init(&swap.bitmap, (uint8_t *)slot_bits, swap.slot_count, 0);
+
+  log_printf("swap on %s: %d KB.\n", part_info->name,
+             swap.slot_count * MEM_PAGE_SIZE / 1024);
+}
+
+/**
+ * @brief 将page_dir中vaddr处的页换出到交换分区
+ *
+ * @param vaddr
+ * @param pte vaddr对应的页表项
+ * @return int 0：成功，-1：失败
+ */
+static int swap_out(uint32_t vaddr, pte_t *pte) {
+  // 1.分配槽位
+  int slot = bitmap_alloc_nbits(&swap.bitmap, 0, 1);
+  if (slot < 0) {
+    return -1;
+  }
+
+  // 2.先将页表项置为换出状态，写出过程中该页若被访问，会在换入时等待写出完成
+  uint32_t old_pte = pte->v;
+  uint32_t page = pte_to_pg_addr(pte);
+  pte->v = (slot << 10) | SWAP_PTE_FLAG;
+  disable_tlb_entry(vaddr);
+
+  // 3.将页内容写入槽位
+  if (dev_write(swap.dev_id, slot * SWAP_SECTORS_PER_SLOT, (char *)page,
+                SWAP_SECTORS_PER_SLOT) < 0) {
+    pte->v = old_pte;
+    bitmap_set_bit(&swap.bitmap, slot, 1, 0);
+    return -1;
+  }
+
+  // 4.释放物理页
+  swap.free_count--;
+  memory_free_page(page, 1);
+  return 0;
+}
+
+/**
+ * @brief 在任务的用户空间中从时钟指针处开始寻找可换出的页并换出
+ *        可换出的页为用户可写且只被该任务引用的匿名页
+ *
+ * @param task
+ * @param page_count 需要换出的页数
+ * @return int 实际换出的页数
+ */
+static int swap_out_task(task_t *task, int page_count) {
+  int count = 0;
+  pde_t *page_dir = (pde_t *)task->task_sw.page_dir;
+
+  for (uint32_t i = pde_index(swap.hand_vaddr); i < PDE_CNT; ++i) {
+    pde_t *pde = page_dir + i;
+    if (!pde->domain.flag) {
+      continue;
+    }
+
+    pte_t *page_table = (pte_t *)pde_to_pt_addr(pde);
+    uint32_t j = (i == pde_index(swap.hand_vaddr)) ? pte_index(swap.hand_vaddr)
+                                                   : 0;
+    for (; j < PTE_CNT; ++j) {
+      pte_t *pte = page_table + j;
+      uint32_t vaddr = (i << 20) | (j << 10);
+
+      // 共享页、只读页与页缓存页均不换出
+      if (!pte->domain.flag ||
+          (pte->v & PTE_AP_USR) != PTE_AP_USR ||
+          memory_page_ref(pte_to_pg_addr(pte)) != 1) {
+        continue;
+      }
+
+      if (swap_out(vaddr, pte) < 0) {
+        return count;
+      }
+
+      if (++count >= page_count) {
+        swap.hand_vaddr = vaddr + MEM_PAGE_SIZE;
+        return count;
+      }
+    }
+  }
+
+  // 该任务已扫描完毕，指针移到下一个任务
+  swap.hand_vaddr = MEM_TASK_BASE;
+  return count;
+}
+
+/**
+ * @brief 获取时钟指针所指向的任务，需在锁定任务队列后调用
+ *
+ * @return task_t*
+ */
+static task_t *swap_hand_task(void) {
+  task_t *task = task_find(swap.hand_pid);
+  if (task) {
+    return task;
+  }
+
+  // 任务已退出，指针回到任务队列头部
+  swap.hand_vaddr = MEM_TASK_BASE;
+  return task_next(0);
+}
+
+/**
+ * @brief 内存不足时回收物理页，时钟指针依次扫过所有任务的用户空间，
+ *        第一轮跳过当前任务，尽量换出最近未运行的任务的页
+ *
+ * @param page_count 需要回收的页数
+ * @return int 实际回收的页数
+ */
+int swap_reclaim(int page_count) {
+  if (swap.dev_id < 0) {
+    return 0;
+  }
+
+  // 锁定任务队列，扫描期间任务不会退出，其页目录表也不会被释放
+  task_list_lock();
+  mutex_lock(&swap.mutex);
+
+  int count = 0;
+  int task_count = 0;
+  for (task_t *task = task_next(0); task; task = task_next(task)) {
+    task_count++;
+  }
+
+  task_t *curr = task_current();
+  task_t *task = swap_hand_task();
+  for (int round = 0; round < 2 && count < page_count; ++round) {
+    for (int n = 0; n < task_count && count < page_count; ++n) {
+      swap.hand_pid = task->pid;
+      if (task->task_sw.page_dir && task->state != TASK_ZOMBIE &&
+          (round == 1 || task != curr)) {
+        count += swap_out_task(task, page_count - count);
+        if (count >= page_count) {
+          break;
+        }
+      }
+
+      // 指针移到下一个任务，到达队列尾部后回到头部
+      task = task_next(task) ? task_next(task) : task_next(0);
+      swap.hand_vaddr = MEM_TASK_BASE;
+    }
+  }
+
+  mutex_unlock(&swap.mutex);
+  task_list_unlock();
+
+  if (count) {
+    log_printf("swap: reclaimed %d pages, %d slots free.\n", count,
+               swap.free_count);
+  }
+  return count;
+}
+
+/**
+ * @brief 锁定交换空间，锁定期间不会进行换入换出，用于销毁页目录表前等待回收扫描结束
+ *
+ */
+void swap_lock(void) { mutex_lock(&swap.mutex); }
+
+/**
+ * @brief 解锁交换空间
+ *
+ */
+void swap_unlock(void) { mutex_unlock(&swap.mutex); }
+
+/**
+ * @brief 将被换出页的内容读入物理页page中，不释放槽位
+ *
+ * @param pte 被换出页的页表项
+ * @param page
+ * @return int
+ */
+int swap_read_page(pte_t *pte, uint32_t page) {
+  int slot = pte_to_swap_slot(pte);
+  return dev_read(swap.dev_id, slot * SWAP_SECTORS_PER_SLOT, (char *)page,
+                  SWAP_SECTORS_PER_SLOT) < 0
+             ? -1
+             : 0;
+}
+
+/**
+ * @brief 释放被换出页占用的槽位，并清空页表项
+ *
+ * @param pte
+ */
+void swap_free_slot(pte_t *pte) {
+  mutex_lock(&swap.mutex);
+
+  bitmap_set_bit(&swap.bitmap, pte_to_swap_slot(pte), 1, 0);
+  swap.free_count++;
+  pte->v = 0;
+
+  mutex_unlock(&swap.mutex);
+}
+
+/**
+ * @brief 处理当前任务访问被换出页产生的缺页异常，将该页换入
+ *
+ * @param vaddr 出错的虚拟地址
+ * @param fault_state mmu失效状态寄存器的值
+ * @return int 0：已换入，-1：不是被换出的页
+ */
+int swap_handle_fault(uint32_t vaddr, uint32_t fault_state) {
+  if ((fault_state & 0xf) != MMU_ERR_SECOND_PAGE_ENTRY || swap.dev_id < 0) {
+    return -1;
+  }
+
+  task_t *task = task_current();
+  vaddr = down2(vaddr, MEM_PAGE_SIZE);
+  pte_t *pte = find_pte((pde_t *)task->task_sw.page_dir, vaddr, 0);
+  if (!pte || !pte_is_swap(pte)) {
+    return -1;
+  }
+
+  // 1.先分配物理页，必要时回收其他页，回收需先锁定任务队列，因此不能持有交换锁
+  uint32_t page = memory_alloc_page(1, MEM_TAG_USER);
+  if (page == 0 && swap_reclaim(SWAP_RECLAIM_BATCH) > 0) {
+    page = memory_alloc_page(1, MEM_TAG_USER);
+  }
+  if (page == 0) {
+    log_error("swap in failed. no memory\n");
+    return -1;
+  }
+
+  int err = -1;
+  mutex_lock(&swap.mutex);
+
+  // 2.等待期间该页可能已被换入
+  if (!pte_is_swap(pte)) {
+    memory_free_page(page, 1);
+    err = 0;
+    goto swap_in_end;
+  }
+
+  // 3.读入页内容，释放槽位并重新建立映射，只有用户可写页会被换出
+  if (swap_read_page(pte, page) < 0) {
+    memory_free_page(page, 1);
+    goto swap_in_end;
+  }
+
+  swap_free_slot(pte);
+  err = memory_creat_map((pde_t *)task->task_sw.page_dir, vaddr, page, 1,
+                         PTE_FLAG | PTE_AP_USR);
+  disable_tlb_entry(vaddr);
+  err = err < 0 ? -1 : 0;
+
+swap_in_end:
+  mutex_unlock(&swap.mutex);
+  return err;
+}
@@ -1,7 +1,12 @@
 #include "core/sys_exception.h"
 
 #include "common/cpu_instr.h"
+#include "common/os_config.h"
+#include "core/memory.h"
+#include "core/mmap.h"
+#include "core/swap.h"
 #include "core/task.h"
+#include "core/trace.h"
 #include "tools/log.h"
 
 void print_exception_frame_info(exception_frame_t* frame) {
@@ -64,14 +69,26 @@ static void print_mmu_err_state() {
   }
 }
 
-void data_abort_handler(exception_frame_t* frame) {
+void data_abort_handler(exception_frame_t* frame, uint32_t spsr,
+                        uint32_t fault_addr, uint32_t fault_state) {
+  trace_event(TRACE_PAGE_FAULT, fault_addr, fault_state);
+
+  // 访问用户空间中被换出的页、文件映射区产生的缺页或写时复制异常，
+  // 处理成功后重新执行出错指令，内核访问用户空间时产生的异常同样可以恢复
+  if ((spsr & 0x1f) == CPU_MODE_USER || fault_addr >= MEM_TASK_BASE) {
+    if (swap_handle_fault(fault_addr, fault_state) == 0 ||
+        mmap_handle_fault(fault_addr, fault_state) == 0) {
+      return;
+    }
+  }
+
   log_printf(
       "==================== Task Error ====================\n"
       "Data Abort Error:\n"
       "error instr address:\t0x%x\n"
       "error access address:\t0x%x\n"
       "error state:\t0x%x\n",
-      frame->err_addr, cpu_cr6_read(), cpu_cr5_read());
+      frame->err_addr, fault_addr, fault_state);
 
   print_mmu_err_state();
 
@@ -81,7 +98,38 @@ void data_abort_handler(exception_frame_t* frame) {
   sys_exit(-1);
 }
 
-void prefetch_abort_handler(exception_frame_t* frame) {
+/**
+ * @brief 内核栈溢出到保护页，异常入口已无法在内核栈中保存上下文，
+ *        出错现场已丢失，只能报告溢出的任务后停止运行
+ *
+ * @param spsr 异常入口访问保护页时的状态寄存器
+ */
+void stack_overflow_handler(uint32_t spsr) {
+  task_t* task = task_current();
+
+  log_printf(
+      "==================== Kernel Error ====================\n"
+      "SVC Stack Overflow:\n"
+      "task name:\t%s\n"
+      "task pid:\t%d\n"
+      "error access address:\t0x%x\n"
+      "spsr:\t0x%x\n",
+      task ? task->name : "none", task ? task->pid : 0, cpu_cr6_read(), spsr);
+  log_printf("===================================================\n");
+
+  // 之后系统停止运行，发送中断不会再被响应
+  log_flush();
+}
+
+void prefetch_abort_handler(exception_frame_t* frame, uint32_t spsr) {
+  trace_event(TRACE_PAGE_FAULT, frame->err_addr, MMU_ERR_SECOND_PAGE_ENTRY);
+
+  // 用户进程执行被换出页中的指令，换入后重新执行
+  if ((spsr & 0x1f) == CPU_MODE_USER &&
+      swap_handle_fault(frame->err_addr, MMU_ERR_SECOND_PAGE_ENTRY) == 0) {
+    return;
+  }
+
   log_printf(
       "==================== Task Error ====================\n"
       "Prefetch Abort Error:\n"
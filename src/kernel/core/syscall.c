@@ -11,9 +11,17 @@
 
 #include "core/syscall.h"
 
+#include "core/clock.h"
+#include "core/irq.h"
+#include "core/klib_bench.h"
 #include "core/memory.h"
+#include "core/mmap.h"
+#include "core/prof.h"
 #include "core/task.h"
+#include "core/trace.h"
 #include "fs/fs.h"
+#include "ipc/lock_stat.h"
+#include "ipc/shm.h"
 #include "tools/log.h"
 
 /**
@@ -48,7 +56,22 @@ static const sys_handler_t sys_table[] = {
     [SYS_ioctl] = (sys_handler_t)sys_ioctl,
     [SYS_unlink] = (sys_handler_t)sys_unlink,
     [SYS_task_stat] = (sys_handler_t)sys_task_stat,
-    [SYS_memory_stat] = (sys_handler_t)sys_memory_stat
+    [SYS_memory_stat] = (sys_handler_t)sys_memory_stat,
+    [SYS_mmap] = (sys_handler_t)sys_mmap,
+    [SYS_munmap] = (sys_handler_t)sys_munmap,
+    [SYS_shmget] = (sys_handler_t)sys_shmget,
+    [SYS_shmat] = (sys_handler_t)sys_shmat,
+    [SYS_shmdt] = (sys_handler_t)sys_shmdt,
+    [SYS_shmctl] = (sys_handler_t)sys_shmctl,
+    [SYS_trace] = (sys_handler_t)sys_trace,
+    [SYS_prof] = (sys_handler_t)sys_prof,
+    [SYS_lock_stat] = (sys_handler_t)sys_lock_stat,
+    [SYS_irq_stat] = (sys_handler_t)sys_irq_stat,
+    [SYS_clock_gettime] = (sys_handler_t)sys_clock_gettime,
+    [SYS_gettimeofday] = (sys_handler_t)sys_gettimeofday,
+    [SYS_fcntl] = (sys_handler_t)sys_fcntl,
+    [SYS_poll] = (sys_handler_t)sys_poll,
+    [SYS_klib_bench] = (sys_handler_t)sys_klib_bench,
 
 };
 
@@ -62,10 +85,15 @@ void swi_handler(syscall_frame_t *frame) {
       sizeof(sys_table) / sizeof(sys_table[0])) {  // 当前系统调用存在
     sys_handler_t handler = sys_table[frame->syscall_args->id];
     if (handler) {
+      int id = frame->syscall_args->id;
+      trace_event(TRACE_SYSCALL_ENTER, id, frame->syscall_args->arg0);
+
       // 直接将4个参数全部传入即可，
       int ret = handler(frame->syscall_args->arg0, frame->syscall_args->arg1,
                         frame->syscall_args->arg2, frame->syscall_args->arg3);
 
+      trace_event(TRACE_SYSCALL_EXIT, id, ret);
+
       // 用r0进行返回值的传递，syscall_args由r0传入恢复状态时也会传回给r0
       frame->syscall_args = (syscall_args_kernel_t *)ret;
       return;
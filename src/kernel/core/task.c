@@ -5,59 +5,198 @@
 #include "common/os_config.h"
 #include "core/irq.h"
 #include "core/memory.h"
+#include "core/mmap.h"
 #include "core/syscall.h"
+#include "core/trace.h"
 #include "fs/fs.h"
 #include "ipc/mutex.h"
+#include "ipc/shm.h"
 #include "tools/klib.h"
 #include "tools/log.h"
 
+// 创建内核栈时填充的标记值，未被覆盖的部分即从未使用过的栈空间
+#define SVC_STACK_MAGIC 0x57acc0de
+// 内核栈下方保护页的大小
+#if TASK_SVC_STACK_GUARD
+#define SVC_STACK_GUARD_SIZE MEM_PAGE_SIZE
+#else
+#define SVC_STACK_GUARD_SIZE 0
+#endif
+
 // 定义全局唯一的任务管理器对象
 static task_manager_t task_manager;
-// 定义静态的任务表，用于任务的静态分配
-static task_t task_table[TASK_COUNT] __attribute__((aligned(4)));
-// 定义用于维护task_table的互斥锁
-static mutex_t task_table_lock;
+// 定义用于维护任务队列遍历与任务分配释放的互斥锁
+static mutex_t task_list_mutex;
 
 /**
- * @brief 从静态任务表中分配一个任务对象
+ * @brief 动态分配一个任务对象，任务数量只受内存大小限制
  *
  * @return task_t*
  */
 static task_t *alloc_task(void) {
-  task_t *task = 0;
-
-  // TODO:加锁
-  mutex_lock(&task_table_lock);
-
-  // 遍历静态任务表，取出未被分配的任务对象空间
-  for (int i = 0; i < TASK_COUNT; ++i) {
-    task_t *curr = task_table + i;
-    if (curr->pid == 0) {
-      task = curr;
-      break;
-    }
+  int page_count = up2(sizeof(task_t), MEM_PAGE_SIZE) / MEM_PAGE_SIZE;
+  task_t *task = (task_t *)memory_alloc_page(page_count, MEM_TAG_TASK);
+  if (task) {
+    kernel_memset(task, 0, sizeof(task_t));
   }
 
-  // TODO:解锁
-  mutex_unlock(&task_table_lock);
-
   return task;
 }
 
 /**
- * @brief 释放静态任务表的任务对象
+ * @brief 释放动态分配的任务对象
  *
  * @param task
  */
 static void free_task(task_t *task) {
-  // TODO:加锁
-  mutex_lock(&task_table_lock);
+  // first_task与empty_task为静态分配，不需要释放
+  if (task == &task_manager.first_task || task == &task_manager.empty_task) {
+    return;
+  }
 
   task->pid = 0;
   task->parent = (task_t *)0;
+  memory_free_page((uint32_t)task,
+                   up2(sizeof(task_t), MEM_PAGE_SIZE) / MEM_PAGE_SIZE);
+}
 
-  // TODO:解锁
-  mutex_unlock(&task_table_lock);
+/**
+ * @brief 获取任务队列中task的下一个任务
+ *
+ * @param task 为0时返回任务队列中的第一个任务
+ * @return task_t* 0：已到达队列尾部
+ */
+task_t *task_next(task_t *task) {
+  list_node_t *node = task ? list_node_next(&task->task_node)
+                           : list_get_first(&task_manager.task_list);
+  return node ? list_node_parent(node, task_t, task_node) : (task_t *)0;
+}
+
+/**
+ * @brief 计算容纳count个桶的桶数组需要的页数
+ *
+ * @param count
+ * @return int
+ */
+static inline int pid_buckets_pages(uint32_t count) {
+  return up2(count * sizeof(hash_node_t *), MEM_PAGE_SIZE) / MEM_PAGE_SIZE;
+}
+
+/**
+ * @brief 将任务加入pid索引，负载过高时将桶数组扩充一倍，需在锁定任务队列后调用
+ *
+ * @param task
+ */
+static void pid_index_insert(task_t *task) {
+  hash_table_t *table = &task_manager.pid_table;
+  hash_insert(table, &task->pid_node, hash_u32(task->pid));
+  if (!hash_need_grow(table)) {
+    return;
+  }
+
+  // 分配失败时保留原来的桶数组，只是冲突链变长
+  uint32_t count = table->bucket_count * 2;
+  hash_node_t **buckets = (hash_node_t **)memory_alloc_page(
+      pid_buckets_pages(count), MEM_TAG_TASK);
+  if (!buckets) {
+    return;
+  }
+
+  uint32_t old_count = table->bucket_count;
+  hash_node_t **old_buckets = hash_resize(table, buckets, count);
+  if (old_buckets != task_manager.pid_buckets) {
+    memory_free_page((uint32_t)old_buckets, pid_buckets_pages(old_count));
+  }
+}
+
+/**
+ * @brief 通过pid查找任务，需在锁定任务队列后调用
+ *
+ * @param pid
+ * @return task_t* 0：任务不存在
+ */
+task_t *task_find(int pid) {
+  for (hash_node_t *node = hash_find(&task_manager.pid_table, hash_u32(pid));
+       node; node = hash_find_next(node)) {
+    task_t *task = hash_node_parent(node, task_t, pid_node);
+    if (task->pid == pid) {
+      return task;
+    }
+  }
+
+  return (task_t *)0;
+}
+
+/**
+ * @brief 锁定任务队列，锁定期间任务不会被加入或移出任务队列
+ *
+ */
+void task_list_lock(void) { mutex_lock(&task_list_mutex); }
+
+/**
+ * @brief 解锁任务队列
+ *
+ */
+void task_list_unlock(void) { mutex_unlock(&task_list_mutex); }
+
+/**
+ * @brief 扩充任务的打开文件表，使其至少可容纳size个文件描述符
+ *        新表按页分配，容量取所分配页能容纳的最大数量
+ *
+ * @param task
+ * @param size
+ * @return int 0：成功，-1：已达到上限或内存不足
+ */
+static int ofile_grow(task_t *task, int size) {
+  if (size <= task->ofile_size) {
+    return 0;
+  }
+  if (size > TASK_OFILE_SIZE) {
+    return -1;
+  }
+
+  // 1.分配新的打开文件表
+  int page_count = up2(size * sizeof(file_t *), MEM_PAGE_SIZE) / MEM_PAGE_SIZE;
+  file_t **table = (file_t **)memory_alloc_page(page_count, MEM_TAG_FILE);
+  if (!table) {
+    return -1;
+  }
+
+  int new_size = page_count * MEM_PAGE_SIZE / sizeof(file_t *);
+  if (new_size > TASK_OFILE_SIZE) {
+    new_size = TASK_OFILE_SIZE;
+  }
+  kernel_memset(table, 0, page_count * MEM_PAGE_SIZE);
+
+  // 2.拷贝已使用的部分，并释放原表
+  kernel_memcpy(table, task->file_table, task->ofile_top * sizeof(file_t *));
+  if (task->file_table != task->ofile_init) {
+    memory_free_page((uint32_t)task->file_table,
+                     up2(task->ofile_size * sizeof(file_t *), MEM_PAGE_SIZE) /
+                         MEM_PAGE_SIZE);
+  }
+
+  task->file_table = table;
+  task->ofile_size = new_size;
+  return 0;
+}
+
+/**
+ * @brief 释放任务扩充过的打开文件表，恢复为初始的内嵌文件表
+ *
+ * @param task
+ */
+static void ofile_release(task_t *task) {
+  if (task->file_table && task->file_table != task->ofile_init) {
+    memory_free_page((uint32_t)task->file_table,
+                     up2(task->ofile_size * sizeof(file_t *), MEM_PAGE_SIZE) /
+                         MEM_PAGE_SIZE);
+  }
+
+  kernel_memset(task->ofile_init, 0, sizeof(task->ofile_init));
+  task->file_table = task->ofile_init;
+  task->ofile_size = TASK_OFILE_INIT;
+  task->ofile_top = 0;
 }
 
 /**
@@ -69,8 +208,9 @@ static void free_task(task_t *task) {
 file_t *task_file(int fd) {
   file_t *file = (file_t *)0;
 
-  if (fd >= 0 && fd < TASK_OFILE_SIZE) {
-    file = task_current()->file_table[fd];
+  task_t *task = task_current();
+  if (fd >= 0 && fd < task->ofile_top) {
+    file = task->file_table[fd];
   }
 
   return file;
@@ -84,15 +224,28 @@ file_t *task_file(int fd) {
  */
 int task_alloc_fd(file_t *file) {
   task_t *task = task_current();
-  for (int i = 0; i < TASK_OFILE_SIZE; ++i) {
+
+  // 1.在打开文件表中寻找最小的空闲文件描述符
+  for (int i = 0; i < task->ofile_size; ++i) {
     file_t *p = task->file_table[i];
     if (p == (file_t *)0) {  // 打开文件表中的第i项未分配，对其进行分配操作
       task->file_table[i] = file;
+      if (i >= task->ofile_top) {
+        task->ofile_top = i + 1;
+      }
       return i;
     }
   }
 
-  return -1;
+  // 2.打开文件表已满，扩充后使用新增部分的第一项
+  int fd = task->ofile_size;
+  if (ofile_grow(task, task->ofile_size * 2) < 0) {
+    return -1;
+  }
+
+  task->file_table[fd] = file;
+  task->ofile_top = fd + 1;
+  return fd;
 }
 
 /**
@@ -102,39 +255,79 @@ int task_alloc_fd(file_t *file) {
  */
 void task_remove_fd(int fd) {
   // 清空文件描述符对应的内存资源即可
-  if (fd >= 0 && fd < TASK_OFILE_SIZE) {
-    task_current()->file_table[fd] = (file_t *)0;
+  task_t *task = task_current();
+  if (fd >= 0 && fd < task->ofile_top) {
+    task->file_table[fd] = (file_t *)0;
+
+    // 回退最高水位，使遍历只覆盖已使用的部分
+    while (task->ofile_top > 0 &&
+           task->file_table[task->ofile_top - 1] == (file_t *)0) {
+      task->ofile_top--;
+    }
   }
 }
 
 /**
- * @brief 分配task任务结构
+ * @brief 为任务分配内核栈，并用标记值填充整个栈空间
+ *        开启保护页时在栈的下方多分配一页并解除其映射，栈溢出时立即产生异常
  *
- * @return task_t*
+ * @return uint32_t 内核栈的栈顶地址，0：分配失败
  */
-task_t *task_alloc(void) {
-  // 加锁
-  mutex_lock(&task_table_lock);
-  task_t *task = (task_t *)0;
-  for (int i = 0; i < TASK_COUNT; ++i) {
-    task = task_table + i;
-    if (task->pid == 0) {
-      break;
-    }
+static uint32_t svc_stack_alloc(void) {
+  int page_count = (SVC_STACK_GUARD_SIZE + TASK_SVC_STACK_SIZE) / MEM_PAGE_SIZE;
+  uint32_t base = memory_alloc_page(page_count, MEM_TAG_KSTACK);
+  if (base == 0) {
+    return 0;
   }
 
-  if (task == (task_t *)0 || task >= task_table + TASK_COUNT) {
-    // 解锁
-    mutex_unlock(&task_table_lock);
+  uint32_t *stack = (uint32_t *)(base + SVC_STACK_GUARD_SIZE);
+  for (int i = 0; i < TASK_SVC_STACK_SIZE / sizeof(uint32_t); ++i) {
+    stack[i] = SVC_STACK_MAGIC;
+  }
+
+#if TASK_SVC_STACK_GUARD
+  memory_set_guard_page(base, 1);
+#endif
+
+  return base + SVC_STACK_GUARD_SIZE + TASK_SVC_STACK_SIZE;
+}
+
+/**
+ * @brief 释放任务的内核栈，开启保护页时先恢复保护页的映射
+ *
+ * @param sp_top 内核栈的栈顶地址
+ */
+static void svc_stack_free(uint32_t sp_top) {
+  uint32_t base = sp_top - TASK_SVC_STACK_SIZE - SVC_STACK_GUARD_SIZE;
+
+#if TASK_SVC_STACK_GUARD
+  memory_set_guard_page(base, 0);
+#endif
+
+  memory_free_page(base,
+                   (SVC_STACK_GUARD_SIZE + TASK_SVC_STACK_SIZE) / MEM_PAGE_SIZE);
+}
+
+/**
+ * @brief 计算任务内核栈的最大使用量，从栈底开始跳过仍保持标记值的部分
+ *
+ * @param task
+ * @return int 使用过的最大字节数
+ */
+static int svc_stack_used(task_t *task) {
+  if (task->svc_sp_top == 0) {
     return 0;
   }
 
-  task->pid = 0xffffffff;  // 标记已分配
+  uint32_t *stack = (uint32_t *)(task->svc_sp_top - TASK_SVC_STACK_SIZE);
+  int count = TASK_SVC_STACK_SIZE / sizeof(uint32_t);
 
-  // 解锁
-  mutex_unlock(&task_table_lock);
+  int i = 0;
+  while (i < count && stack[i] == SVC_STACK_MAGIC) {
+    ++i;
+  }
 
-  return task;
+  return (count - i) * sizeof(uint32_t);
 }
 
 /**
@@ -160,9 +353,9 @@ static int registers_init(task_t *task, uint32_t entry, uint32_t sp,
   task->reg_group.r13 = sp;
   task->reg_group.r15 = entry;
 
-  // 为任务分配一页内核栈，并将寄存器组拷贝到内核栈中，等待任务的初始化
-  int page_count = TASK_SVC_STACK_SIZE / MEM_PAGE_SIZE;
-  uint32_t sp_addr = memory_alloc_page(page_count) + TASK_SVC_STACK_SIZE;
+  // 为任务分配内核栈，并将寄存器组拷贝到内核栈中，等待任务的初始化
+  uint32_t sp_addr = svc_stack_alloc();
+  if (sp_addr == 0) return -1;
   task->svc_sp_top = sp_addr;
   if (task != &(task_manager.first_task)) {  // 对非first_task进行寄存器初始化
     sp_addr = sp_addr - sizeof(register_group_t);
@@ -211,11 +404,16 @@ int task_init(task_t *task, const char *name, uint32_t entry, uint32_t sp,
   task->task_sw.page_dir = memory_creat_uvm();
   task->status = 0;
 
-  // 5.初始化文件表
-  kernel_memset(&task->file_table, 0, sizeof(task->file_table));
+  // 5.初始化文件表，初始使用内嵌的小文件表
+  task->file_table = (file_t **)0;
+  ofile_release(task);
+  list_init(&task->mmap_list);
 
   // 6.将任务加入任务队列
+  mutex_lock(&task_list_mutex);
   list_insert_last(&task_manager.task_list, &task->task_node);
+  pid_index_insert(task);
+  mutex_unlock(&task_list_mutex);
 
   return 1;
 }
@@ -228,8 +426,7 @@ int task_init(task_t *task, const char *name, uint32_t entry, uint32_t sp,
 void task_uninit(task_t *task) {
   // 释放已分配的内核栈空间
   if (task->svc_sp_top) {
-    memory_free_page((uint32_t)(task->svc_sp_top - TASK_SVC_STACK_SIZE),
-                     TASK_SVC_STACK_SIZE / MEM_PAGE_SIZE);
+    svc_stack_free(task->svc_sp_top);
   }
 
   // 释放为页目录分配的页空间及其映射关系
@@ -237,10 +434,19 @@ void task_uninit(task_t *task) {
     memory_destroy_uvm(task->task_sw.page_dir);
   }
 
+  // 释放任务的文件映射区
+  mmap_destroy(task);
+
+  // 释放扩充过的打开文件表
+  ofile_release(task);
+
   // 将任务结构从任务管理器的任务队列中取下
+  mutex_lock(&task_list_mutex);
   list_remove(&task_manager.task_list, &task->task_node);
+  hash_remove(&task_manager.pid_table, &task->pid_node);
+  mutex_unlock(&task_list_mutex);
 
-  // 释放全局任务表中的task结构资源
+  // 释放任务结构资源
   free_task(task);
 }
 
@@ -272,6 +478,12 @@ void task_manager_init(void) {
   list_init(&task_manager.task_list);
   list_init(&task_manager.sleep_list);
 
+  // 2.初始化任务队列的互斥锁与pid索引
+  mutex_init(&task_list_mutex);
+  mutex_set_name(&task_list_mutex, "task_list");
+  hash_init(&task_manager.pid_table, task_manager.pid_buckets,
+            TASK_PID_BUCKETS);
+
   // 3.将当前任务置零
   task_manager.curr_task = (task_t *)0;
 
@@ -280,9 +492,9 @@ void task_manager_init(void) {
             (uint32_t)&empty_task_stack[EMPTY_TASK_STACK_SIZE],
             TASK_FLAGS_SYSTEM);
 
-  // 5.初始化静态任务表,及其互斥锁
-  kernel_memset(task_table, 0, sizeof(task_table));
-  mutex_init(&task_table_lock);
+  // 6.初始化文件映射区表及共享内存段表
+  mmap_init();
+  shm_init();
 
   log_printf("task manager init success...\n");
 }
@@ -297,6 +509,44 @@ void task_start(task_t *task) {
   task_set_ready(task);
 }
 
+/**
+ * @brief  创建并启动内核线程，内核线程运行在内核特权级，入口函数不能返回
+ *
+ * @param name 线程名称
+ * @param entry 入口函数
+ * @param arg 传给入口函数的参数
+ * @return task_t* 0：创建失败
+ */
+task_t *task_create_kernel(const char *name, void (*entry)(void *arg),
+                           void *arg) {
+  // 1.分配任务对象与线程栈
+  task_t *task = alloc_task();
+  if (!task) {
+    return (task_t *)0;
+  }
+
+  int stack_pages = TASK_KTHREAD_STACK_SIZE / MEM_PAGE_SIZE;
+  uint32_t stack = memory_alloc_page(stack_pages, MEM_TAG_KSTACK);
+  if (stack == 0) {
+    free_task(task);
+    return (task_t *)0;
+  }
+
+  // 2.初始化任务
+  if (task_init(task, name, (uint32_t)entry, stack + TASK_KTHREAD_STACK_SIZE,
+                TASK_FLAGS_SYSTEM) < 0) {
+    memory_free_page(stack, stack_pages);
+    free_task(task);
+    return (task_t *)0;
+  }
+
+  // 3.将参数写入内核栈中的初始寄存器组，任务第一次运行时由r0传给入口函数
+  ((register_group_t *)task->task_sw.svc_sp)->r0 = (uint32_t)arg;
+
+  task_start(task);
+  return task;
+}
+
 /**
  * @brief  初始化第一个任务
  *
@@ -441,11 +691,19 @@ static void task_switch_from_to(task_t *from, task_t *to) {
 
 /**
  * @brief  任务管理器进行任务切换
+ *         中断上下文中只标记需要切换，在中断返回前由task_resched进行切换
  *
  */
 void task_switch(void) {
   cpu_state_t state = task_enter_protection();  // TODO:加锁
 
+  if (irq_in_interrupt()) {
+    task_manager.need_resched = 1;
+    task_leave_protection(state);
+    return;
+  }
+  task_manager.need_resched = 0;
+
   // 1.获取就绪队列中的第一个任务
   task_t *to = task_ready_first();
 
@@ -464,6 +722,7 @@ void task_switch(void) {
       from->state = TASK_READY;
     }
     task_manager.curr_task = to;
+    trace_event(TRACE_SCHED_SWITCH, from->pid, to->pid);
 
     // 6.进行任务切换
     task_switch_from_to(from, to);
@@ -471,6 +730,17 @@ void task_switch(void) {
 
   task_leave_protection(state);  // TODO:解锁
 }
+
+/**
+ * @brief  进行中断上下文中被推迟的任务切换，只能在中断返回前调用
+ *
+ */
+void task_resched(void) {
+  if (task_manager.need_resched) {
+    task_switch();
+  }
+}
+
 /**
  * @brief  设置进程延时的时间片数
  *
@@ -509,9 +779,10 @@ void task_set_wakeup(task_t *task) {
 /**
  * @brief  提供给时钟中断使用，每中断一次，当前任务的时间片使用完一次
  *         减少当前任务的时间片数，并判断是否还有剩余时间片，若没有就进行任务切换
+ *         每个时间片都会执行，放入锁定段
  *
  */
-void task_slice_end(void) {
+LOCKDOWN_TEXT void task_slice_end(void) {
   // 1.遍历当前延时队列，判断是否有可唤醒的任务
   list_node_t *curr_sleep_node = list_get_first(&task_manager.sleep_list);
 
@@ -615,15 +886,22 @@ void sys_yield(void) {
  *
  * @param child_task
  */
-static void copy_opened_files(task_t *child_task) {
+static int copy_opened_files(task_t *child_task) {
   task_t *parent = task_current();
-  for (int i = 0; i < TASK_OFILE_SIZE; ++i) {
+  if (ofile_grow(child_task, parent->ofile_top) < 0) {
+    return -1;
+  }
+
+  for (int i = 0; i < parent->ofile_top; ++i) {
     file_t *file = parent->file_table[i];
     if (file) {
       file_inc_ref(file);
       child_task->file_table[i] = file;
     }
   }
+  child_task->ofile_top = parent->ofile_top;
+
+  return 0;
 }
 /**
  * @brief 将进程的打开文件表销毁
@@ -631,13 +909,21 @@ static void copy_opened_files(task_t *child_task) {
  * @param task
  */
 static void close_opened_files(task_t *task) {
-  for (int fd = 0; fd < TASK_OFILE_SIZE; ++fd) {
+  for (int fd = task->ofile_top - 1; fd >= 0; --fd) {
     file_t *file = task->file_table[fd];
-    if (file) {
+    if (!file) {
+      continue;
+    }
+
+    if (task == task_current()) {
       sys_close(fd);
-      task->file_table[fd] = (file_t *)0;
+    } else {  // 未运行过的任务只持有文件的引用，减少引用计数即可
+      file_free(file);
     }
+    task->file_table[fd] = (file_t *)0;
   }
+
+  task->ofile_top = 0;
 }
 
 /**
@@ -664,7 +950,7 @@ int sys_fork(void) {
   if (err < 0) goto fork_failed;
 
   // 让子进程继承父进程的打开文件表
-  copy_opened_files(child_task);
+  if (copy_opened_files(child_task) < 0) goto fork_failed;
 
   // 5.恢复到父进程的上下文环境
   register_group_t *regs = (register_group_t *)(child_task->task_sw.svc_sp);
@@ -698,6 +984,9 @@ int sys_fork(void) {
                       parent_task->task_sw.page_dir) < 0)
     goto fork_failed;
 
+  // 让子进程继承父进程的文件映射区
+  if (mmap_copy(child_task, parent_task) < 0) goto fork_failed;
+
   // 8.子进程控制块初始化完毕，设为可被调度态
   task_start(child_task);
   // 反回子进程id
@@ -706,9 +995,8 @@ int sys_fork(void) {
 // fork失败，清理资源
 fork_failed:
   if (child_task) {  // 初始化失败，释放对应资源
-    task_uninit(child_task);
-    free_task(child_task);
     close_opened_files(child_task);
+    task_uninit(child_task);
   }
 
   return -1;
@@ -962,6 +1250,8 @@ int sys_execve(char *name, char *const *argv, char *const *env) {
   task->task_sw.page_dir = new_page_dir;
   mmu_set_page_dir(new_page_dir);
   memory_destroy_uvm(old_page_dir);
+  // 原进程的文件映射区随原地址空间一同失效
+  mmap_destroy(task);
   return argc;  // r0装入返回值并作为新程序的第一个参数
 
 exec_failed:
@@ -983,20 +1273,13 @@ void sys_exit(int status) {
   task_t *curr_task = task_current();
 
   // 2.关闭当前任务打开的文件
-  for (int fd = 0; fd < TASK_OFILE_SIZE; ++fd) {
-    file_t *file = curr_task->file_table[fd];
-    if (file) {
-      sys_close(fd);
-      curr_task->file_table[fd] = (file_t *)0;
-    }
-  }
+  close_opened_files(curr_task);
 
   // 3.将该进程的子进程的父进程设为first_task，由其进行统一回收
   int move_child = 0;  // 标志位，判断是否当前进程已有子进程进入僵尸态
   // TODO:加锁
-  mutex_lock(&task_table_lock);
-  for (int i = 0; i < TASK_COUNT; ++i) {
-    task_t *task = task_table + i;
+  mutex_lock(&task_list_mutex);
+  for (task_t *task = task_next(0); task; task = task_next(task)) {
     if (task->parent == curr_task) {
       task->parent = &task_manager.first_task;
       if (task->state ==
@@ -1006,7 +1289,7 @@ void sys_exit(int status) {
     }
   }
   // TODO:解锁
-  mutex_unlock(&task_table_lock);
+  mutex_unlock(&task_list_mutex);
 
   // TODO:加锁
   cpu_state_t state = task_enter_protection();
@@ -1055,12 +1338,11 @@ int sys_wait(int *status) {
 
   for (;;) {
     // TODO:加锁
-    mutex_lock(&task_table_lock);
+    mutex_lock(&task_list_mutex);
 
-    // 2.遍历任务表,寻找子进程
-    for (int i = 0; i < TASK_COUNT; ++i) {
-      task_t *task = task_table + i;
-      if (task->pid == 0 || task->parent != curr_task) {
+    // 2.遍历任务队列,寻找子进程
+    for (task_t *task = task_next(0); task; task = task_next(task)) {
+      if (task->parent != curr_task) {
         continue;
       }
       // 3.找到一个子进程，判断是否为僵尸态
@@ -1068,13 +1350,11 @@ int sys_wait(int *status) {
         int pid = task->pid;
         *status = task->status;
 
-        // 释放任务
+        // 释放任务，任务结构随之被释放，不可再访问
         task_uninit(task);
 
-        task->state = TASK_CREATED;
-
         // TODO:解锁
-        mutex_unlock(&task_table_lock);
+        mutex_unlock(&task_list_mutex);
 
         // 3.4返回该进程的pid
         return pid;
@@ -1082,7 +1362,7 @@ int sys_wait(int *status) {
     }
 
     // TODO:解锁
-    mutex_unlock(&task_table_lock);
+    mutex_unlock(&task_list_mutex);
 
     // 4.未找到僵尸态的子进程，则当前进程进入阻塞状态
     // TODO:加锁
@@ -1109,21 +1389,20 @@ int sys_task_stat(char *buf, int size, int *task_count) {
   char task_buf[256];
   kernel_memset(buf, 0, size);
 
-  for (int i = 0; i < TASK_COUNT; ++i) {
-    if (task_table[i].pid == 0) {
-      continue;
-    }
-
+  mutex_lock(&task_list_mutex);
+  for (task_t *task = task_next(0); task; task = task_next(task)) {
     kernel_memset(task_buf, 0, 256);
-    int page_count = memory_page_count_used(task_table[i].task_sw.page_dir);
-    kernel_sprintf(task_buf, "%s\t%d\t%d\t%dMB-%dKB.", task_table[i].name,
-                   task_table[i].pid, task_table[i].parent,
+    int page_count = memory_page_count_used(task->task_sw.page_dir);
+    kernel_sprintf(task_buf, "%s\t%d\t%d\t%dMB-%dKB.\t%d/%dB", task->name,
+                   task->pid, task->parent,
                    page_count * MEM_PAGE_SIZE / (1024 * 1024),
-                   ((page_count * MEM_PAGE_SIZE) % (1024 * 1024)) / 1024);
+                   ((page_count * MEM_PAGE_SIZE) % (1024 * 1024)) / 1024,
+                   svc_stack_used(task), TASK_SVC_STACK_SIZE);
 
     int buf_len = kernel_strlen(task_buf);
     size -= buf_len;
     if (size <= 0) {
+      mutex_unlock(&task_list_mutex);
       *task_count = task_cnt;
       return -1;
     }
@@ -1133,6 +1412,7 @@ int sys_task_stat(char *buf, int size, int *task_count) {
 
     task_cnt++;
   }
+  mutex_unlock(&task_list_mutex);
 
   *task_count = task_cnt;
 
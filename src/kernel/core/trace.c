@@ -0,0 +1,120 @@
+/**
+ * @file trace.c
+ * @author kbpoyo (kbpoyo@qq.com)
+ * @brief 内核事件跟踪，记录写入每次启动独立的环形缓冲区，写满后覆盖最旧的记录
+ * @version 0.1
+ * @date 2023-09-17
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#include "core/trace.h"
+
+#include "common/cpu_instr.h"
+#include "core/irq.h"
+#include "core/mmap.h"
+#include "core/task.h"
+#include "dev/timer.h"
+#include "tools/klib.h"
+#include "tools/log.h"
+
+// 事件使能掩码，第n位为1时记录事件n
+uint32_t trace_mask = 0;
+
+// 跟踪记录环形缓冲区
+static trace_record_t trace_buf[TRACE_BUF_COUNT];
+// 已写入的记录总数，单调递增，对TRACE_BUF_COUNT取余得到写入位置
+static uint32_t trace_seq = 0;
+
+/**
+ * @brief 写入一条跟踪记录，可在中断处理程序中调用
+ *
+ * @param event
+ * @param arg0
+ * @param arg1
+ */
+void trace_record(int event, uint32_t arg0, uint32_t arg1) {
+  cpu_state_t state = task_enter_protection();
+
+  trace_record_t *record = trace_buf + (trace_seq++ % TRACE_BUF_COUNT);
+  task_t *curr = task_current();
+
+  record->time = timer_get_count();
+  record->event = event;
+  // 中断入口切换到了svc模式，不能通过cpsr的模式位判断是否在中断中
+  record->flags = irq_in_interrupt() ? TRACE_FLAG_IRQ : 0;
+  record->pid = curr ? curr->pid : 0;
+  record->arg0 = arg0;
+  record->arg1 = arg1;
+
+  task_leave_protection(state);
+}
+
+/**
+ * @brief 将最近的最多count条记录按时间顺序拷贝到buf中，拷贝期间暂停记录
+ *
+ * @param buf
+ * @param count
+ * @return int 拷贝的记录条数
+ */
+static int trace_read(trace_record_t *buf, int count) {
+  if (count > TRACE_BUF_COUNT) {
+    count = TRACE_BUF_COUNT;
+  }
+
+  // buf位于用户空间，在停止记录之前使其可写，避免写入文件映射区共享的页缓存
+  if (mmap_prepare_write((uint32_t)buf, count * sizeof(trace_record_t)) < 0) {
+    return -1;
+  }
+
+  uint32_t mask = trace_mask;
+  trace_mask = 0;
+
+  uint32_t total = trace_seq < TRACE_BUF_COUNT ? trace_seq : TRACE_BUF_COUNT;
+  if (count > total) {
+    count = total;
+  }
+
+  // buf可能位于用户空间，拷贝时不能关中断
+  uint32_t start = trace_seq - count;
+  for (int i = 0; i < count; ++i) {
+    kernel_memcpy(buf + i, trace_buf + (start + i) % TRACE_BUF_COUNT,
+                  sizeof(trace_record_t));
+  }
+
+  trace_mask = mask;
+  return count;
+}
+
+/**
+ * @brief 控制内核事件跟踪
+ *
+ * @param cmd TRACE_CMD_SET_MASK，TRACE_CMD_READ，TRACE_CMD_CLEAR
+ * @param arg0
+ * @param arg1
+ * @return int -1：失败
+ */
+int sys_trace(int cmd, int arg0, int arg1) {
+  switch (cmd) {
+    case TRACE_CMD_SET_MASK: {
+      uint32_t old_mask = trace_mask;
+      trace_mask = (uint32_t)arg0 & TRACE_MASK_ALL;
+      return old_mask;
+    }
+    case TRACE_CMD_READ:
+      if (!arg0 || arg1 < 0) {
+        return -1;
+      }
+      return trace_read((trace_record_t *)arg0, arg1);
+    case TRACE_CMD_CLEAR: {
+      cpu_state_t state = task_enter_protection();
+      trace_seq = 0;
+      task_leave_protection(state);
+      return 0;
+    }
+    default:
+      log_printf("trace: unknown cmd %d\n", cmd);
+      return -1;
+  }
+}
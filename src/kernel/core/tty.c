@@ -11,16 +11,28 @@
 
 #include "core/tty.h"
 
+#include <sys/file.h>
+
 #include "core/dev.h"
 #include "core/irq.h"
+#include "core/mmap.h"
 #include "core/task.h"
 #include "dev/uart.h"
+#include "fs/devfs/devfs.h"
+#include "fs/poll.h"
+#include "tools/klib.h"
 #include "tools/log.h"
 
 static tty_t tty_table[TTY_TABLE_SIZE];  // 全局tty设备表
 static int curr_tty_index __attribute__((section(".data"), aligned(4))) =
     0;  // 系统当前使用tty设备索引
 
+// 退格时输出的控制序列，光标左移一格，用空格覆盖后再左移一格
+static const char tty_erase_seq[] = "\x1b[1D \x1b[1D";
+#define TTY_ERASE_LEN (sizeof(tty_erase_seq) - 1)
+
+static void tty_in_timeout(void *arg);
+
 /**
  * @brief 根据dev结构获取到对应的tty设备结构
  *
@@ -38,177 +50,343 @@ static tty_t *get_tty(device_t *dev) {
 }
 
 /**
- * @brief 初始化tty设备的缓冲队列
+ * @brief 打开tty设备
  *
- * @param fifo
- * @param buf
- * @param size
  */
-static void tty_fifo_init(tty_fifo_t *fifo, char *buf, int size) {
-  fifo->buf = buf;
-  fifo->count = 0;
-  fifo->size = size;
-  fifo->read = fifo->write = 0;
+int tty_open(device_t *dev) {
+  int index = dev->dev_index;
+  if (index < 0 || index >= TTY_TABLE_SIZE) {
+    log_printf("open tty failed. incorrect tty num = %d\n", index);
+    return -1;
+  }
+
+  tty_t *tty = tty_table + index;
+  // 初始化输入输出缓冲队列
+  ring_init(&tty->out_fifo, tty->out_buf, TTY_OBUF_SIZE);
+  ring_init(&tty->echo_fifo, tty->echo_buf, TTY_EBUF_SIZE);
+  ring_init(&tty->in_fifo, tty->in_buf, TTY_IBUF_SIZE);
+  mutex_init(&tty->out_mutex);
+  mutex_set_name(&tty->out_mutex, "tty_out");
+  mutex_init(&tty->in_mutex);
+
+  // 初始化缓冲区的信号量，只用于等待，是否可读写由缓冲队列本身判断
+  // 只统计输出信号量，in_sem上的等待是在等用户输入，不是竞争，不设置名称
+  sem_init(&tty->out_sem, 0);
+  sem_set_name(&tty->out_sem, "tty_out_space");
+  sem_init(&tty->in_sem, 0);
+  tty->out_waiting = 0;
+  tty->in_waiting = 0;
+  wait_queue_init(&tty->poll_queue);
+
+  ktimer_init(&tty->in_timer, tty_in_timeout, tty);
+  tty->in_timeout = 0;
+  tty->line_len = 0;
+  tty->line_done = 0;
+
+  // 为tty设备绑定输出终端
+  tty->console_index = index;
+  // 默认开启输出模式下'\n'转换为'\r\n'的模式，以及输入模式下的换行转换、字符回显与规范模式
+  tty->mode.oflags = TTY_OCRLF;
+  tty->mode.iflags = TTY_INCLR | TTY_IECHO | TTY_ICANON;
+  tty->mode.vmin = 1;
+  tty->mode.vtime = 0;
+
+  // 初始化tty设备需要的键盘与终端
+  uart_init(index);
+  return 0;
 }
 
 /**
- * @brief 往缓冲队列fifo中写入字符c
+ * @brief 按输出模式转换一个字符
  *
- * @param fifo
+ * @param tty
  * @param c
- * @return int
+ * @param out 转换结果，至少有TTY_ERASE_LEN字节的空间
+ * @return int 转换结果的字节数
  */
-int tty_fifo_put(tty_fifo_t *fifo, char c) {
-  // TODO:加锁
-  cpu_state_t state = task_enter_protection();
-
-  // fifo已满，不能再写入
-  if (fifo->count >= fifo->size) {
-    // TODO:解锁
-    task_leave_protection(state);
-    return -1;
+static int tty_out_translate(tty_t *tty, char c, uint8_t *out) {
+  // 退格输出为清除前一个字符的控制序列
+  if (c == 0x7f) {
+    kernel_memcpy(out, (void *)tty_erase_seq, TTY_ERASE_LEN);
+    return TTY_ERASE_LEN;
   }
 
-  fifo->buf[fifo->write++] = c;     // 写入一个字符
-  if (fifo->write >= fifo->size) {  // 循环队列的方式写入
-    fifo->write = 0;
+  // 当前输出为"\r\n"换行模式
+  if (c == '\n' && (tty->mode.oflags & TTY_OCRLF)) {
+    out[0] = '\r';
+    out[1] = '\n';
+    return 2;
   }
 
-  fifo->count++;
+  out[0] = c;
+  return 1;
+}
 
-  // 开中断取消资源保护
-  // TODO:解锁
+/**
+ * @brief 在关中断的情况下判断输出队列是否已满，已满则等待发送中断空出位置
+ *
+ * @param tty
+ */
+static void tty_out_sleep(tty_t *tty) {
+  cpu_state_t state = task_enter_protection();
+  if (ring_free(&tty->out_fifo) == 0) {
+    tty->out_waiting++;
+    sem_wait(&tty->out_sem);
+  }
   task_leave_protection(state);
-  return 0;
 }
 
 /**
- * @brief 从缓冲队列fifo中读取一个字符放到c中
+ * @brief 输出队列空出位置后唤醒所有等待写入的任务，由输出队列的消费者调用
  *
- * @param fifo
- * @param c
- * @return int
+ * @param tty
  */
-int tty_fifo_get(tty_fifo_t *fifo, char *c) {
-  // TODO:加锁关中断进行资源保护
-  cpu_state_t state = task_enter_protection();
+void tty_out_wakeup(tty_t *tty) {
+  while (tty->out_waiting) {
+    tty->out_waiting--;
+    sem_notify(&tty->out_sem);
+  }
+
+  wait_queue_wakeup(&tty->poll_queue);
+}
+
+/**
+ * @brief 将已转换的字符成批放入输出队列，队列写满时启动发送并等待
+ *
+ * @param tty
+ * @param buf
+ * @param size
+ */
+static void tty_out_put(tty_t *tty, const uint8_t *buf, int size) {
+  while (size) {
+    int count = ring_put_bulk(&tty->out_fifo, buf, size);
+    buf += count;
+    size -= count;
+
+    if (size) {
+      // 输出队列已满，启动发送，由发送中断消耗缓冲区后再写
+      uart_write(tty);
+      tty_out_sleep(tty);
+    }
+  }
+}
+
+/**
+ * @brief 写入tty设备
+ *
+ * @param addr 文件的打开标志，设置O_NONBLOCK时只写入输出队列能立即容纳的字符
+ * @return int 写入的字节数，非阻塞模式下一个字节都无法写入时返回-1
+ */
+int tty_write(device_t *dev, int addr, char *buf, int size) {
+  if (size < 0) {
+    return -1;
+  }
 
-  if (fifo->count <= 0) {
-    // TODO:解锁
-    task_leave_protection(state);
+  // 根据dev结构获取到对应的tty设备结构
+  tty_t *tty = get_tty(dev);
+  if (!tty) {
     return -1;
   }
 
-  *c = fifo->buf[fifo->read++];    // 读取一个字符
-  if (fifo->read >= fifo->size) {  // 循环队列的方式读取
-    fifo->read = 0;
+  // 多个任务同时写入时互斥，保证输出队列只有一个生产者
+  mutex_lock(&tty->out_mutex);
+
+  // 1.在暂存区中成批转换字符，暂存区将满时整批放入输出队列
+  int nonblock = addr & O_NONBLOCK;
+  uint8_t stage[TTY_OSTAGE_SIZE];
+  int count = 0;
+  int i;
+  for (i = 0; i < size; ++i) {
+    if (count > TTY_OSTAGE_SIZE - TTY_ERASE_LEN) {
+      tty_out_put(tty, stage, count);
+      count = 0;
+    }
+
+    int len = tty_out_translate(tty, buf[i], stage + count);
+    // 非阻塞模式下，当前为输出队列的唯一生产者，空闲空间只会增加，
+    // 已暂存的字符与该字符都能放入时才接收该字符，之后放入队列不会等待
+    if (nonblock && (uint32_t)(count + len) > ring_free(&tty->out_fifo)) {
+      break;
+    }
+    count += len;
   }
+  tty_out_put(tty, stage, count);
 
-  fifo->count--;
+  // 2.启动串口发送，由发送中断从输出队列中取出字符写入发送FIFO
+  uart_write(tty);
 
-  // TODO:解锁
+  mutex_unlock(&tty->out_mutex);
+  return (i == 0 && size) ? -1 : i;
+}
+
+/**
+ * @brief 回显一个输入的字符，在串口接收的下半部中调用，回显队列满时丢弃
+ *
+ * @param tty
+ * @param ch
+ */
+static void tty_echo(tty_t *tty, char ch) {
+  if (!(tty->mode.iflags & TTY_IECHO)) {
+    return;
+  }
+
+  uint8_t out[TTY_ERASE_LEN];
+  int count = tty_out_translate(tty, ch, out);
+  if (ring_free(&tty->echo_fifo) >= (uint32_t)count) {
+    ring_put_bulk(&tty->echo_fifo, out, count);
+  }
+}
+
+/**
+ * @brief 在关中断的情况下判断输入队列是否为空，为空则等待输入或超时
+ *
+ * @param tty
+ */
+static void tty_in_sleep(tty_t *tty) {
+  cpu_state_t state = task_enter_protection();
+  if (ring_count(&tty->in_fifo) == 0 && !tty->in_timeout) {
+    tty->in_waiting++;
+    sem_wait(&tty->in_sem);
+  }
   task_leave_protection(state);
-  return 0;
 }
 
 /**
- * @brief 打开tty设备
+ * @brief 唤醒所有等待输入的任务，在串口接收的下半部或定时器的下半部中调用
  *
+ * @param tty
  */
-int tty_open(device_t *dev) {
-  int index = dev->dev_index;
-  if (index < 0 || index >= TTY_TABLE_SIZE) {
-    log_printf("open tty failed. incorrect tty num = %d\n", index);
-    return -1;
+static void tty_in_wakeup(tty_t *tty) {
+  while (tty->in_waiting) {
+    tty->in_waiting--;
+    sem_notify(&tty->in_sem);
   }
+}
 
-  tty_t *tty = tty_table + index;
-  // 初始化输入输出缓冲队列
-  tty_fifo_init(&tty->out_fifo, tty->out_buf, TTY_OBUF_SIZE);
-  tty_fifo_init(&tty->in_fifo, tty->in_buf, TTY_IBUF_SIZE);
+/**
+ * @brief 输入队列中有新数据，唤醒等待读取的任务与poll的等待者
+ *
+ * @param tty
+ */
+static void tty_in_ready(tty_t *tty) {
+  tty_in_wakeup(tty);
+  wait_queue_wakeup(&tty->poll_queue);
+}
 
-  // 初始化缓冲区的信号量, 缓冲区的每一个字节都视为资源
-  sem_init(&tty->out_sem,
-           TTY_OBUF_SIZE);  // 输出缓冲区一开始有TTY_OBUF_SIZE大小的资源可写
-  sem_init(&tty->in_sem, 0);  // 输入缓冲区一开始无资源可读
+/**
+ * @brief vtime超时定时器的回调函数
+ *
+ * @param arg
+ */
+static void tty_in_timeout(void *arg) {
+  tty_t *tty = (tty_t *)arg;
+  tty->in_timeout = 1;
+  tty_in_wakeup(tty);
+}
 
-  // 为tty设备绑定输出终端
-  tty->console_index = index;
-  tty->oflags = TTY_OCRLF;  // 默认开启输出模式下'\n'转换为'\r\n'的模式
-  tty->iflags =
-      TTY_INCLR | TTY_IECHO;  // 默认开启输入模式下的换行转换和字符回显
+/**
+ * @brief 将行缓存中的整行放入输入队列，唤醒等待的任务
+ *        输入队列放不下整行时不放入，避免读取者得到没有换行符的半行
+ *
+ * @param tty
+ * @return int 0：已放入，-1：输入队列空间不足
+ */
+static int tty_line_commit(tty_t *tty) {
+  if (ring_free(&tty->in_fifo) < (uint32_t)tty->line_len) {
+    tty->line_done = 1;
+    return -1;
+  }
 
-  // 初始化tty设备需要的键盘与终端
-  uart_init(index);
+  ring_put_bulk(&tty->in_fifo, tty->line_buf, tty->line_len);
+  tty->line_len = 0;
+  tty->line_done = 0;
+  tty_in_ready(tty);
   return 0;
 }
 
 /**
- * @brief 写入tty设备
+ * @brief 读取者取走数据后调用，放入之前因输入队列空间不足而保留在行缓存中的行
  *
+ * @param tty
  */
-int tty_write(device_t *dev, int addr, char *buf, int size) {
-  if (size < 0) {
-    return -1;
+static void tty_line_retry(tty_t *tty) {
+  cpu_state_t state = task_enter_protection();
+  if (tty->line_done) {
+    tty_line_commit(tty);
   }
+  task_leave_protection(state);
+}
 
-  // 根据dev结构获取到对应的tty设备结构
-  tty_t *tty = get_tty(dev);
-  if (!tty) {
-    return -1;
+/**
+ * @brief 规范模式下读取，等待完整的一行，一次最多读取到换行符为止
+ *
+ * @param tty
+ * @param buf
+ * @param size
+ * @return int
+ */
+static int tty_read_canon(tty_t *tty, char *buf, int size) {
+  while (ring_count(&tty->in_fifo) == 0) {
+    tty_in_sleep(tty);
   }
 
   int len = 0;
-  while (size) {
-    // 获取待写入字符
-    char c = *(buf++);
-
-    // 当前输出为"\r\n"换行模式，
-    if (c == '\n' && (tty->oflags & TTY_OCRLF)) {
-      sem_wait(&tty->out_sem);
-      int err = tty_fifo_put(&tty->out_fifo, '\r');
-      if (err < 0) {
-        break;
-      }
+  uint8_t ch;
+  while (len < size && ring_get(&tty->in_fifo, &ch) == 0) {
+    buf[len++] = ch;
+    if (ch == '\n') {
+      break;
     }
+  }
 
-    if (c == 0x7f) {  // 进行退格处理
-      char *str = "\x1b[1D \x1b[1";
-      for (int i = 0; i < 8; ++i) {
-        sem_wait(&tty->out_sem);
-        int err = tty_fifo_put(&tty->out_fifo, str[i]);
-        if (err < 0) {
-          break;
-        }
-      }
-      c = 'D';
-    }
+  return len;
+}
 
-    // 先获取到访问缓冲区一个字节资源的资格
-    // 若缓冲区写满就阻塞住，等待中断程序将缓冲区消耗掉再写
-    sem_wait(&tty->out_sem);
+/**
+ * @brief 非规范模式下读取，按vmin与vtime决定返回时机
+ *
+ * @param tty
+ * @param buf
+ * @param size
+ * @return int
+ */
+static int tty_read_raw(tty_t *tty, char *buf, int size) {
+  int min = tty->mode.vmin < size ? tty->mode.vmin : size;
+  uint32_t time_ms = tty->mode.vtime * TTY_VTIME_MS;
+  int need = min ? min : 1;
+  int len = 0;
+
+  // vmin为0时从开始读取时计时，否则在每次读到字符后重新计时
+  if (min == 0 && time_ms) {
+    ktimer_start_ms(&tty->in_timer, time_ms);
+  }
 
-    int err = tty_fifo_put(&tty->out_fifo, c);
-    if (err < 0) {
+  while (1) {
+    int count =
+        ring_get_bulk(&tty->in_fifo, (uint8_t *)buf + len, size - len);
+    len += count;
+
+    if (len >= need || tty->in_timeout || (min == 0 && time_ms == 0)) {
       break;
     }
 
-    len++;
-    size--;
+    if (count && time_ms) {
+      tty->in_timeout = 0;
+      ktimer_start_ms(&tty->in_timer, time_ms);
+    }
 
-    // 显示器直接写显存，不需要写io端口
-    // 所以不需要交给中断处理程序，即当前进程自己往缓冲区写入并读取
-    // 此处是为了模仿当前进程对缓冲区写入的同时中断处理程序读取缓冲区
-    // 此处肯定不会阻塞在信号量中，但利用中断处理程序就会阻塞
-    uart_write(tty);
+    tty_in_sleep(tty);
   }
 
+  ktimer_cancel(&tty->in_timer);
   return len;
 }
 
 /**
- * @brief 读取读取设备
+ * @brief 读取tty设备
  *
+ * @param addr 文件的打开标志，设置O_NONBLOCK时只读取输入队列中已有的字符
+ * @return int 读取的字节数，非阻塞模式下没有字符可读时返回-1
  */
 int tty_read(device_t *dev, int addr, char *buf, int size) {
   if (size < 0) {
@@ -217,64 +395,63 @@ int tty_read(device_t *dev, int addr, char *buf, int size) {
 
   // 1.获取操作的tty设备
   tty_t *tty = get_tty(dev);
+  if (!tty) {
+    return -1;
+  }
 
-  char *pbuf = buf;
-  int len = 0;
-
-  // 2.从输入缓冲队列中读取字符到缓冲区buf中
-  while (len < size) {
-    // 2.1等待资源就绪
-    sem_wait(&tty->in_sem);
+  if (size == 0) {
+    return 0;
+  }
 
-    // 2.2资源已就绪，读取一个字符
-    char ch;
-    tty_fifo_get(&tty->in_fifo, &ch);
-    switch (ch) {
-      case 0x7f:  // 退格键不读取并删除buf中上一个读取到的字符
-        if (len == 0) {
-          continue;
-        } else {
-          len--;
-          *(--pbuf) = '\0';
-        }
-        break;
-      case '\n':
-        if ((tty->iflags & TTY_INCLR) && len < size - 1) {
-          // 开启了换行转换
-          *(pbuf++) = '\r';
-          len++;
-        }
-        *(pbuf++) = '\n';
-        len++;
-        break;
-      case '\r':
-        if ((tty->iflags & TTY_INCLR) && len < size - 1) {
-          // 开启了换行转换
-          *(pbuf++) = '\r';
-          len++;
-          ch = '\n';
-        }
-        *(pbuf++) = '\n';
-        len++;
-        break;
-      default:
-        *(pbuf++) = ch;
-        len++;
-        break;
+  // 2.多个任务同时读取时互斥，保证输入队列只有一个消费者
+  mutex_lock(&tty->in_mutex);
+  tty->in_timeout = 0;
+
+  // 3.按当前模式从输入缓冲队列中读取字符，行编辑与回显已在输入时完成
+  int len;
+  if (addr & O_NONBLOCK) {
+    // 非阻塞模式下不等待vmin与vtime，输入队列中有字符时两种模式都不会睡眠
+    if (ring_count(&tty->in_fifo) == 0) {
+      len = -1;
+    } else if (tty->mode.iflags & TTY_ICANON) {
+      len = tty_read_canon(tty, buf, size);
+    } else {
+      len = ring_get_bulk(&tty->in_fifo, (uint8_t *)buf, size);
     }
+  } else {
+    len = (tty->mode.iflags & TTY_ICANON) ? tty_read_canon(tty, buf, size)
+                                          : tty_read_raw(tty, buf, size);
+  }
 
-    // 若tty设备开启了回显模式，则将输入回显到设备上
-    if (tty->iflags & TTY_IECHO) {
-      tty_write(dev, 0, &ch, 1);
-    }
+  // 4.输入队列已空出位置，放入等待中的行
+  tty_line_retry(tty);
 
-    // 若输入回车或者换行则直接停止读取
-    if (ch == '\n' || ch == '\r') {
-      break;
-    }
+  mutex_unlock(&tty->in_mutex);
+  return len;
+}
+
+/**
+ * @brief 设置tty的工作模式，离开规范模式时将行缓存中未完成的行交给读取者
+ *
+ * @param tty
+ * @param mode
+ * @return int
+ */
+static int tty_set_mode(tty_t *tty, tty_mode_t *mode) {
+  if (!mode || mode->vmin < 0 || mode->vmin > TTY_IBUF_SIZE ||
+      mode->vtime < 0) {
+    return -1;
   }
 
-  return len;
+  // 关中断，防止串口接收的下半部在切换过程中按旧模式处理输入
+  cpu_state_t state = task_enter_protection();
+  if (!(mode->iflags & TTY_ICANON) && tty->line_len) {
+    tty_line_commit(tty);
+  }
+  kernel_memcpy(&tty->mode, mode, sizeof(tty_mode_t));
+  task_leave_protection(state);
+
+  return 0;
 }
 
 /**
@@ -283,25 +460,65 @@ int tty_read(device_t *dev, int addr, char *buf, int size) {
  */
 int tty_control(device_t *dev, int cmd, int arg0, int arg1) {
   tty_t *tty = get_tty(dev);
+  if (!tty) {
+    return -1;
+  }
+
   switch (cmd) {
     case TTY_CMD_ECHO:  // 对tty回显进行设置
       if (arg0) {
-        tty->iflags |= TTY_IECHO;
+        tty->mode.iflags |= TTY_IECHO;
       } else {
-        tty->iflags &= ~TTY_IECHO;
+        tty->mode.iflags &= ~TTY_IECHO;
       }
       break;
-    case TTY_CMD_IN_COUNT:  // 获取tty输入缓冲区的字符个数
-      if (arg0) {
-        *(int *)arg0 = sem_count(&tty->in_sem);
+    case TTY_CMD_IN_COUNT: {  // 获取tty输入缓冲区中可读取的字符个数
+      int count = ring_count(&tty->in_fifo);
+      if (arg0 && copy_to_user((void *)arg0, &count, sizeof(int)) < 0) {
+        return -1;
       }
       break;
+    }
+    case TTY_CMD_GET_MODE:  // 获取tty的工作模式
+      if (!arg0 ||
+          copy_to_user((void *)arg0, &tty->mode, sizeof(tty_mode_t)) < 0) {
+        return -1;
+      }
+      break;
+    case TTY_CMD_SET_MODE:  // 设置tty的工作模式
+      return tty_set_mode(tty, (tty_mode_t *)arg0);
     default:
       break;
   }
   return 0;
 }
 
+/**
+ * @brief 获取tty设备当前的可读写状态，规范模式下有完整的一行时才可读
+ *
+ */
+int tty_poll(device_t *dev, wait_entry_t *entry) {
+  tty_t *tty = get_tty(dev);
+  if (!tty) {
+    return POLLERR;
+  }
+
+  // 先加入等待队列再检查状态，检查之后到达的输入也会唤醒等待者
+  if (entry) {
+    wait_queue_add(&tty->poll_queue, entry);
+  }
+
+  int mask = 0;
+  if (ring_count(&tty->in_fifo)) {
+    mask |= POLLIN;
+  }
+  if (ring_free(&tty->out_fifo)) {
+    mask |= POLLOUT;
+  }
+
+  return mask;
+}
+
 /**
  * @brief 关闭tty设备
  *
@@ -309,26 +526,61 @@ int tty_control(device_t *dev, int cmd, int arg0, int arg1) {
 void tty_close(device_t *dev) {}
 
 /**
- * @brief 将字符放入对应索引的tty设备的输入缓冲队列中
+ * @brief 对当前tty设备的输入进行行规程处理，在串口接收的下半部中逐字节调用
+ *        规范模式下在行缓存中编辑，输入换行时整行放入输入队列并唤醒读取者，
+ *        非规范模式下直接放入输入队列
  *
- * @param dev_index
  * @param ch
  */
 void tty_in(char ch) {
   // 1.获取tty设备
   tty_t *tty = tty_table + curr_tty_index;
 
-  // 2.判断输入缓冲区资源是否已准备满
-  if (sem_count(&tty->in_sem) >= TTY_IBUF_SIZE) {
-    // 输入缓冲区已写满，放弃写入
+  // 2.输入的回车转换为换行
+  if (ch == '\r' && (tty->mode.iflags & TTY_INCLR)) {
+    ch = '\n';
+  }
+
+  // 行缓存中有等待放入的行时先放入，保证输入的顺序，仍放不下时丢弃新的字符
+  if (tty->line_done && tty_line_commit(tty) < 0) {
+    return;
+  }
+
+  // 3.非规范模式，串口接收的下半部是输入队列唯一的生产者，无需关中断
+  if (!(tty->mode.iflags & TTY_ICANON)) {
+    if (ring_put(&tty->in_fifo, ch) < 0) {
+      // 输入缓冲区已写满，放弃写入
+      return;
+    }
+    tty_echo(tty, ch);
+    tty_in_ready(tty);
+    uart_echo(tty);
     return;
   }
 
-  // 3.将字符写入输入缓冲队列
-  tty_fifo_put(&tty->in_fifo, ch);
+  // 4.规范模式，在行缓存中编辑
+  switch (ch) {
+    case 0x7f:
+    case '\b':  // 删除行缓存中上一个字符
+      if (tty->line_len > 0) {
+        tty->line_len--;
+        tty_echo(tty, 0x7f);
+      }
+      break;
+    case '\n':  // 一行输入完成
+      tty->line_buf[tty->line_len++] = '\n';
+      tty_echo(tty, '\n');
+      tty_line_commit(tty);
+      break;
+    default:  // 为换行符保留一个位置，行缓存已满时丢弃
+      if (tty->line_len < TTY_LINE_SIZE - 1) {
+        tty->line_buf[tty->line_len++] = ch;
+        tty_echo(tty, ch);
+      }
+      break;
+  }
 
-  // 4.准备好一份可读资源，唤醒等待的进程或添加可获取资源
-  sem_notify(&tty->in_sem);
+  uart_echo(tty);
 }
 
 /**
@@ -350,4 +602,14 @@ dev_desc_t dev_tty_desc = {.dev_name = "tty",
                            .read = tty_read,
                            .write = tty_write,
                            .control = tty_control,
-                           .close = tty_close};
\ No newline at end of file
+                           .close = tty_close,
+                           .poll = tty_poll};
+
+/**
+ * @brief 注册tty设备，设备文件为tty0、tty1...
+ *
+ */
+void tty_init(void) {
+  dev_register(DEV_TTY, &dev_tty_desc);
+  devfs_register("tty", DEV_TTY, DEVFS_MINOR_ANY, FILE_TTY);
+}
\ No newline at end of file
@@ -0,0 +1,117 @@
+/**
+ * @file workqueue.c
+ * @author kbpoyo (kbpoyo@qq.com)
+ * @brief 工作队列
+ *        工作项在内核线程中执行，可以睡眠、等待信号量或访问磁盘，
+ *        用于中断处理函数与下半部中不便完成的耗时工作
+ * @version 0.1
+ * @date 2023-09-20
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#include "core/workqueue.h"
+
+#include "tools/assert.h"
+#include "tools/log.h"
+
+// 系统默认的工作队列
+static workqueue_t system_wq;
+
+/**
+ * @brief 初始化工作项
+ *
+ * @param work
+ * @param func 工作函数
+ */
+void work_init(work_t *work, void (*func)(work_t *work)) {
+  list_node_init(&work->node);
+  work->func = func;
+  work->pending = 0;
+}
+
+/**
+ * @brief 工作队列内核线程，依次取出工作项并执行
+ *
+ * @param arg 所属的工作队列
+ */
+static void workqueue_worker(void *arg) {
+  workqueue_t *wq = (workqueue_t *)arg;
+
+  while (1) {
+    sem_wait(&wq->sem);
+
+    // 1.取出工作项，执行前清除等待标记，工作函数中可再次加入队列
+    cpu_state_t state = task_enter_protection();
+    list_node_t *node = list_remove_first(&wq->list);
+    task_leave_protection(state);
+    if (!node) {
+      continue;
+    }
+
+    work_t *work = list_node_parent(node, work_t, node);
+    work->pending = 0;
+
+    // 2.执行工作函数
+    work->func(work);
+  }
+}
+
+/**
+ * @brief 初始化工作队列并创建执行工作项的内核线程
+ *
+ * @param wq
+ * @param name 内核线程名称
+ * @return int 0：成功，-1：创建内核线程失败
+ */
+int workqueue_init(workqueue_t *wq, const char *name) {
+  list_init(&wq->list);
+  sem_init(&wq->sem, 0);
+
+  wq->worker = task_create_kernel(name, workqueue_worker, wq);
+  if (!wq->worker) {
+    log_error("create worker %s failed.\n", name);
+    return -1;
+  }
+
+  return 0;
+}
+
+/**
+ * @brief 将工作项加入工作队列，已在队列中等待执行的工作项不会重复加入
+ *
+ * @param wq
+ * @param work
+ * @return int 0：成功，-1：工作项已在队列中
+ */
+int work_queue(workqueue_t *wq, work_t *work) {
+  ASSERT(work->func != 0);
+
+  cpu_state_t state = task_enter_protection();
+  if (work->pending) {
+    task_leave_protection(state);
+    return -1;
+  }
+
+  work->pending = 1;
+  list_insert_last(&wq->list, &work->node);
+  sem_notify(&wq->sem);
+
+  task_leave_protection(state);
+  return 0;
+}
+
+/**
+ * @brief 将工作项加入系统默认的工作队列
+ *
+ * @param work
+ * @return int
+ */
+int work_schedule(work_t *work) { return work_queue(&system_wq, work); }
+
+/**
+ * @brief 创建系统默认的工作队列，需在第一个任务初始化后调用
+ *
+ */
+void workqueue_system_init(void) { workqueue_init(&system_wq, "kworker"); }
@@ -0,0 +1,253 @@
+/**
+ * @file dma.c
+ * @author kbpoyo (kbpoyo@qq.com)
+ * @brief S3C2440的4个通用DMA通道，提供通道分配、传输描述与完成通知
+ * @version 0.1
+ * @date 2023-09-22
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#include "dev/dma.h"
+
+#include "common/cpu_instr.h"
+#include "common/register_addr.h"
+#include "core/irq.h"
+#include "core/ktimer.h"
+#include "core/task.h"
+#include "tools/log.h"
+
+// 请求源在通道上的选择值，最高位标记该通道支持此请求源
+#define DMA_HWSRC(sel) (0x8 | (sel))
+#define DMA_HWSRC_SEL(v) ((v) & 0x7)
+
+// 各通道可连接的外设请求源
+static const uint8_t dma_hwsrc_table[DMA_CHANNEL_COUNT][DMA_REQ_COUNT] = {
+    {
+        [DMA_REQ_XDREQ0] = DMA_HWSRC(0),
+        [DMA_REQ_UART0] = DMA_HWSRC(1),
+        [DMA_REQ_SDI] = DMA_HWSRC(2),
+        [DMA_REQ_TIMER] = DMA_HWSRC(3),
+    },
+    {
+        [DMA_REQ_XDREQ1] = DMA_HWSRC(0),
+        [DMA_REQ_UART1] = DMA_HWSRC(1),
+        [DMA_REQ_I2SSDI] = DMA_HWSRC(2),
+        [DMA_REQ_SPI0] = DMA_HWSRC(3),
+    },
+    {
+        [DMA_REQ_I2SSDO] = DMA_HWSRC(0),
+        [DMA_REQ_I2SSDI] = DMA_HWSRC(1),
+        [DMA_REQ_SDI] = DMA_HWSRC(2),
+        [DMA_REQ_TIMER] = DMA_HWSRC(3),
+    },
+    {
+        [DMA_REQ_UART2] = DMA_HWSRC(0),
+        [DMA_REQ_SDI] = DMA_HWSRC(1),
+        [DMA_REQ_SPI1] = DMA_HWSRC(2),
+        [DMA_REQ_TIMER] = DMA_HWSRC(3),
+    },
+};
+
+// 内存传输选择通道的顺序，优先使用本系统外设用不到的通道，把串口0与SD卡能用的通道留给驱动
+static const int dma_mem_order[DMA_CHANNEL_COUNT] = {1, 3, 2, 0};
+
+static dma_chan_t dma_chan_table[DMA_CHANNEL_COUNT];
+
+/**
+ * @brief 传输写入了内存时，使目的地址范围内的数据cache无效
+ *
+ * @param chan
+ */
+static void dma_sync_dst(dma_chan_t *chan) {
+  if (!(chan->flags & (DMA_DST_FIXED | DMA_DST_APB))) {
+    disable_dcache_range(chan->dst, chan->size);
+  }
+}
+
+/**
+ * @brief DMA中断处理函数，传输计数减到0时产生，调用传输的完成回调
+ *
+ */
+static void irq_handler_for_dma(void) {
+  int irq = rINTOFFSET;
+  irq_clear(irq, NOSUBINT);
+
+  dma_chan_t *chan = dma_chan_table + (irq - INT_DMA0);
+  dma_sync_dst(chan);
+
+  // 回调只调用一次，回调中可以启动下一次传输
+  void (*done)(void *arg) = chan->done;
+  chan->done = 0;
+  if (done) {
+    done(chan->arg);
+  }
+}
+
+/**
+ * @brief 初始化DMA通道
+ *
+ */
+void dma_init(void) {
+  log_printf("dma init start.....\n");
+
+  for (int i = 0; i < DMA_CHANNEL_COUNT; ++i) {
+    dma_chan_t *chan = dma_chan_table + i;
+    chan->index = i;
+    chan->owner = (const char *)0;
+    rDMASKTRIG(i) = DMASKTRIG_STOP;
+
+    irq_handler_register(INT_DMA0 + i, irq_handler_for_dma);
+    irq_clear(INT_DMA0 + i, NOSUBINT);
+    irq_enable(INT_DMA0 + i, NOSUBINT);
+  }
+
+  log_printf("dma init success.....\n");
+}
+
+/**
+ * @brief 分配一个能连接请求源req的空闲通道
+ *
+ * @param req
+ * @param owner 使用者名称
+ * @return dma_chan_t* 没有可用的通道时返回0
+ */
+dma_chan_t *dma_request(dma_req_t req, const char *owner) {
+  if (req < 0 || req >= DMA_REQ_COUNT) {
+    return (dma_chan_t *)0;
+  }
+
+  cpu_state_t state = task_enter_protection();
+  for (int i = 0; i < DMA_CHANNEL_COUNT; ++i) {
+    int index = req == DMA_REQ_MEM ? dma_mem_order[i] : i;
+    dma_chan_t *chan = dma_chan_table + index;
+    uint8_t hwsrc = dma_hwsrc_table[index][req];
+    if (chan->owner || (req != DMA_REQ_MEM && !hwsrc)) {
+      continue;
+    }
+
+    chan->owner = owner;
+    chan->hwsrc = req == DMA_REQ_MEM ? -1 : DMA_HWSRC_SEL(hwsrc);
+    chan->done = 0;
+    task_leave_protection(state);
+    return chan;
+  }
+  task_leave_protection(state);
+
+  log_error("no dma channel for %s.\n", owner);
+  return (dma_chan_t *)0;
+}
+
+/**
+ * @brief 停止通道上的传输并释放通道
+ *
+ * @param chan
+ */
+void dma_release(dma_chan_t *chan) {
+  dma_stop(chan);
+  chan->owner = (const char *)0;
+}
+
+/**
+ * @brief 在通道上启动一次传输，内存传输立即由软件触发，外设传输等待外设请求
+ *
+ * @param chan
+ * @param xfer
+ * @return int 0：成功，-1：参数错误或通道正忙
+ */
+int dma_start(dma_chan_t *chan, dma_xfer_t *xfer) {
+  if (xfer->count == 0 || xfer->count > DCON_COUNT_MAX || dma_busy(chan)) {
+    return -1;
+  }
+
+  // 1.记录本次传输，供中断处理函数使用
+  uint32_t width = (xfer->flags & DMA_WIDTH_MASK) >> 4;
+  chan->dst = xfer->dst;
+  chan->size = (xfer->count << width) << ((xfer->flags & DMA_BURST) ? 2 : 0);
+  chan->flags = xfer->flags;
+  chan->done = xfer->done;
+  chan->arg = xfer->arg;
+
+  // 2.设置控制寄存器，传输结束后关闭通道并产生中断
+  uint32_t dcon = DCON_HANDSHAKE | DCON_INT | DCON_NO_RELOAD |
+                  DCON_WIDTH(width) | xfer->count;
+  if (!(xfer->flags & (DMA_SRC_APB | DMA_DST_APB))) {
+    dcon |= DCON_SYNC_HCLK;
+  }
+  if (xfer->flags & DMA_BURST) {
+    dcon |= DCON_BURST;
+  }
+  if (chan->hwsrc < 0) {
+    dcon |= DCON_WHOLE;
+  } else {
+    dcon |= DCON_HW_REQ | DCON_HWSRC(chan->hwsrc);
+  }
+
+  // 3.内核空间为写通cache，源数据可能还在写缓冲区中
+  drain_write_buffer();
+
+  int i = chan->index;
+  rDISRC(i) = xfer->src;
+  rDISRCC(i) = ((xfer->flags & DMA_SRC_FIXED) ? DMA_ADDR_FIXED : 0) |
+               ((xfer->flags & DMA_SRC_APB) ? DMA_ADDR_APB : 0);
+  rDIDST(i) = xfer->dst;
+  rDIDSTC(i) = ((xfer->flags & DMA_DST_FIXED) ? DMA_ADDR_FIXED : 0) |
+               ((xfer->flags & DMA_DST_APB) ? DMA_ADDR_APB : 0);
+  rDCON(i) = dcon;
+
+  // 4.打开通道
+  rDMASKTRIG(i) = DMASKTRIG_ON | (chan->hwsrc < 0 ? DMASKTRIG_SW_TRIG : 0);
+  return 0;
+}
+
+/**
+ * @brief 通道是否正在传输
+ *
+ * @param chan
+ * @return int
+ */
+int dma_busy(dma_chan_t *chan) {
+  int i = chan->index;
+  return (rDMASKTRIG(i) & DMASKTRIG_ON) || (rDSTAT(i) & DSTAT_BUSY);
+}
+
+/**
+ * @brief 用于ktimer_wait的传输完成条件
+ *
+ * @param arg
+ * @return int
+ */
+static int dma_idle(void *arg) { return !dma_busy((dma_chan_t *)arg); }
+
+/**
+ * @brief 等待通道上的传输完成，等待期间其他任务可以运行，
+ *        直接读取通道状态，不依赖中断，关中断时也可使用
+ *
+ * @param chan
+ * @param timeout_us
+ * @return int 0：完成，-1：超时，传输已被停止
+ */
+int dma_wait(dma_chan_t *chan, uint32_t timeout_us) {
+  if (ktimer_wait(dma_idle, chan, timeout_us) < 0) {
+    log_error("dma%d timeout. owner = %s\n", chan->index, chan->owner);
+    dma_stop(chan);
+    return -1;
+  }
+
+  dma_sync_dst(chan);
+  return 0;
+}
+
+/**
+ * @brief 停止通道上的传输，不调用完成回调
+ *
+ * @param chan
+ */
+void dma_stop(dma_chan_t *chan) {
+  int i = chan->index;
+  chan->done = 0;
+  rDMASKTRIG(i) = DMASKTRIG_STOP;
+  while (rDMASKTRIG(i) & DMASKTRIG_ON)
+    ;
+}
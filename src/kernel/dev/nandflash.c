@@ -1,5 +1,6 @@
 #include "dev/nandflash.h"
 
+#include "core/ktimer.h"
 #include "tools/klib.h"
 #include "tools/log.h"
 
@@ -37,6 +38,29 @@ void nand_flash_init() {
   log_printf("nand_flash_success..\n");
 }
 
+/**
+ * @brief 检测RnB信号是否出现上升沿，作为ktimer_wait的等待条件
+ *
+ * @param arg
+ * @return int
+ */
+static int nand_rb_detected(void *arg) { return NF_RB_DETECTED(); }
+
+/**
+ * @brief 等待flash操作完成，等待期间睡眠
+ *
+ * @param timeout_us
+ * @return int 0：已完成，-1：超时
+ */
+static int nand_wait_rb(uint32_t timeout_us) {
+  if (ktimer_wait(nand_rb_detected, (void *)0, timeout_us) < 0) {
+    log_error("nand flash timeout, rNFSTAT = 0x%x.\n", rNFSTAT);
+    return -1;
+  }
+
+  return 0;
+}
+
 /**
  * @brief 发送页地址
  *
@@ -55,7 +79,7 @@ static void nand_reset() {
 
   NF_CMD(CMD_RESET);  // 写入复位命令
 
-  NF_DETECT_RB();  // 等待flash空闲
+  nand_wait_rb(NAND_RESET_TIMEOUT_US);  // 等待flash空闲
 
   NF_CE_CLOSE();  // 关闭片选
 }
@@ -93,7 +117,11 @@ int nand_read_page(uint32_t page_number, char *buf) {
 
   NF_CMD(CMD_READ2);  // 页读命令周期2
 
-  NF_DETECT_RB();  // 检测RnB信号上升沿跳变，即操作完成
+  // 检测RnB信号上升沿跳变，即操作完成
+  if (nand_wait_rb(NAND_READ_TIMEOUT_US) < 0) {
+    NF_CE_CLOSE();
+    return -1;
+  }
 
   // 读取一页数据内容
 
@@ -173,11 +201,14 @@ uint8_t nand_random_write(uint32_t page_number, uint32_t add, uint8_t dat) {
 
   NF_CMD(CMD_WRITE2);  // 页写命令周期2
 
-  NF_DETECT_RB();
+  if (nand_wait_rb(NAND_PROG_TIMEOUT_US) < 0) {
+    NF_CE_CLOSE();
+    return -1;
+  }
 
   NF_CMD(CMD_STATUS);  // 读状态命令
 
-  // 判断状态值的第6位是否为1，即是否在忙，该语句的作用与NF_DETECT_RB();相同
+  // 判断状态值的第6位是否为1，即是否在忙，该语句的作用与nand_wait_rb相同
 
   do {
     stat = NF_RDDATA8();
@@ -224,7 +255,7 @@ uint8_t nand_random_read(uint32_t page_number, uint32_t add) {
 
   NF_CMD(CMD_READ2);  // 页读命令周期2
 
-  NF_DETECT_RB();  // 等待RnB信号变高，即不忙
+  nand_wait_rb(NAND_READ_TIMEOUT_US);  // 等待RnB信号变高，即不忙
 
   NF_CMD(CMD_RANDOMREAD1);  // 随意读命令周期1
 
@@ -332,11 +363,15 @@ uint8_t nand_write_page(uint32_t page_number, const char *buf) {
 
   NF_CMD(CMD_WRITE2);  // 页写命令周期2
 
-  NF_DETECT_RB();  // 等待写入完成
+  // 等待写入完成
+  if (nand_wait_rb(NAND_PROG_TIMEOUT_US) < 0) {
+    NF_CE_CLOSE();
+    return ERR_WRITE;
+  }
 
   NF_CMD(CMD_STATUS);  // 读状态命令
 
-  // 判断状态值的第6位是否为1，即是否在忙，该语句的作用与NF_DETECT_RB();相同
+  // 判断状态值的第6位是否为1，即是否在忙，该语句的作用与nand_wait_rb相同
   do {
     stat = NF_RDDATA8();
 
@@ -388,7 +423,11 @@ int nand_block_erase(uint32_t page_number) {
   // 擦除命令2
   NF_CMD(CMD_ERASE2);
 
-  NF_DETECT_RB();  // 等待擦除完成
+  // 等待擦除完成
+  if (nand_wait_rb(NAND_ERASE_TIMEOUT_US) < 0) {
+    NF_CE_CLOSE();
+    return -1;
+  }
 
   NF_CMD(CMD_STATUS);  // 获取flash状态
 
@@ -4,23 +4,55 @@
 #include "common/register_addr.h"
 #include "common/types.h"
 #include "core/disk.h"
+#include "core/irq.h"
+#include "core/ktimer.h"
+#include "core/memory.h"
+#include "core/softirq.h"
+#include "core/task.h"
+#include "dev/dma.h"
+#include "ipc/sem.h"
+#include "tools/assert.h"
 #include "tools/log.h"
 
 #define INICLK 400000   // sd卡在初始化时的时钟频率为400khz
 #define SDCLK 25000000  // 25mhz
 
-#define POL 0
-#define INT 1
-#define DMA 2
-
 static sd_info_t sd_info = {.bus_width = 0, .block_cnt = 0, .block_size = 512};
 
-static void sdi_delay(uint32_t ms) {
-  for (uint32_t i = 0; i < ms; i++) {
-    for (uint32_t j = 0; j < 400; j++)
-      ;
-  }
-}
+// 中断方式传输的状态，中断处理函数在fifo与缓冲区之间搬运数据
+static struct {
+  uint8_t *buf;
+  uint32_t size;  // 需要传输的字节数
+  uint32_t done;  // 已传输的字节数
+  int write;      // 1：写入，0：读取
+  int finished;   // 传输已结束或超时
+  int err;
+
+  sem_t sem;       // 传输结束时唤醒等待的任务
+  ktimer_t timer;  // 超时定时器
+} sd_xfer;
+
+// 数据传输使用的DMA通道，为0时不使用DMA
+static dma_chan_t *sd_dma_chan;
+
+static void irq_handler_for_sdi(void);
+static void sd_xfer_timeout(void *arg);
+
+/**
+ * @brief 检测命令状态寄存器中的任一标志位是否置位，作为ktimer_wait的等待条件
+ *
+ * @param mask 标志位
+ * @return int
+ */
+static int sd_cmd_status(void *mask) { return rSDICSTA & (uint32_t)mask; }
+
+/**
+ * @brief 检测数据状态寄存器中的任一标志位是否置位，作为ktimer_wait的等待条件
+ *
+ * @param mask 标志位
+ * @return int
+ */
+static int sd_data_status(void *mask) { return rSDIDSTA & (uint32_t)mask; }
 
 int sd_init(void) {
   // 1.先配置SDLCK为400khz
@@ -40,7 +72,18 @@ int sd_init(void) {
   // 设置命令等待响应的超时时间
   rSDIDTIMER = 0x7fffff;
 
-  sdi_delay(1000);
+  // 数据传输通过中断或DMA完成，中断源在每次传输时按需打开
+  rSDIIMSK = 0;
+  sem_init(&sd_xfer.sem, 0);
+  ktimer_init(&sd_xfer.timer, sd_xfer_timeout, (void *)0);
+  irq_handler_register(INT_SDI, irq_handler_for_sdi);
+  irq_clear(INT_SDI, NOSUBINT);
+  irq_enable(INT_SDI, NOSUBINT);
+  if (!sd_dma_chan) {
+    sd_dma_chan = dma_request(DMA_REQ_SDI, "sd");
+  }
+
+  ktimer_sleep_ms(SD_POWER_UP_MS);
 
   if (sd_cmd0()) {
     log_printf("SD in idle.\n");
@@ -58,19 +101,26 @@ int sd_init(void) {
   }
 
   // 执行cmd2命令读取cid
-  do {
+  while (1) {
     SD_CMD_ARG(0);
     SD_CMD(2, 1, 1);  // cmd2，需要等待长响应
-  } while (!sd_check_cmd_end(2, 1));
+    if (sd_check_cmd_end(2, 1)) {
+      break;
+    }
+    ktimer_sleep_us(SD_RETRY_US);
+  }
 
   log_printf("SD read cid end.\n");
 
   // 执行cmd3命令读取RCA,并检测一并返回的状态寄存器csr的状态是否正确
-  do {
+  while (1) {
     SD_CMD_ARG(0);
     SD_CMD(3, 1, 0);
-
-  } while (!sd_check_cmd_end(3, 1) || (rSDIRSP0 & 0x1e00 != 0x600));
+    if (sd_check_cmd_end(3, 1) && !(rSDIRSP0 & 0x1e00 != 0x600)) {
+      break;
+    }
+    ktimer_sleep_us(SD_RETRY_US);
+  }
 
   sd_info.rca = (rSDIRSP0 & 0xffff0000) >> 16;
   log_printf("SD RCA=0x%x\n", sd_info.rca);
@@ -128,11 +178,14 @@ int sd_cmd8(void) {
  * @return int
  */
 int sd_cmd9(void) {
-  do {
+  while (1) {
     SD_CMD_ARG(sd_info.rca << 16);
     SD_CMD(9, 1, 1);
-
-  } while (!sd_check_cmd_end(9, 1));
+    if (sd_check_cmd_end(9, 1)) {
+      break;
+    }
+    ktimer_sleep_us(SD_RETRY_US);
+  }
 
   sd_info.block_size = 512;
   sd_info.block_cnt = ((((rSDIRSP1 & 0x3f) << 16) | (rSDIRSP2 >> 16)) + 1) *
@@ -156,6 +209,7 @@ int sd_cmd55(void) {
 
 /**
  * @brief 检测命令是否正常结束,若命令超时返回0
+ *        等待期间睡眠，超过SD_CMD_TIMEOUT_US仍未结束时视为超时
  *
  * @param cmd
  * @param be_resp
@@ -166,22 +220,27 @@ int sd_check_cmd_end(int cmd, int be_resp) {  // 0: Timeout
 
   if (!be_resp) {  // 命令不需要响应
 
-    finish0 = rSDICSTA;
-    while (!(finish0 & SD_CMDSTA_CmdSent)) {
-      // 检测命令发送完毕
-      finish0 = rSDICSTA;
+    // 检测命令发送完毕
+    if (ktimer_wait(sd_cmd_status, (void *)SD_CMDSTA_CmdSent,
+                    SD_CMD_TIMEOUT_US) < 0) {
+      log_error("CMD%d: send timeout, rSDICSTA=0x%x\n", cmd, rSDICSTA);
+      return 0;
     }
 
     // 清除命令结束状态
+    finish0 = rSDICSTA;
     rSDICSTA = finish0 & (~(uint32_t)0xff);
     return 1;
   } else {  // 命令需要响应
 
-    finish0 = rSDICSTA;
-    while (!((finish0 & SD_CMDSTA_RspFin) | (finish0 & SD_CMDSTA_CmdTout))) {
-      // 等待命令响应结束或超时
-      finish0 = rSDICSTA;
+    // 等待命令响应结束或超时
+    if (ktimer_wait(sd_cmd_status,
+                    (void *)(SD_CMDSTA_RspFin | SD_CMDSTA_CmdTout),
+                    SD_CMD_TIMEOUT_US) < 0) {
+      log_error("CMD%d: response timeout, rSDICSTA=0x%x\n", cmd, rSDICSTA);
+      return 0;
     }
+    finish0 = rSDICSTA;
 
     if (cmd == 1 | cmd == 41) {  // CRC no check, CMD9 is a long Resp. command.
       // cmd1和cmd41不需要检查CRC
@@ -220,6 +279,7 @@ int sd_sel_desel(char sel_desel) {
       SD_CMD(7, 1, 0);
 
       if (!sd_check_cmd_end(7, 1) || rSDIRSP0 & 0x1e00 != 0x800) {
+        ktimer_sleep_us(SD_RETRY_US);
         continue;
       } else {
         return 1;
@@ -231,6 +291,7 @@ int sd_sel_desel(char sel_desel) {
       SD_CMD(7, 0, 0);
 
       if (!sd_check_cmd_end(7, 0)) {
+        ktimer_sleep_us(SD_RETRY_US);
         continue;
       } else {
         return 1;
@@ -260,7 +321,7 @@ int sd_check_ocr(void) {
     if (sd_check_cmd_end(41, 1)) {
       uint32_t rsp = rSDIRSP0;
       if (!(rsp & SD_OCR_Power_UP)) {
-        sdi_delay(1000);
+        ktimer_sleep_ms(SD_OCR_RETRY_MS);
         continue;
       }
 
@@ -290,12 +351,15 @@ void sd_set_4bit_bus(void) {
  *
  */
 void sd_set_bus(void) {
-  do {
+  while (1) {
     sd_cmd55();
     SD_CMD_ARG(sd_info.bus_width << 1);
     SD_CMD(6, 1, 0);
-
-  } while (!sd_check_cmd_end(6, 1));
+    if (sd_check_cmd_end(6, 1)) {
+      break;
+    }
+    ktimer_sleep_us(SD_RETRY_US);
+  }
 }
 
 /**
@@ -304,11 +368,16 @@ void sd_set_bus(void) {
  * @return int
  */
 int sd_check_data_end(void) {
-  while (!(SD_DATSTA_IS_DatFin() | SD_DATSTA_IS_DatTout()))
-    ;
   // 检测数据传输结束或超时
   // 数据fifo在一定时间未被读取后，会将数据持续计数寄存器置0
   // 也会将数据状态寄存器的[4]位置1，代表数据读取结束
+  if (ktimer_wait(sd_data_status,
+                  (void *)(SD_DATSTA_DatFin | SD_DATSTA_DatTout),
+                  SD_DATA_TIMEOUT_US) < 0) {
+    log_error("DATA: end timeout, rSDIDSTA=0x%x\n", rSDIDSTA);
+    SD_DATSTA_RESET();
+    return 0;
+  }
 
   // 检测数据结束异常
   if (SD_DATSTA_IS_DatTout() || SD_DATSTA_IS_DatCrc() ||
@@ -330,8 +399,13 @@ int sd_check_data_end(void) {
  */
 int sd_check_busy_end(void) {
   // 检测忙信号结束和超时
-  while (!(SD_DATSTA_IS_BusyFin() | SD_DATSTA_IS_DatTout()))
-    ;
+  if (ktimer_wait(sd_data_status,
+                  (void *)(SD_DATSTA_BusyFin | SD_DATSTA_DatTout),
+                  SD_BUSY_TIMEOUT_US) < 0) {
+    log_error("DATA: busy timeout, rSDIDSTA=0x%x\n", rSDIDSTA);
+    SD_DATSTA_RESET();
+    return 0;
+  }
 
   // 检测忙信号结束异常
   if (SD_DATSTA_IS_DatTout() || SD_DATSTA_IS_DatCrc() ||
@@ -346,78 +420,295 @@ int sd_check_busy_end(void) {
   return 1;
 }
 
+/**
+ * @brief 从接收fifo中按字读出已接收的数据，最多读取size字节
+ *
+ * @param buf
+ * @param size
+ * @return uint32_t 读出的字节数
+ */
+static uint32_t sd_fifo_read(uint8_t *buf, uint32_t size) {
+  uint32_t count = SD_FIFO_COUNT();
+  if (count > size) {
+    count = size;
+  }
+  count &= ~3;
+
+  if (((uint32_t)buf & 3) == 0) {
+    uint32_t *p = (uint32_t *)buf;
+    for (uint32_t i = 0; i < count; i += 4) {
+      *(p++) = rSDIDAT;
+    }
+  } else {  // 缓冲区未按字对齐，逐字节拆分
+    for (uint32_t i = 0; i < count; i += 4) {
+      uint32_t data = rSDIDAT;
+      buf[i] = data;
+      buf[i + 1] = data >> 8;
+      buf[i + 2] = data >> 16;
+      buf[i + 3] = data >> 24;
+    }
+  }
+
+  return count;
+}
+
+/**
+ * @brief 按字向发送fifo的空闲空间写入数据，最多写入size字节
+ *
+ * @param buf
+ * @param size
+ * @return uint32_t 写入的字节数
+ */
+static uint32_t sd_fifo_write(const uint8_t *buf, uint32_t size) {
+  uint32_t count = SD_FIFO_SIZE - SD_FIFO_COUNT();
+  if (count > size) {
+    count = size;
+  }
+  count &= ~3;
+
+  if (((uint32_t)buf & 3) == 0) {
+    const uint32_t *p = (const uint32_t *)buf;
+    for (uint32_t i = 0; i < count; i += 4) {
+      rSDIDAT = *(p++);
+    }
+  } else {
+    for (uint32_t i = 0; i < count; i += 4) {
+      rSDIDAT = buf[i] | (buf[i + 1] << 8) | (buf[i + 2] << 16) |
+                (buf[i + 3] << 24);
+    }
+  }
+
+  return count;
+}
+
+/**
+ * @brief 结束中断方式的传输，唤醒等待的任务，传输结束与超时只有先到者生效
+ *
+ * @param err
+ */
+static void sd_xfer_finish(int err) {
+  cpu_state_t state = task_enter_protection();
+  if (!sd_xfer.finished) {
+    sd_xfer.finished = 1;
+    sd_xfer.err = err;
+    rSDIIMSK = 0;
+    sem_notify(&sd_xfer.sem);
+  }
+  task_leave_protection(state);
+}
+
+/**
+ * @brief 中断方式传输的超时处理，在定时器下半部中执行
+ *
+ * @param arg
+ */
+static void sd_xfer_timeout(void *arg) { sd_xfer_finish(-1); }
+
+/**
+ * @brief sd卡控制器中断处理函数，在fifo与缓冲区之间搬运数据
+ *        传输结束时不清除数据状态，由sd_check_data_end检查并清除
+ *
+ */
+static void irq_handler_for_sdi(void) {
+  ASSERT(rINTOFFSET == INT_SDI);
+
+  uint32_t state = rSDIDSTA;
+  if (sd_xfer.write) {
+    sd_xfer.done += sd_fifo_write(sd_xfer.buf + sd_xfer.done,
+                                  sd_xfer.size - sd_xfer.done);
+    if (sd_xfer.done == sd_xfer.size) {
+      // 数据已全部写入fifo，只等待传输结束
+      rSDIIMSK &= ~SD_IMSK_TFHalf;
+    }
+  } else {
+    sd_xfer.done += sd_fifo_read(sd_xfer.buf + sd_xfer.done,
+                                 sd_xfer.size - sd_xfer.done);
+  }
+
+  // 先屏蔽sd卡控制器的中断源，再清除中断控制器中的请求
+  if (state & (SD_DATSTA_DatTout | SD_DATSTA_DatCrc | SD_DATSTA_CrcSta)) {
+    sd_xfer_finish(-1);
+  } else if (state & SD_DATSTA_DatFin) {
+    sd_xfer_finish(0);
+  }
+
+  irq_clear(INT_SDI, NOSUBINT);
+}
+
+/**
+ * @brief 选择传输方式，只有内核一一映射空间中的缓冲区可交给DMA或中断处理函数访问，
+ *        用户空间的缓冲区在中断时可能不属于当前页表，只能轮询
+ *
+ * @param buf
+ * @param size
+ * @return int
+ */
+static int sd_xfer_mode(uint8_t *buf, uint32_t size) {
+  uint32_t addr = (uint32_t)buf;
+  if (addr < SDRAM_START || addr + size > MEM_EXT_END) {
+    return SD_XFER_POL;
+  }
+
+  // DMA按字传输，且不依赖中断，关中断时也可使用
+  if (sd_dma_chan && (addr & 3) == 0) {
+    return SD_XFER_DMA;
+  }
+
+  if (task_current() && !irq_in_interrupt() && !softirq_in_progress()) {
+    return SD_XFER_INT;
+  }
+
+  return SD_XFER_POL;
+}
+
+/**
+ * @brief 在数据命令发出前准备DMA或中断方式的传输
+ *
+ * @param mode
+ * @param buf
+ * @param size
+ * @param write
+ * @return int 0：成功，-1：失败
+ */
+static int sd_xfer_prepare(int mode, uint8_t *buf, uint32_t size, int write) {
+  if (mode == SD_XFER_DMA) {
+    dma_xfer_t xfer = {
+        .src = write ? (uint32_t)buf : SDIDAT,
+        .dst = write ? SDIDAT : (uint32_t)buf,
+        .count = size / 4,
+        .flags = DMA_WIDTH_32 |
+                 (write ? DMA_DST_FIXED | DMA_DST_APB
+                        : DMA_SRC_FIXED | DMA_SRC_APB),
+    };
+    return dma_start(sd_dma_chan, &xfer);
+  }
+
+  if (mode == SD_XFER_INT) {
+    sd_xfer.buf = buf;
+    sd_xfer.size = size;
+    sd_xfer.done = 0;
+    sd_xfer.write = write;
+    sd_xfer.finished = 0;
+    sd_xfer.err = 0;
+    sem_init(&sd_xfer.sem, 0);
+    irq_clear(INT_SDI, NOSUBINT);
+    rSDIIMSK = SD_IMSK_DatFin | SD_IMSK_DatErr |
+               (write ? SD_IMSK_TFHalf : SD_IMSK_RFHalf | SD_IMSK_RFLast);
+  }
+
+  return 0;
+}
+
+/**
+ * @brief 搬运数据并等待数据全部经过fifo
+ *
+ * @param mode
+ * @param buf
+ * @param size
+ * @param write
+ * @return uint32_t 传输的字节数
+ */
+static uint32_t sd_xfer_data(int mode, uint8_t *buf, uint32_t size,
+                             int write) {
+  uint32_t done = 0;
+
+  switch (mode) {
+    case SD_XFER_POL:
+      while (done < size) {
+        if (SD_DATSTA_IS_DatTout()) {  // 检测数据传输超时
+          SD_DATSTA_CLR_DatTout();     // 清除标志位
+          break;
+        }
+        done += write ? sd_fifo_write(buf + done, size - done)
+                      : sd_fifo_read(buf + done, size - done);
+      }
+      break;
+    case SD_XFER_INT:
+      // 睡眠等待中断处理函数完成传输
+      ktimer_start_us(&sd_xfer.timer, SD_DATA_TIMEOUT_US);
+      sem_wait(&sd_xfer.sem);
+      ktimer_cancel(&sd_xfer.timer);
+      done = sd_xfer.err < 0 ? 0 : sd_xfer.done;
+      break;
+    case SD_XFER_DMA:
+      done = dma_wait(sd_dma_chan, SD_DATA_TIMEOUT_US) < 0 ? 0 : size;
+      break;
+    default:
+      break;
+  }
+
+  return done;
+}
+
 /**
  * @brief sd卡读取块数据
  *
  */
 int sd_read_blocks(uint32_t first_block_addr, uint8_t *buf,
                    uint32_t block_cnt) {
-  if (block_cnt < 0 || block_cnt > SD_BLOCK_CNT_MAX) {
+  if (block_cnt == 0 || block_cnt > SD_BLOCK_CNT_MAX) {
     log_error("SD block count error!");
     return -1;
   }
 
+  uint32_t size = sd_info.block_size * block_cnt;
+  int mode = sd_xfer_mode(buf, size);
+
   // 重置fifo
   SD_FIFO_RSET();
 
+  if (sd_xfer_prepare(mode, buf, size, 0) < 0) {
+    mode = SD_XFER_POL;
+  }
+
   // 进行读操作
-  SD_DATCON_DO_READ(block_cnt);
+  SD_DATCON_DO_READ(block_cnt, mode == SD_XFER_DMA ? SD_DATCON_DMAEn : 0);
 
   // CMD17/18(addr), 读取的第一块地址
   SD_CMD_ARG(first_block_addr);
 
-  uint32_t read_cnt = 0;
-  switch (POL) {
-    case POL:
-      for (int i = 0; i < 50; ++i) {
-        if (block_cnt == 1) {  // 单块读取
-          // CMD17命令执行单块读取
-          SD_CMD(17, 1, 0);
-          if (!sd_check_cmd_end(17, 1)) {
-            continue;
-          }
-          break;
-        } else {  // 多块读取
-          // CMD18命令执行多块读取
-          SD_CMD(18, 1, 0);
-          if (!sd_check_cmd_end(18, 1)) {
-            continue;
-          }
-          break;
-        }
-      }
-
-      while (read_cnt < sd_info.block_size *
-                            block_cnt) {  // 读取block个块的数据即block*128个字
-        if (SD_DATSTA_IS_DatTout()) {  // 检测数据传输超时
-          SD_DATSTA_CLR_DatTout();     // 清除标志位
-          break;
-        }
-        if (SD_FIFO_CAN_READ()) {  // 检测FIFO中有数据
-          *(buf++) = rSDIDAT8;
-          read_cnt++;
-        }
+  for (int i = 0; i < 50; ++i) {
+    if (block_cnt == 1) {  // 单块读取
+      // CMD17命令执行单块读取
+      SD_CMD(17, 1, 0);
+      if (!sd_check_cmd_end(17, 1)) {
+        ktimer_sleep_us(SD_RETRY_US);
+        continue;
       }
       break;
-    default:
+    } else {  // 多块读取
+      // CMD18命令执行多块读取
+      SD_CMD(18, 1, 0);
+      if (!sd_check_cmd_end(18, 1)) {
+        ktimer_sleep_us(SD_RETRY_US);
+        continue;
+      }
       break;
+    }
   }
 
+  uint32_t read_cnt = sd_xfer_data(mode, buf, size, 0);
+
   // 检测数据是否传输结束
   if (!sd_check_data_end()) {
     log_error("sd read dat error!");
   }
 
+  rSDIIMSK = 0;
   // 清除数据控制寄存器各标志位
   SD_DATCON_RESET();
   // 清除Rx fifo 最后数据就绪位标志
   SD_FIFO_CLEAR_LAST();
 
   if (block_cnt > 1) {  // 多块读取需要CMD12指令结束
-    do {
+    while (1) {
       SD_CMD_ARG(0);
       SD_CMD(12, 1, 0);
-    } while (!sd_check_cmd_end(12, 1));
+      if (sd_check_cmd_end(12, 1)) {
+        break;
+      }
+      ktimer_sleep_us(SD_RETRY_US);
+    }
   }
 
   return read_cnt / sd_info.block_size;
@@ -429,71 +720,70 @@ int sd_read_blocks(uint32_t first_block_addr, uint8_t *buf,
  */
 int sd_write_blocks(uint32_t first_block_addr, uint8_t *buf,
                     uint32_t block_cnt) {
-  if (block_cnt < 0 || block_cnt > SD_BLOCK_CNT_MAX) {
+  if (block_cnt == 0 || block_cnt > SD_BLOCK_CNT_MAX) {
     log_error("SD block count error!");
     return -1;
   }
 
+  uint32_t size = sd_info.block_size * block_cnt;
+  int mode = sd_xfer_mode(buf, size);
+
   // 重置fifo
   SD_FIFO_RSET();
 
+  if (sd_xfer_prepare(mode, buf, size, 1) < 0) {
+    mode = SD_XFER_POL;
+  }
+
   // 进行写操作
-  SD_DATCON_DO_WRITE(block_cnt);
+  SD_DATCON_DO_WRITE(block_cnt, mode == SD_XFER_DMA ? SD_DATCON_DMAEn : 0);
 
   // CMD24/25(addr),写入的第一块地址
   SD_CMD_ARG(first_block_addr);
 
-  uint32_t write_cnt = 0;
-  switch (POL) {
-    case POL:
-      for (int i = 0; i < 50; ++i) {
-        if (block_cnt == 1) {  // 单块写入
-          // CMD24
-          SD_CMD(24, 1, 0);
-          if (!sd_check_cmd_end(24, 1)) {
-            continue;
-          }
-          break;
-        } else {  // 多块写入
-          SD_CMD(25, 1, 0);
-          if (!sd_check_cmd_end(25, 1)) {
-            continue;
-          }
-          break;
-        }
-      }
-      while (write_cnt < sd_info.block_size * block_cnt) {
-        if (SD_DATSTA_IS_DatTout()) {  // 检测数据传输超时
-          SD_DATSTA_CLR_DatTout();     // 清除标志位
-          break;
-        }
-        if (SD_FIFO_CAN_WRITE()) {  // 发现fifo未满
-          rSDIDAT8 = *(buf++);
-          write_cnt++;
-        }
+  for (int i = 0; i < 50; ++i) {
+    if (block_cnt == 1) {  // 单块写入
+      // CMD24
+      SD_CMD(24, 1, 0);
+      if (!sd_check_cmd_end(24, 1)) {
+        ktimer_sleep_us(SD_RETRY_US);
+        continue;
       }
       break;
-    default:
+    } else {  // 多块写入
+      SD_CMD(25, 1, 0);
+      if (!sd_check_cmd_end(25, 1)) {
+        ktimer_sleep_us(SD_RETRY_US);
+        continue;
+      }
       break;
+    }
   }
 
+  uint32_t write_cnt = sd_xfer_data(mode, buf, size, 1);
+
   // 检测数据是否传输结束
   if (!sd_check_data_end()) {
     log_error("sd write dat error!");
   }
 
+  rSDIIMSK = 0;
   // 清除数据控制寄存器各标志位
   SD_DATCON_RESET();
 
   if (block_cnt > 1) {
-    do {
+    while (1) {
       // 在发送命令后接收忙信号，检测忙结束
       SD_DATCON_DO_DetectBusy(block_cnt);
 
       // 执行CMD12命令,结束多块写入
       SD_CMD_ARG(0);
       SD_CMD(12, 1, 0);
-    } while (!sd_check_cmd_end(12, 1));
+      if (sd_check_cmd_end(12, 1)) {
+        break;
+      }
+      ktimer_sleep_us(SD_RETRY_US);
+    }
 
     // 检测忙结束，判断是否执行完写操作
     if (!sd_check_busy_end()) {
@@ -530,16 +820,24 @@ int sd_read(disk_t *disk, uint32_t block_addr, char *buff, uint32_t block_cnt) {
     return -1;
   }
 
+  // 每次最多传输SD_BLOCK_CNT_MAX块，传输不完整时停止
   uint8_t *temp_buff = (uint8_t *)buff;
   int read_cnt = 0;
-  for (int i = 0; i < block_cnt / SD_BLOCK_CNT_MAX; ++i) {
-    read_cnt += sd_read_blocks(block_addr, temp_buff, SD_BLOCK_CNT_MAX);
-    block_addr += SD_BLOCK_CNT_MAX;
-    temp_buff += SD_BLOCK_CNT_MAX * sd_info.block_size / 4;
-  }
+  while (block_cnt) {
+    uint32_t cnt =
+        block_cnt > SD_BLOCK_CNT_MAX ? SD_BLOCK_CNT_MAX : block_cnt;
+    int ret = sd_read_blocks(block_addr, temp_buff, cnt);
+    if (ret > 0) {
+      read_cnt += ret;
+    }
+    if (ret != cnt) {
+      break;
+    }
 
-  read_cnt +=
-      sd_read_blocks(block_addr, temp_buff, block_cnt % SD_BLOCK_CNT_MAX);
+    block_addr += cnt;
+    block_cnt -= cnt;
+    temp_buff += cnt * sd_info.block_size;
+  }
 
   // 取消片选
   sd_sel_desel(0);
@@ -565,14 +863,21 @@ int sd_write(disk_t *disk, uint32_t block_addr, char *buff,
 
   uint8_t *temp_buff = (uint8_t *)buff;
   int write_cnt = 0;
-  for (int i = 0; i < block_cnt / SD_BLOCK_CNT_MAX; ++i) {
-    write_cnt += sd_write_blocks(block_addr, temp_buff, SD_BLOCK_CNT_MAX);
-    block_addr += SD_BLOCK_CNT_MAX;
-    temp_buff += SD_BLOCK_CNT_MAX * sd_info.block_size / 4;
-  }
+  while (block_cnt) {
+    uint32_t cnt =
+        block_cnt > SD_BLOCK_CNT_MAX ? SD_BLOCK_CNT_MAX : block_cnt;
+    int ret = sd_write_blocks(block_addr, temp_buff, cnt);
+    if (ret > 0) {
+      write_cnt += ret;
+    }
+    if (ret != cnt) {
+      break;
+    }
 
-  write_cnt +=
-      sd_write_blocks(block_addr, temp_buff, block_cnt % SD_BLOCK_CNT_MAX);
+    block_addr += cnt;
+    block_cnt -= cnt;
+    temp_buff += cnt * sd_info.block_size;
+  }
 
   // 取消片选
   sd_sel_desel(0);
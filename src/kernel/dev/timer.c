@@ -3,15 +3,21 @@
 
 #include "common/os_config.h"
 #include "common/types.h"
+#include "core/clock.h"
 #include "core/irq.h"
+#include "core/softirq.h"
 #include "core/task.h"
 #include "tools/assert.h"
 #include "tools/log.h"
 
-static uint32_t tick __attribute__((section(".data"))) = 0;
+// 定时器4的中断次数，即系统启动后经过的时间片数
+static volatile uint32_t tick __attribute__((section(".data"))) = 0;
+
+// 下半部已处理的时间片数，下半部被推迟时可能落后于tick
+static uint32_t handled_tick __attribute__((section(".data"))) = 0;
 
 /**
- * @brief 定时器中断处理函数
+ * @brief 定时器中断处理函数，只清除中断并累加时间片数，时间片处理交给下半部
  *
  */
 static void irq_handler_for_timer4() {
@@ -19,9 +25,42 @@ static void irq_handler_for_timer4() {
   // 清除中断
   irq_clear(INT_TIMER4, NOSUBINT);
 
-  // log_printf("timer handler ok tick = %x!\n", tick++);
+  tick++;
+  clock_tick(tick);
+
+  softirq_raise(SOFTIRQ_TIMER);
+}
+
+/**
+ * @brief 定时器的下半部处理函数，为每个未处理的时间片扫描睡眠队列并处理当前任务的时间片
+ *
+ */
+static void softirq_handler_for_timer(void) {
+  while (handled_tick != tick) {
+    handled_tick++;
 
-  task_slice_end();
+    cpu_state_t state = task_enter_protection();
+    task_slice_end();
+    task_leave_protection(state);
+  }
+}
+
+/**
+ * @brief 定时器4的中断进入延迟，即计数器重载后经过的时间
+ *
+ * @return uint32_t
+ */
+static uint32_t irq_latency_for_timer4(void) {
+  return (TIMER_TICK_COUNT - rTCNTO4) * TIMER_RESOLVING_POWER;
+}
+
+/**
+ * @brief 定时器3的中断进入延迟
+ *
+ * @return uint32_t
+ */
+static uint32_t irq_latency_for_timer3(void) {
+  return (rTCNTB3 - rTCNTO3) * TIMER3_RESOLVING_POWER;
 }
 
 /**
@@ -38,12 +77,163 @@ void timer_init() {
   rTCON = 0x0;
 
   // 设置定时器每一个时间片触发一次中断
-  rTCNTB4 = (uint32_t)(TASK_TIME_SLICE_MS * 1000) / TIMER_RESOLVING_POWER;
+  rTCNTB4 = TIMER_TICK_COUNT;
   rTCON = HAND_REFLASH_4;  // 手动更新定时器4的计数器
   rTCON = AUTORELOAD_AND_START_4;  // 关闭手动更新位,设置自动重载并打开定时器4
 
+  clock_init();
+
+  softirq_register(SOFTIRQ_TIMER, softirq_handler_for_timer);
   irq_handler_register(INT_TIMER4, irq_handler_for_timer4);
+  irq_latency_register(INT_TIMER4, irq_latency_for_timer4);
   irq_enable(INT_TIMER4, NOSUBINT);
 
   log_printf("timer init success.....\n");
-}
\ No newline at end of file
+}
+
+/**
+ * @brief 同时读取时间片数与定时器4的当前计数，计数器已重载但中断还未处理时补上一个时间片
+ *
+ * @param cnt 定时器4的当前计数
+ * @return uint32_t 时间片数
+ */
+static uint32_t timer_read(uint32_t *cnt) {
+  cpu_state_t state = task_enter_protection();
+
+  uint32_t t = tick;
+  *cnt = rTCNTO4;
+  if (rSRCPND & (1 << INT_TIMER4)) {
+    *cnt = rTCNTO4;
+    t++;
+  }
+
+  task_leave_protection(state);
+  return t;
+}
+
+/**
+ * @brief 获取系统启动后经过的定时器计数，单位为TIMER_RESOLVING_POWER微秒
+ *        由时间片数与定时器4当前计数组合而成
+ *
+ * @return uint32_t
+ */
+uint32_t timer_get_count(void) {
+  uint32_t cnt;
+  uint32_t t = timer_read(&cnt);
+  return t * TIMER_TICK_COUNT + (TIMER_TICK_COUNT - cnt);
+}
+
+/**
+ * @brief 获取系统启动后经过的时间片数，以及当前时间片内经过的微秒数
+ *        timer_get_count约24小时回绕一次，需要更长的时间时使用该函数
+ *
+ * @param tick_count
+ * @param elapsed_us
+ */
+void timer_get_tick(uint32_t *tick_count, uint32_t *elapsed_us) {
+  uint32_t cnt;
+  *tick_count = timer_read(&cnt);
+  *elapsed_us = (TIMER_TICK_COUNT - cnt) * TIMER_RESOLVING_POWER;
+}
+
+/**
+ * @brief 启动定时器3，每period_us微秒产生一次中断
+ *
+ * @param period_us
+ * @param handler 中断处理函数，需自行清除中断
+ */
+void timer3_start(uint32_t period_us, void (*handler)(void)) {
+  cpu_state_t state = task_enter_protection();
+
+  // 只修改定时器3的控制位，定时器4保持运行
+  rTCNTB3 = period_us / TIMER3_RESOLVING_POWER;
+  rTCON = (rTCON & ~TIMER3_CON_MASK) | HAND_REFLASH_3;
+  rTCON = (rTCON & ~TIMER3_CON_MASK) | AUTORELOAD_AND_START_3;
+
+  irq_handler_register(INT_TIMER3, handler);
+  irq_latency_register(INT_TIMER3, irq_latency_for_timer3);
+  irq_clear(INT_TIMER3, NOSUBINT);
+  irq_enable(INT_TIMER3, NOSUBINT);
+
+  task_leave_protection(state);
+}
+
+/**
+ * @brief 以单次模式启动定时器2，delay_us微秒后产生一次中断，已启动时重新计时
+ *        超出最大定时时间时在最大定时时间处中断
+ *
+ * @param delay_us
+ * @param handler 中断处理函数，需自行清除中断
+ */
+void timer2_oneshot(uint32_t delay_us, void (*handler)(void)) {
+  uint32_t count = delay_us / TIMER_RESOLVING_POWER;
+  if (count == 0) {
+    count = 1;
+  } else if (count > TIMER2_COUNT_MAX) {
+    count = TIMER2_COUNT_MAX;
+  }
+
+  cpu_state_t state = task_enter_protection();
+
+  // 只修改定时器2的控制位，不设置自动重载，计数到0后停止
+  rTCNTB2 = count;
+  rTCON = (rTCON & ~TIMER2_CON_MASK) | HAND_REFLASH_2;
+  rTCON = (rTCON & ~TIMER2_CON_MASK) | START_2;
+
+  irq_handler_register(INT_TIMER2, handler);
+  irq_enable(INT_TIMER2, NOSUBINT);
+
+  task_leave_protection(state);
+}
+
+/**
+ * @brief 停止定时器2
+ *
+ */
+void timer2_stop(void) {
+  cpu_state_t state = task_enter_protection();
+
+  irq_disable(INT_TIMER2, NOSUBINT);
+  rTCON &= ~TIMER2_CON_MASK;
+  irq_clear(INT_TIMER2, NOSUBINT);
+
+  task_leave_protection(state);
+}
+
+/**
+ * @brief 忙等待us微秒，通过定时器4的计数变化计时，不依赖时钟中断，
+ *        用于无法睡眠的场合，如任务管理器初始化前或中断上下文中
+ *
+ * @param us
+ */
+void timer_delay_us(uint32_t us) {
+  uint32_t count = (us + TIMER_RESOLVING_POWER - 1) / TIMER_RESOLVING_POWER;
+  uint32_t last = rTCNTO4;
+
+  while (count) {
+    uint32_t curr = rTCNTO4;
+    // 计数器递减到0后重载为TIMER_TICK_COUNT
+    uint32_t passed =
+        curr <= last ? last - curr : last + TIMER_TICK_COUNT - curr;
+    if (passed >= count) {
+      break;
+    }
+
+    count -= passed;
+    last = curr;
+  }
+}
+
+/**
+ * @brief 停止定时器3
+ *
+ */
+void timer3_stop(void) {
+  cpu_state_t state = task_enter_protection();
+
+  irq_disable(INT_TIMER3, NOSUBINT);
+  rTCON &= ~TIMER3_CON_MASK;
+  irq_clear(INT_TIMER3, NOSUBINT);
+
+  task_leave_protection(state);
+}
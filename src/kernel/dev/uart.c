@@ -4,8 +4,12 @@
 
 #include "common/types.h"
 #include "core/irq.h"
+#include "core/softirq.h"
+#include "core/task.h"
 #include "tools/assert.h"
 #include "tools/klib.h"
+#include "tools/log.h"
+#include "tools/ring.h"
 
 static uart_t uart_table[UART_COUNT]
     __attribute__((section(".data"), aligned(4)));
@@ -13,12 +17,20 @@ static uart_t uart_table[UART_COUNT]
 static int curr_uart_index __attribute__((section(".data"))) = 0;
 
 void irq_handler_for_uartRX0();
+static void uart_rx_tasklet_func(void *arg);
+
+// 串口接收缓冲区，中断处理函数为生产者，小任务为消费者
+static uint8_t uart_rx_buf[UART_RX_BUF_SIZE] __attribute__((section(".data")));
+static ring_t uart_rx_ring __attribute__((section(".data"))) = {
+    .buf = uart_rx_buf,
+    .mask = UART_RX_BUF_SIZE - 1,
+};
+static tasklet_t uart_rx_tasklet __attribute__((section(".data"))) = {
+    .func = uart_rx_tasklet_func,
+};
 
 /**串口初始化*/
 void uart_init(int uart_inedx) {
-  rUFCON0 = 0x0;  // UART channel 0 FIFO control register, FIFO disable
-  rUFCON1 = 0x0;  // UART channel 1 FIFO control register, FIFO disable
-  rUFCON2 = 0x0;  // UART channel 2 FIFO control register, FIFO disable
   rUMCON0 = 0x0;  // UART chaneel 0 MODEM control register, AFC disable
   rUMCON1 = 0x0;  // UART chaneel 1 MODEM control register, AFC disable
 
@@ -35,11 +47,12 @@ void uart_init(int uart_inedx) {
                 //      ,       01          01
                 //    PCLK       Level    Pulse    Disable    Generate  Normal
                 //    Normal        Interrupt or Polling
-      rUCON0 = 0x245;  // Control register
+      rUCON0 = UCON_INIT;     // Control register, Rx time out enable
+      rUFCON0 = UFCON_INIT;   // FIFO enable, Rx/Tx trigger level 16 bytes
       rUBRDIV0 = ((int)(OS_PCLK / (16 * BAUDRATE)) -
                   1);  // Baud rate divisior register 0
 
-      // 使能串口接收中断
+      // 使能串口接收中断，接收FIFO达到触发深度或接收超时时产生
       // TODO:这里只使能0串口
       irq_handler_register(INT_RXD0_PRIM,
                            (irq_handler_t)irq_handler_for_uartRX0);
@@ -53,6 +66,7 @@ void uart_init(int uart_inedx) {
       uart_table[0].in_addr = (volatile unsigned *)URXH0;
       uart_table[0].out_addr = (volatile unsigned *)UTXH0;
       uart_table[0].state_addr = (volatile unsigned *)UTRSTAT0;
+      uart_table[0].fifo_addr = &rUFSTAT0;
       mutex_init(&uart_table[0].mutex);
     } break;
 
@@ -60,10 +74,12 @@ void uart_init(int uart_inedx) {
       // UART1
       rULCON1 = 0x3;
       rUCON1 = 0x245;
+      rUFCON1 = UFCON_INIT;
       rUBRDIV1 = ((int)(OS_PCLK / (16 * BAUDRATE)) - 1);
       uart_table[1].in_addr = (volatile unsigned *)URXH1;
       uart_table[1].out_addr = (volatile unsigned *)UTXH1;
       uart_table[1].state_addr = (volatile unsigned *)UTRSTAT1;
+      uart_table[1].fifo_addr = &rUFSTAT1;
       mutex_init(&uart_table[1].mutex);
     } break;
 
@@ -71,11 +87,13 @@ void uart_init(int uart_inedx) {
       // UART2
       rULCON2 = 0x3;
       rUCON2 = 0x245;
+      rUFCON2 = UFCON_INIT;
       rUBRDIV2 = ((int)(OS_PCLK / (16 * BAUDRATE)) - 1);
 
       uart_table[2].in_addr = (volatile unsigned *)URXH2;
       uart_table[2].out_addr = (volatile unsigned *)UTXH2;
       uart_table[2].state_addr = (volatile unsigned *)UTRSTAT2;
+      uart_table[2].fifo_addr = &rUFSTAT2;
       mutex_init(&uart_table[2].mutex);
     } break;
 
@@ -149,9 +167,36 @@ static int uart_get() { return curr_uart_index; }
  * @param data
  */
 void uart_send_byte(uart_t *uart, uint8_t data) {
-  while (!((*(uart->state_addr)) & STATE_TRA_BUFF_ISEMPTY))
-    ;
-  *(uart->out_addr) = data;
+  // 发送中断也会写入发送FIFO，需关中断完成判断与写入
+  while (1) {
+    cpu_state_t state = task_enter_protection();
+    if (!((*(uart->fifo_addr)) & FIFO_TX_FULL)) {
+      *(uart->out_addr) = data;
+      task_leave_protection(state);
+      return;
+    }
+    task_leave_protection(state);
+  }
+}
+
+/**
+ * @brief 使能串口0的发送中断，由发送中断填充发送FIFO，发出内核日志与tty输出
+ *        发送中断为电平触发，发送FIFO不多于触发深度时持续产生，没有待发送内容时将其屏蔽
+ *
+ */
+void uart_tx_start(void) { irq_enable(-1, INT_TXD0_SUB); }
+
+/**
+ * @brief 在关中断的情况下轮询发出所有剩余的内核日志
+ *
+ */
+void uart_tx_flush(void) {
+  char c;
+  while (log_tx_byte(&c) == 0) {
+    while ((*(uart_table[0].fifo_addr)) & FIFO_TX_FULL)
+      ;
+    *(uart_table[0].out_addr) = c;
+  }
 }
 
 /**
@@ -187,7 +232,8 @@ void uart_printf(uart_t *uart, char *fmt, ...) {
 }
 
 /**
- * @brief 写入uart设备
+ * @brief 写入uart设备，串口0由发送中断排空tty的输出队列，此处只需使能发送中断
+ *        其余串口没有使能中断，仍轮询发出
  *
  */
 int uart_write(tty_t *tty) {
@@ -195,24 +241,32 @@ int uart_write(tty_t *tty) {
   uart_t *uart = uart_table + tty->console_index;
   int len = 0;
 
+  if (uart == uart_table) {
+    uart->tty = tty;
+    uart_tx_start();
+    return ring_count(&tty->out_fifo);
+  }
+
   // TODO:加锁
   mutex_lock(&uart->mutex);
 
-  // 在tty的缓冲队列中读取一个字符写入终端
+  // 在tty的缓冲队列中成批读取字符写入终端，uart_write是输出队列唯一的消费者
   do {
-    char c;
-    int err = tty_fifo_get(&tty->out_fifo, &c);
-    if (err < 0) {
+    uint8_t buf[32];
+    int count = ring_get_bulk(&tty->out_fifo, buf, sizeof(buf));
+    if (count == 0) {
       break;
     }
 
-    // 成功消耗掉缓冲区一个字节资源后，对资源进行释放
-    sem_notify(&tty->out_sem);
+    // 输出队列空出位置，唤醒等待写入的任务
+    tty_out_wakeup(tty);
 
-    // 将该字节传输给串口
-    uart_send_byte(uart, c);
+    for (int i = 0; i < count; ++i) {
+      // 将该字节传输给串口
+      uart_send_byte(uart, buf[i]);
+    }
 
-    len++;
+    len += count;
   } while (1);
 
   // TODO:解锁
@@ -221,6 +275,26 @@ int uart_write(tty_t *tty) {
   return len;
 }
 
+/**
+ * @brief 发出tty的输入回显，在串口接收的下半部中调用
+ *        串口0由发送中断排空回显队列，其余串口没有使能中断，直接轮询发出
+ *
+ */
+void uart_echo(tty_t *tty) {
+  uart_t *uart = uart_table + tty->console_index;
+
+  if (uart == uart_table) {
+    uart->tty = tty;
+    uart_tx_start();
+    return;
+  }
+
+  uint8_t ch;
+  while (ring_get(&tty->echo_fifo, &ch) == 0) {
+    uart_send_byte(uart, ch);
+  }
+}
+
 /**
  * @brief 向uart设备发送控制指令
  *
@@ -230,16 +304,69 @@ int uart_control(int cmd, int arg0, int arg1) {}
 void irq_handler_for_uartRX0() {
   ASSERT((rINTOFFSET == INT_UART0));
 
+  if ((rSUBSRCPND & (1 << INT_TXD0_SUB)) &&
+      !(rINTSUBMSK & (1 << INT_TXD0_SUB))) {
+    // 发送FIFO不多于触发深度，依次发出日志、tty的输入回显与tty输出，将FIFO填满
+    // 都没有待发送的内容时屏蔽发送中断
+    uart_t *uart = uart_table;
+    tty_t *tty = uart->tty;
+    // FIFO满时计数位为0，只有FIFO_TX_FULL置位，此时没有空间，
+    // FIFO排空时会再次产生发送中断，不能屏蔽
+    uint32_t state = *(uart->fifo_addr);
+    int space =
+        (state & FIFO_TX_FULL) ? 0 : UART_FIFO_SIZE - FIFO_TX_COUNT(state);
+    int idle = space > 0;
+    char c;
+    while (space > 0 && log_tx_byte(&c) == 0) {
+      *(uart->out_addr) = c;
+      space--;
+      idle = 0;
+    }
+
+    if (tty && space > 0) {
+      uint8_t buf[UART_FIFO_SIZE];
+      int count = ring_get_bulk(&tty->echo_fifo, buf, space);
+      int out = ring_get_bulk(&tty->out_fifo, buf + count, space - count);
+      count += out;
+
+      for (int i = 0; i < count; ++i) {
+        *(uart->out_addr) = buf[i];
+      }
+
+      if (count) {
+        idle = 0;
+      }
+
+      // 输出队列空出位置，一次唤醒所有等待写入的任务
+      if (out) {
+        tty_out_wakeup(tty);
+      }
+    }
+
+    if (idle) {
+      irq_disable(-1, INT_TXD0_SUB);
+    }
+
+    irq_clear(INT_TXD0_PRIM, INT_TXD0_SUB);
+  }
+
   if ((rSUBSRCPND & (1 << INT_RXD0_SUB)) &&
       !(rINTSUBMSK & (1 << INT_RXD0_SUB))) {
     // 清除中断位
     irq_clear(INT_RXD0_PRIM, INT_RXD0_SUB);
 
-    uart_t *uart = uart_table + curr_uart_index;
+    uart_t *uart = uart_table;
 
-    // 判断状态寄存器接收缓冲区位，是否有数据可读
-    if (*(uart->state_addr) & STATE_REC_BUFF_ISREADY) {
-      tty_in(*(uart->in_addr));
+    // 接收FIFO达到触发深度或接收超时，读空FIFO后交给下半部送入tty设备
+    // 缓冲区满时丢弃多出的字节
+    int count = 0;
+    while (*(uart->fifo_addr) & (FIFO_RX_COUNT_MASK | FIFO_RX_FULL)) {
+      ring_put(&uart_rx_ring, *(uart->in_addr));
+      count++;
+    }
+
+    if (count) {
+      tasklet_schedule(&uart_rx_tasklet);
     }
   } else if ((rSUBSRCPND & (1 << INT_UART0_ERR_SUB)) &&
              !(rINTSUBMSK & (1 << INT_UART0_ERR_SUB))) {
@@ -247,6 +374,18 @@ void irq_handler_for_uartRX0() {
   }
 }
 
+/**
+ * @brief 串口接收的下半部，将接收缓冲区中的字节送入tty设备，唤醒等待输入的任务
+ *
+ * @param arg
+ */
+static void uart_rx_tasklet_func(void *arg) {
+  uint8_t c;
+  while (ring_get(&uart_rx_ring, &c) == 0) {
+    tty_in(c);
+  }
+}
+
 /**
  * @brief 关闭uart设备
  *
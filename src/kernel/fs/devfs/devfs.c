@@ -12,18 +12,81 @@
 #include "fs/devfs/devfs.h"
 
 #include "core/dev.h"
+#include "core/task.h"
 #include "fs/file.h"
 #include "tools/klib.h"
 #include "tools/log.h"
 
-// 定义设备文件系统管理的类型表
-static devfs_type_t devfs_type_list[] = {
-    {
-        .name = "tty",
-        .dev_type = DEV_TTY,
-        .file_type = FILE_TTY,
-    },  // tty设备类型
-};
+// 设备文件表，由驱动初始化时注册
+static devfs_type_t devfs_type_list[DEVFS_NODE_MAX];
+static int devfs_type_count;
+
+/**
+ * @brief 注册一个设备文件，由驱动在初始化时调用
+ *
+ * @param name 设备文件名，minor为DEVFS_MINOR_ANY时为路径的前缀
+ * @param dev_type 设备类型
+ * @param minor 设备号
+ * @param file_type 文件类型
+ * @return int 0：成功，-1：失败
+ */
+int devfs_register(const char *name, int dev_type, int minor, int file_type) {
+  if (kernel_strlen(name) >= DEVFS_NAME_SIZE) {
+    log_printf("devfs name too long: %s\n", name);
+    return -1;
+  }
+
+  cpu_state_t state = task_enter_protection();
+  if (devfs_type_count >= DEVFS_NODE_MAX) {
+    task_leave_protection(state);
+    log_printf("devfs table full, drop %s\n", name);
+    return -1;
+  }
+
+  devfs_type_t *type = devfs_type_list + devfs_type_count++;
+  kernel_strncpy(type->name, name, DEVFS_NAME_SIZE);
+  type->dev_type = dev_type;
+  type->minor = minor;
+  type->file_type = file_type;
+  task_leave_protection(state);
+
+  return 0;
+}
+
+/**
+ * @brief 根据路径查找设备文件
+ *
+ * @param path
+ * @param minor 返回设备号
+ * @return devfs_type_t*
+ */
+static devfs_type_t *devfs_find(const char *path, int *minor) {
+  for (int i = 0; i < devfs_type_count; ++i) {
+    devfs_type_t *type = devfs_type_list + i;
+
+    // 设备号固定的设备文件需完全匹配
+    if (type->minor != DEVFS_MINOR_ANY) {
+      if (kernel_strncmp(path, type->name, DEVFS_NAME_SIZE) == 0) {
+        *minor = type->minor;
+        return type;
+      }
+      continue;
+    }
+
+    // 其余设备文件匹配前缀后读取路径中的设备号
+    int type_name_len = kernel_strlen(type->name);
+    if (kernel_strncmp(path, type->name, type_name_len) == 0) {
+      *minor = 0;  // 路径中没有设备号时默认为0
+      if (kernel_strlen(path) > type_name_len &&
+          path_to_num(path + type_name_len, minor) < 0) {
+        continue;
+      }
+      return type;
+    }
+  }
+
+  return (devfs_type_t *)0;
+}
 
 /**
  * @brief 挂载设备文件系统
@@ -54,41 +117,68 @@ void devfs_unmount(struct _fs_t *fs) {}
  * @return int
  */
 int devfs_open(struct _fs_t *fs, const char *path, file_t *file) {
-  // 遍历设备类型表，获取需要打开的设备的信息
-  for (int i = 0; i < sizeof(devfs_type_list) / sizeof(devfs_type_list[0]);
-       ++i) {
-    devfs_type_t *type = devfs_type_list + i;
+  // 1.在设备文件表中查找需要打开的设备
+  int minor;
+  devfs_type_t *type = devfs_find(path, &minor);
+  if (!type) {
+    log_printf("device not found: %s\n", path);
+    return -1;
+  }
 
-    int type_name_len = kernel_strlen(type->name);
-    if (kernel_strncmp(path, type->name, type_name_len) == 0) {
-      int minor;
-      // 判断路径是否正确并读取路径中的设备号
-      if (kernel_strlen(path) > type_name_len &&
-          path_to_num(path + type_name_len, &minor) < 0) {
-        log_printf("Get device num failed. %s", path);
-        break;
-      }
+  // 2.打开设备
+  int dev_id = dev_open(type->dev_type, minor, (void *)0);
+  if (dev_id < 0) {
+    log_printf("open device failed: %s", path);
+    return -1;
+  }
 
-      // 打开设备
-      int dev_id = dev_open(type->dev_type, minor, (void *)0);
-      if (dev_id < 0) {
-        log_printf("open device failed: %s", path);
-        break;
-      }
+  // 3.块设备按整块读写，记录块大小
+  int blk_size = 0;
+  if (type->file_type == FILE_BLOCK) {
+    blk_size = dev_control(dev_id, DEV_CMD_BLOCK_SIZE, 0, 0);
+    if (blk_size <= 0) {
+      dev_close(dev_id);
+      return -1;
+    }
+  }
 
-      // 打开成功，初始化file结构，用file记录文件信息
-      file->dev_id = dev_id;
-      file->pos = 0;
-      file->size = 0;
-      file->type = type->file_type;
-      file->ref = 1;
+  // 打开成功，初始化file结构，用file记录文件信息
+  file->dev_id = dev_id;
+  file->blk_size = blk_size;
+  file->pos = 0;
+  file->size = 0;
+  file->type = type->file_type;
+  file->ref = 1;
 
-      return 0;
-    }
+  return 0;
+}
+
+/**
+ * @brief 读写块设备文件，读写位置与大小需按块对齐
+ *
+ * @param buf
+ * @param size
+ * @param file
+ * @param write
+ * @return int 成功读写的字节数
+ */
+static int devfs_block_rw(char *buf, int size, file_t *file, int write) {
+  int blk_size = file->blk_size;
+  if (file->pos % blk_size || size % blk_size) {
+    return -1;
   }
 
-  return -1;
-};
+  int cnt = write ? dev_write(file->dev_id, file->pos / blk_size, buf,
+                              size / blk_size)
+                  : dev_read(file->dev_id, file->pos / blk_size, buf,
+                             size / blk_size);
+  if (cnt < 0) {
+    return -1;
+  }
+
+  file->pos += cnt * blk_size;
+  return cnt * blk_size;
+}
 
 /**
  * @brief 读取设备文件系统
@@ -99,7 +189,12 @@ int devfs_open(struct _fs_t *fs, const char *path, file_t *file) {
  * @return int
  */
 int devfs_read(char *buf, int size, file_t *file) {
-  return dev_read(file->dev_id, file->pos, buf, size);
+  if (file->type == FILE_BLOCK) {
+    return devfs_block_rw(buf, size, file, 0);
+  }
+
+  // 字符设备没有读写位置，传入打开标志，由设备决定是否等待
+  return dev_read(file->dev_id, file->mode, buf, size);
 }
 
 /**
@@ -111,7 +206,12 @@ int devfs_read(char *buf, int size, file_t *file) {
  * @return int
  */
 int devfs_write(char *buf, int size, file_t *file) {
-  return dev_write(file->dev_id, file->pos, buf, size);
+  if (file->type == FILE_BLOCK) {
+    return devfs_block_rw(buf, size, file, 1);
+  }
+
+  // 字符设备没有读写位置，传入打开标志，由设备决定是否等待
+  return dev_write(file->dev_id, file->mode, buf, size);
 }
 
 /**
@@ -130,8 +230,13 @@ void devfs_close(file_t *file) { dev_close(file->dev_id); }
  * @return int
  */
 int devfs_seek(file_t *file, uint32_t offset, int dir) {
-  // 设备文件系统不支持偏移调用，直接返回-1;
-  return -1;
+  // 只有块设备支持从头偏移，偏移量需按块对齐
+  if (file->type != FILE_BLOCK || dir != 0 || offset % file->blk_size) {
+    return -1;
+  }
+
+  file->pos = offset;
+  return 0;
 }
 
 /**
@@ -156,7 +261,18 @@ int devfs_stat(file_t *file, struct stat *st) {
  * @return int
  */
 int devfs_ioctl(file_t *file, int cmd, int arg0, int arg1) {
-  dev_control(file->dev_id, cmd, arg0, arg1);
+  return dev_control(file->dev_id, cmd, arg0, arg1);
+}
+
+/**
+ * @brief 获取设备文件当前的可读写状态
+ *
+ * @param file
+ * @param entry
+ * @return int
+ */
+int devfs_poll(file_t *file, struct _wait_entry_t *entry) {
+  return dev_poll(file->dev_id, entry);
 }
 
 // 将设备文件系统的操作函数抽象给顶层文件系统使用
@@ -171,4 +287,5 @@ fs_op_t devfs_op = {
     .seek = devfs_seek,
     .stat = devfs_stat,
     .ioctl = devfs_ioctl,
+    .poll = devfs_poll,
 };
\ No newline at end of file
@@ -13,9 +13,11 @@
 
 #include "core/dev.h"
 #include "core/memory.h"
+#include "core/mmap.h"
 #include "fs/fatfs/fatfs.h"
 #include "fs/file.h"
 #include "fs/fs.h"
+#include "fs/page_cache.h"
 #include "tools/klib.h"
 #include "tools/log.h"
 
@@ -631,7 +633,7 @@ int fatfs_mount(struct _fs_t *fs, int major, int minor) {
   }
 
   // 分配一页来作为dbr区域的缓冲区
-  dbr32_t *dbr = (dbr32_t *)memory_alloc_page(1);
+  dbr32_t *dbr = (dbr32_t *)memory_alloc_page(1, MEM_TAG_FAT_BUF);
   if (!dbr) {
     log_printf("mount failed: can't alloc buf\n");
     goto mount_failed;
@@ -682,7 +684,8 @@ int fatfs_mount(struct _fs_t *fs, int major, int minor) {
   // 释放dbr区域,并为fat_buffer开辟一簇大小的空间做缓存
   memory_free_page((uint32_t)dbr, 1);
   fat->fat_buffer = memory_alloc_page(
-      up2(fat->cluster_bytes_size, MEM_PAGE_SIZE) / MEM_PAGE_SIZE);
+      up2(fat->cluster_bytes_size, MEM_PAGE_SIZE) / MEM_PAGE_SIZE,
+      MEM_TAG_FAT_BUF);
 
   if (fat->fat_buffer == 0) {
     log_error("fat_buffer err!\n");
@@ -693,8 +696,8 @@ int fatfs_mount(struct _fs_t *fs, int major, int minor) {
       up2(fat->tbl_sectors * fat->bytes_per_sector, MEM_PAGE_SIZE) /
       MEM_PAGE_SIZE;
 
-  fat_table_1.table = memory_alloc_page(fat_page_count);
-  fat_table_2.table = memory_alloc_page(fat_page_count);
+  fat_table_1.table = memory_alloc_page(fat_page_count, MEM_TAG_FAT_TABLE);
+  fat_table_2.table = memory_alloc_page(fat_page_count, MEM_TAG_FAT_TABLE);
 
   if (fat_table_1.table == 0 || fat_table_2.table == 0) {
     log_error("fat table buffer err!\n");
@@ -796,6 +799,8 @@ int fatfs_open(struct _fs_t *fs, const char *path, file_t *file) {
     read_from_diritem(fat, file, file_item, p_index);
 
     if (file->mode & O_TRUNC) {  // 以截断模式打开文件，需清空文件
+      page_cache_invalidate(fs, file->sblk);
+      mmap_revoke(fs, file->sblk);
       cluster_free_chain(fat, file->sblk);
       file->cblk = file->sblk = FAT_CLUSTER_END;
       file->size = 0;
@@ -903,6 +908,9 @@ int fatfs_read(char *buf, int size, file_t *file) {
 int fatfs_write(char *buf, int size, file_t *file) {
   fat_t *fat = (fat_t *)file->fs->data;
 
+  // 文件内容将被修改，使该文件已缓存的页失效
+  page_cache_invalidate(file->fs, file->sblk);
+
   // 文件空间大小不足以写入，需要拓展空间
   if (file->pos + size > file->size) {
     // 计算文件当前空间大小与待写入的大小的差值
@@ -979,7 +987,7 @@ int fatfs_write(char *buf, int size, file_t *file) {
  * @param file
  */
 void fatfs_close(file_t *file) {
-  if (file->mode == O_RDONLY) {
+  if ((file->mode & O_ACCMODE) == O_RDONLY) {
     // 文件只进行读操作，不需要回写到磁盘上
     return;
   }
@@ -1055,6 +1063,77 @@ int fatfs_seek(file_t *file, uint32_t offset, int dir) {
 }
 int fatfs_stat(file_t *file, struct stat *st) { return 0; }
 
+/**
+ * @brief 将文件offset处的一页内容沿簇链直接从磁盘读入page中，
+ *        不经过fat_buffer中转，超出文件大小的部分填0
+ *
+ * @param file
+ * @param offset 文件内的偏移量，按页大小对齐
+ * @param page 存放页内容的缓冲区，大小为MEM_PAGE_SIZE
+ * @return int 读取的有效字节数，-1：读取失败
+ */
+int fatfs_read_page(file_t *file, uint32_t offset, char *page) {
+  fat_t *fat = (fat_t *)file->fs->data;
+
+  if (offset >= file->size || (offset % MEM_PAGE_SIZE) ||
+      (MEM_PAGE_SIZE % fat->bytes_per_sector)) {
+    return -1;
+  }
+
+  // 1.计算该页中的有效字节数
+  uint32_t nbytes = file->size - offset;
+  if (nbytes > MEM_PAGE_SIZE) {
+    nbytes = MEM_PAGE_SIZE;
+  }
+
+  // 2.沿簇链找到offset所在的簇
+  cluster_t cblk = file->sblk;
+  for (uint32_t i = offset / fat->cluster_bytes_size; i > 0; --i) {
+    cblk = cluster_get_next(fat, cblk);
+    if (!cluster_is_valid(cblk)) {
+      return -1;
+    }
+  }
+
+  // 3.以扇区为单位将簇中的内容直接读入页中，一页可能跨越多个簇
+  uint32_t cluster_offset = offset % fat->cluster_bytes_size;
+  uint32_t total_read = 0;
+  while (total_read < nbytes) {
+    uint32_t curr_read = fat->cluster_bytes_size - cluster_offset;
+    if (curr_read > nbytes - total_read) {
+      curr_read = nbytes - total_read;
+    }
+
+    uint32_t start_sector =
+        fat->data_start_sector +
+        (cblk - FAT_CLUSTER_DAT_START) * fat->sec_per_cluster +
+        cluster_offset / fat->bytes_per_sector;
+    int sector_cnt =
+        up2(curr_read, fat->bytes_per_sector) / fat->bytes_per_sector;
+    int err =
+        dev_read(fat->fs->dev_id, start_sector, page + total_read, sector_cnt);
+    if (err < sector_cnt) {
+      return -1;
+    }
+
+    total_read += curr_read;
+    cluster_offset = 0;
+    if (total_read < nbytes) {
+      cblk = cluster_get_next(fat, cblk);
+      if (!cluster_is_valid(cblk)) {
+        return -1;
+      }
+    }
+  }
+
+  // 4.文件末尾所在页超出文件大小的部分填0
+  if (nbytes < MEM_PAGE_SIZE) {
+    kernel_memset(page + nbytes, 0, MEM_PAGE_SIZE - nbytes);
+  }
+
+  return nbytes;
+}
+
 /**
  * @brief 打开目录
  *
@@ -1147,6 +1226,8 @@ int fatfs_unlink(struct _fs_t *fs, const char *path) {
       // 找到文件，进行删除操作
       // 获取文件的起始簇号，并清除fat表中的簇链关系
       int cluster = (item->DIR_FstClusHI << 16) | item->DIR_FstClusLo;
+      page_cache_invalidate(fs, cluster);
+      mmap_revoke(fs, cluster);
       cluster_free_chain(fat, cluster);
 
       // 将磁盘上该目录项的位置清空
@@ -1170,6 +1251,7 @@ fs_op_t fatfs_op = {
     .close = fatfs_close,
     .seek = fatfs_seek,
     .stat = fatfs_stat,
+    .read_page = fatfs_read_page,
     .opendir = fatfs_opendir,
     .readdir = fatfs_readdir,
     .closedir = fatfs_closedir,
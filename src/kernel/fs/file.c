@@ -11,11 +11,13 @@
 
 #include "fs/file.h"
 
+#include "core/memory.h"
 #include "ipc/mutex.h"
 #include "tools/klib.h"
 
-static file_t file_table[FILE_TABLE_SIZE]
-    __attribute__((section(".data"), aligned(FILE_TABLE_SIZE))) = {{0}};
+// 系统文件表，文件结构按块在首次需要时分配，分配后不再释放
+static file_t *file_table[FILE_TABLE_SIZE / FILE_CHUNK_SIZE];
+static int file_chunk_count;      // 已分配的块数量
 static mutex_t file_alloc_mutex;  // 互斥锁，保护file_table的正确分配
 
 /**
@@ -24,7 +26,31 @@ static mutex_t file_alloc_mutex;  // 互斥锁，保护file_table的正确分配
  */
 void file_table_init(void) {
   mutex_init(&file_alloc_mutex);
+  mutex_set_name(&file_alloc_mutex, "file_alloc");
   kernel_memset(file_table, 0, sizeof(file_table));
+  file_chunk_count = 0;
+}
+
+/**
+ * @brief 为file_table分配一个新的文件结构块
+ *
+ * @return file_t* 新块的首个文件结构，0：已达到上限或内存不足
+ */
+static file_t *file_chunk_alloc(void) {
+  if (file_chunk_count >= FILE_TABLE_SIZE / FILE_CHUNK_SIZE) {
+    return (file_t *)0;
+  }
+
+  int page_count =
+      up2(FILE_CHUNK_SIZE * sizeof(file_t), MEM_PAGE_SIZE) / MEM_PAGE_SIZE;
+  file_t *chunk = (file_t *)memory_alloc_page(page_count, MEM_TAG_FILE);
+  if (!chunk) {
+    return (file_t *)0;
+  }
+
+  kernel_memset(chunk, 0, FILE_CHUNK_SIZE * sizeof(file_t));
+  file_table[file_chunk_count++] = chunk;
+  return chunk;
 }
 
 /**
@@ -38,17 +64,25 @@ file_t *file_alloc(void) {
   // TODO:加锁
   mutex_lock(&file_alloc_mutex);
 
-  // 在file_table中获取分配一个资源
-  for (int i = 0; i < FILE_TABLE_SIZE; ++i) {
-    file_t *p_file = file_table + i;
+  // 1.在已分配的块中获取分配一个资源
+  for (int i = 0; i < file_chunk_count * FILE_CHUNK_SIZE; ++i) {
+    file_t *p_file = file_table[i / FILE_CHUNK_SIZE] + i % FILE_CHUNK_SIZE;
     if (p_file->ref == 0) {  // 当前资源未被分配
-      kernel_memset(p_file, 0, sizeof(file_t));
-      p_file->ref = 1;  // 记录被外部引用
       file = p_file;
       break;
     }
   }
 
+  // 2.已分配的块均已用完，分配新块
+  if (!file) {
+    file = file_chunk_alloc();
+  }
+
+  if (file) {
+    kernel_memset(file, 0, sizeof(file_t));
+    file->ref = 1;  // 记录被外部引用
+  }
+
   // TODO:解锁
   mutex_unlock(&file_alloc_mutex);
   return file;
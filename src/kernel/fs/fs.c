@@ -18,8 +18,11 @@
 #include "common/os_config.h"
 #include "core/dev.h"
 #include "core/disk.h"
+#include "core/ktimer.h"
+#include "core/mmap.h"
 #include "core/task.h"
 #include "fs/file.h"
+#include "fs/page_cache.h"
 #include "tools/klib.h"
 #include "tools/list.h"
 #include "tools/log.h"
@@ -47,7 +50,7 @@ static fs_t *root_fs;
  * @return int
  */
 static int is_fd_bad(int fd) {
-  if (fd < 0 && fd >= TASK_OFILE_SIZE) {
+  if (fd < 0 || fd >= TASK_OFILE_SIZE) {
     return 1;
   }
 
@@ -143,6 +146,23 @@ static void fs_unprotect(fs_t *fs) {
   }
 }
 
+/**
+ * @brief 获取文件当前的可读写状态，不加文件系统锁，阻塞读写的任务可能正持有该锁
+ *
+ * @param file
+ * @param entry 不为0时加入文件的等待队列
+ * @return int
+ */
+static int file_poll(file_t *file, wait_entry_t *entry) {
+  fs_t *fs = file->fs;
+  // 不支持等待的文件，如磁盘上的普通文件，读写都不会阻塞
+  if (!fs->op->poll) {
+    return POLLIN | POLLOUT;
+  }
+
+  return fs->op->poll(file, entry);
+}
+
 /**
  * @brief 打开文件
  *
@@ -239,11 +259,21 @@ int sys_read(int fd, char *buf, int len) {
   }
 
   // 2.判断文件的读写模式
-  if (file->mode == O_WRONLY) {  // 文件只写，不可读
+  if ((file->mode & O_ACCMODE) == O_WRONLY) {  // 文件只写，不可读
     log_printf("file is write only!\n");
     return -1;
   }
 
+  // 非阻塞模式下没有数据可读时直接返回，读取途中是否等待由设备按打开标志决定
+  if ((file->mode & O_NONBLOCK) && !(file_poll(file, 0) & POLLIN)) {
+    return -1;
+  }
+
+  // 缓冲区可能位于文件映射区，写入前先使其成为进程私有的可写页
+  if (mmap_prepare_write((uint32_t)buf, len) < 0) {
+    return -1;
+  }
+
   // 3.获取文件对应的文件系统，并执行读操作
   fs_t *fs = file->fs;
   fs_protect(fs);
@@ -274,15 +304,27 @@ int sys_write(int fd, char *buf, int len) {
   }
 
   // 2.判断文件的读写模式
-  if (file->mode == O_RDONLY) {  // 文件只读，不可写
+  if ((file->mode & O_ACCMODE) == O_RDONLY) {  // 文件只读，不可写
     log_printf("file is read only!\n");
     return -1;
   }
 
+  // 非阻塞模式下没有空间可写时直接返回，写入途中是否等待由设备按打开标志决定
+  if ((file->mode & O_NONBLOCK) && !(file_poll(file, 0) & POLLOUT)) {
+    return -1;
+  }
+
   // 3.获取文件对应的文件系统，并执行写操作
   fs_t *fs = file->fs;
   fs_protect(fs);
+  int sblk = file->sblk;
+  uint32_t size = file->size;
   int err = fs->op->write(buf, len, file);
+
+  // 普通文件变大后，映射该文件的映射区需看到新的文件大小
+  if (file->type == FILE_NORMAL && file->size > size) {
+    mmap_update_file(sblk, file);
+  }
   fs_unprotect(fs);
 
   return err;
@@ -376,6 +418,9 @@ int sys_fstat(int fd, struct stat *st) {
   }
 
   // 2.获取对应文件系统进行状态获取操作
+  if (mmap_prepare_write((uint32_t)st, sizeof(struct stat)) < 0) {
+    return -1;
+  }
   fs_t *fs = file->fs;
   kernel_memset(st, 0, sizeof(struct stat));
   fs_protect(fs);
@@ -460,6 +505,10 @@ int sys_opendir(const char *path, DIR *dir) {
  * @return int
  */
 int sys_readdir(DIR *dir, struct dirent *dirent) {
+  if (mmap_prepare_write((uint32_t)dirent, sizeof(struct dirent)) < 0) {
+    return -1;
+  }
+
   // 使用该文件系统遍历该目录
   fs_protect(root_fs);
   int err = root_fs->op->readdir(root_fs, dir, dirent);
@@ -510,6 +559,138 @@ int sys_ioctl(int fd, int cmd, int arg0, int arg1) {
   return err;
 }
 
+/**
+ * @brief 获取或设置文件的打开标志，只支持F_GETFL与F_SETFL，
+ *        F_SETFL只修改O_NONBLOCK，共享该文件的描述符同时生效
+ *
+ * @param fd
+ * @param cmd
+ * @param arg
+ * @return int F_GETFL时为打开标志，其余为0，失败为-1
+ */
+int sys_fcntl(int fd, int cmd, int arg) {
+  if (is_fd_bad(fd)) {
+    log_printf("fd %d is not valid.", fd);
+    return -1;
+  }
+
+  file_t *file = task_file(fd);
+  if (!file) {
+    log_printf("file not opend!\n");
+    return -1;
+  }
+
+  switch (cmd) {
+    case F_GETFL:
+      return file->mode;
+    case F_SETFL:
+      file->mode = (file->mode & ~O_NONBLOCK) | (arg & O_NONBLOCK);
+      return 0;
+    default:
+      return -1;
+  }
+}
+
+// poll的等待状态，分配在调用者的内核栈上
+typedef struct _poll_wait_t {
+  sem_t sem;       // 被等待的文件状态变化或超时时释放
+  ktimer_t timer;  // 超时定时器
+  int timeout;     // 已超时
+  wait_entry_t entry[POLL_FD_MAX];
+} poll_wait_t;
+
+/**
+ * @brief poll超时定时器的回调函数
+ *
+ * @param arg
+ */
+static void poll_timeout(void *arg) {
+  poll_wait_t *wait = (poll_wait_t *)arg;
+  wait->timeout = 1;
+  sem_notify(&wait->sem);
+}
+
+/**
+ * @brief 检查一组文件的状态，第一次检查时将等待项加入各文件的等待队列
+ *
+ * @param fds
+ * @param nfds
+ * @param wait
+ * @return int 有事件发生的文件数
+ */
+static int poll_check(struct pollfd *fds, int nfds, poll_wait_t *wait) {
+  int count = 0;
+  for (int i = 0; i < nfds; ++i) {
+    struct pollfd *pfd = fds + i;
+    pfd->revents = 0;
+    if (pfd->fd < 0) {  // 负数描述符忽略
+      continue;
+    }
+
+    file_t *file = is_fd_bad(pfd->fd) ? (file_t *)0 : task_file(pfd->fd);
+    int mask = file ? file_poll(file, wait->entry + i) : POLLNVAL;
+
+    // 错误类事件总是返回
+    pfd->revents = mask & (pfd->events | POLLERR | POLLHUP | POLLNVAL);
+    if (pfd->revents) {
+      count++;
+    }
+  }
+
+  return count;
+}
+
+/**
+ * @brief 等待一组文件中任一文件可读写，没有事件时睡眠，由文件的等待队列或超时唤醒
+ *
+ * @param fds
+ * @param nfds 文件数，不超过POLL_FD_MAX
+ * @param timeout 超时时间，单位毫秒，为0时不等待，为负数时一直等待
+ * @return int 有事件发生的文件数，超时为0，失败为-1
+ */
+int sys_poll(struct pollfd *fds, int nfds, int timeout) {
+  if (nfds < 0 || nfds > POLL_FD_MAX || (nfds && !fds)) {
+    return -1;
+  }
+  if (mmap_prepare_write((uint32_t)fds, nfds * sizeof(struct pollfd)) < 0) {
+    return -1;
+  }
+
+  // 1.初始化等待状态，所有等待项共用一个信号量
+  poll_wait_t wait;
+  sem_init(&wait.sem, 0);
+  ktimer_init(&wait.timer, poll_timeout, &wait);
+  wait.timeout = 0;
+  for (int i = 0; i < nfds; ++i) {
+    wait.entry[i].queue = (wait_queue_t *)0;
+    wait.entry[i].sem = &wait.sem;
+  }
+
+  if (timeout > 0) {
+    ktimer_start_ms(&wait.timer, timeout);
+  }
+
+  // 2.检查文件状态，没有事件时等待唤醒后重新检查
+  // 等待项在检查前已加入等待队列，检查之后的状态变化会使sem_wait立即返回
+  int count;
+  while (1) {
+    count = poll_check(fds, nfds, &wait);
+    if (count || timeout == 0 || wait.timeout) {
+      break;
+    }
+
+    sem_wait(&wait.sem);
+  }
+
+  // 3.返回前停止定时器并移出所有等待队列，等待状态随后失效
+  ktimer_cancel(&wait.timer);
+  for (int i = 0; i < nfds; ++i) {
+    wait_queue_remove(wait.entry + i);
+  }
+
+  return count;
+}
+
 /**
  * @brief 根据文件路径删除文件
  *
@@ -570,12 +751,15 @@ static mutex_t *get_fs_mutex(fs_type_t type) {
   switch (type) {
     case FS_DEVFS:
       mutex_init(&devfs_mutex);
+      mutex_set_name(&devfs_mutex, "devfs");
       return &devfs_mutex;
     case FS_FAT16:
       mutex_init(&fatfs_mutex);
+      mutex_set_name(&fatfs_mutex, "fatfs");
       return &fatfs_mutex;
     case FS_FAT32:
       mutex_init(&fatfs_mutex);
+      mutex_set_name(&fatfs_mutex, "fatfs");
       return &fatfs_mutex;
     default:
       return 0;
@@ -663,6 +847,7 @@ void fs_init(void) {
   log_printf("fs init...\n");
   mount_list_init();
   file_table_init();
+  page_cache_init();
 
   disk_init();
 
@@ -0,0 +1,247 @@
+/**
+ * @file page_cache.c
+ * @author kbpoyo (kbpoyo@qq.com)
+ * @brief 文件页缓存，以(文件, 页偏移)为索引缓存文件内容，供文件映射共享使用
+ * @version 0.1
+ * @date 2023-09-02
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#include "fs/page_cache.h"
+
+#include "core/memory.h"
+#include "fs/fs.h"
+#include "ipc/mutex.h"
+#include "tools/klib.h"
+#include "tools/log.h"
+
+// 静态分配的页缓存项表
+static page_cache_entry_t entry_table[PAGE_CACHE_PAGE_COUNT];
+// 散列桶，按(文件系统, 起始簇号, 页索引)散列
+static list_t bucket_list[PAGE_CACHE_BUCKET_COUNT];
+// 空闲的页缓存项链表
+static list_t free_list;
+// 已缓存页的lru链表，链表头为最久未被访问的页
+static list_t lru_list;
+// 保护页缓存结构的互斥锁
+static mutex_t page_cache_mutex;
+
+/**
+ * @brief 计算缓存项所在的散列桶
+ *
+ * @param fs
+ * @param sblk
+ * @param index
+ * @return list_t*
+ */
+static inline list_t *page_cache_bucket(struct _fs_t *fs, int sblk,
+                                        uint32_t index) {
+  uint32_t key = ((uint32_t)fs >> 4) ^ ((uint32_t)sblk * 31) ^ index;
+  return bucket_list + (key & (PAGE_CACHE_BUCKET_COUNT - 1));
+}
+
+/**
+ * @brief 在散列桶中查找文件对应页的缓存项
+ *
+ * @param fs
+ * @param sblk
+ * @param index
+ * @return page_cache_entry_t*
+ */
+static page_cache_entry_t *page_cache_find(struct _fs_t *fs, int sblk,
+                                           uint32_t index) {
+  list_t *bucket = page_cache_bucket(fs, sblk, index);
+  list_node_t *node = list_get_first(bucket);
+  while (node) {
+    page_cache_entry_t *entry =
+        list_node_parent(node, page_cache_entry_t, hash_node);
+    if (entry->fs == fs && entry->sblk == sblk && entry->index == index) {
+      return entry;
+    }
+
+    node = list_node_next(node);
+  }
+
+  return (page_cache_entry_t *)0;
+}
+
+/**
+ * @brief 将缓存项从索引中移除，并释放页缓存对该页的引用
+ *        若该页仍被进程映射，则由最后一个解除映射的进程释放该页
+ *
+ * @param entry
+ */
+static void page_cache_drop(page_cache_entry_t *entry) {
+  list_remove(page_cache_bucket(entry->fs, entry->sblk, entry->index),
+              &entry->hash_node);
+  list_remove(&lru_list, &entry->lru_node);
+
+  memory_free_page(entry->page, 1);
+
+  entry->fs = (struct _fs_t *)0;
+  entry->page = 0;
+  list_insert_last(&free_list, &entry->hash_node);
+}
+
+/**
+ * @brief 获取一个可用的缓存项，没有空闲项时
+ *        淘汰最久未使用且未被任何进程映射的页
+ *
+ * @return page_cache_entry_t*
+ */
+static page_cache_entry_t *page_cache_alloc(void) {
+  // 1.优先使用空闲的缓存项
+  list_node_t *node = list_remove_first(&free_list);
+  if (node) {
+    return list_node_parent(node, page_cache_entry_t, hash_node);
+  }
+
+  // 2.从lru链表头开始寻找只被页缓存自身引用的页进行淘汰
+  node = list_get_first(&lru_list);
+  while (node) {
+    page_cache_entry_t *entry =
+        list_node_parent(node, page_cache_entry_t, lru_node);
+    if (memory_page_ref(entry->page) == 1) {
+      page_cache_drop(entry);
+      list_remove(&free_list, &entry->hash_node);
+      return entry;
+    }
+
+    node = list_node_next(node);
+  }
+
+  return (page_cache_entry_t *)0;
+}
+
+/**
+ * @brief 初始化页缓存
+ *
+ */
+void page_cache_init(void) {
+  mutex_init(&page_cache_mutex);
+  mutex_set_name(&page_cache_mutex, "page_cache");
+  list_init(&free_list);
+  list_init(&lru_list);
+
+  for (int i = 0; i < PAGE_CACHE_BUCKET_COUNT; ++i) {
+    list_init(bucket_list + i);
+  }
+
+  kernel_memset(entry_table, 0, sizeof(entry_table));
+  for (int i = 0; i < PAGE_CACHE_PAGE_COUNT; ++i) {
+    list_node_init(&entry_table[i].hash_node);
+    list_node_init(&entry_table[i].lru_node);
+    list_insert_last(&free_list, &entry_table[i].hash_node);
+  }
+}
+
+/**
+ * @brief 获取文件offset处所在页的缓存页，未缓存时从磁盘读取并缓存
+ *        返回前为调用者增加该页的一次引用，防止其在使用前被淘汰，
+ *        调用者使用完毕后需通过memory_free_page释放该引用
+ *
+ * @param file 被映射的文件
+ * @param offset 文件内的偏移量，按页大小对齐
+ * @return uint32_t 缓存页的物理地址，0：获取失败
+ */
+uint32_t page_cache_get(file_t *file, uint32_t offset) {
+  struct _fs_t *fs = file->fs;
+  if (!fs || !fs->op->read_page) {
+    return 0;
+  }
+
+  uint32_t index = offset / MEM_PAGE_SIZE;
+  uint32_t page = 0;
+
+  // 先获取文件系统锁再获取页缓存锁，与文件写操作中失效页缓存的加锁顺序一致
+  if (fs->mutex) mutex_lock(fs->mutex);
+  mutex_lock(&page_cache_mutex);
+
+  // 持有文件系统锁后再检查文件大小，文件可能在等待锁时被截断或删除
+  if (offset >= file->size) {
+    goto page_cache_get_end;
+  }
+
+  // 1.页已被缓存，更新其在lru链表中的位置
+  page_cache_entry_t *entry = page_cache_find(fs, file->sblk, index);
+  if (entry) {
+    list_remove(&lru_list, &entry->lru_node);
+    list_insert_last(&lru_list, &entry->lru_node);
+    page = entry->page;
+    goto page_cache_get_end;
+  }
+
+  // 2.页未被缓存，分配缓存项和物理页
+  entry = page_cache_alloc();
+  if (!entry) {
+    log_error("page cache is full.\n");
+    goto page_cache_get_end;
+  }
+
+  page = memory_alloc_page(1, MEM_TAG_PAGE_CACHE);
+  if (page == 0) {
+    list_insert_last(&free_list, &entry->hash_node);
+    goto page_cache_get_end;
+  }
+  // 页缓存自身持有该页的一次引用
+  memory_page_ref_add(page);
+
+  // 3.由文件系统将文件内容直接读入缓存页
+  if (fs->op->read_page(file, index * MEM_PAGE_SIZE, (char *)page) < 0) {
+    memory_free_page(page, 1);
+    list_insert_last(&free_list, &entry->hash_node);
+    page = 0;
+    goto page_cache_get_end;
+  }
+
+  // 4.记录缓存项并插入索引
+  entry->fs = fs;
+  entry->sblk = file->sblk;
+  entry->index = index;
+  entry->page = page;
+  list_insert_last(page_cache_bucket(fs, file->sblk, index),
+                   &entry->hash_node);
+  list_insert_last(&lru_list, &entry->lru_node);
+
+page_cache_get_end:
+  if (page) {
+    memory_page_ref_add(page);
+  }
+  mutex_unlock(&page_cache_mutex);
+  if (fs->mutex) mutex_unlock(fs->mutex);
+  return page;
+}
+
+/**
+ * @brief 使文件的所有缓存页失效，文件内容被修改或删除时调用
+ *        调用者需持有文件系统锁
+ *
+ * @param fs
+ * @param sblk 文件起始簇号
+ */
+void page_cache_invalidate(struct _fs_t *fs, int sblk) {
+  mutex_lock(&page_cache_mutex);
+
+  list_node_t *node = list_get_first(&lru_list);
+  while (node) {
+    list_node_t *next = list_node_next(node);
+    page_cache_entry_t *entry =
+        list_node_parent(node, page_cache_entry_t, lru_node);
+    if (entry->fs == fs && entry->sblk == sblk) {
+      page_cache_drop(entry);
+    }
+
+    node = next;
+  }
+
+  mutex_unlock(&page_cache_mutex);
+}
+
+/**
+ * @brief 获取当前已缓存的页数
+ *
+ * @return int
+ */
+int page_cache_page_count(void) { return list_get_size(&lru_list); }
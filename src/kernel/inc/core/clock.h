@@ -0,0 +1,44 @@
+/**
+ * @file clock.h
+ * @author kbpoyo (kbpoyo@qq.com)
+ * @brief 单调时钟与所有进程共享的只读时间页
+ * @version 0.1
+ * @date 2023-09-21
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+#ifndef CLOCK_H
+#define CLOCK_H
+
+#include "common/types.h"
+
+// 时钟编号，与newlib中的CLOCK_REALTIME、CLOCK_MONOTONIC一致
+#define CLOCK_ID_REALTIME 1
+#define CLOCK_ID_MONOTONIC 4
+
+// 时间页的虚拟地址，为内核空间的最后一页，所有进程共享内核空间的页表，用户模式只读
+#define CLOCK_PAGE_ADDR 0x7ffffc00u
+
+// 时间，与newlib中的struct timespec布局一致
+typedef struct _clock_time_t {
+  uint32_t sec;
+  uint32_t nsec;
+} clock_time_t;
+
+// 时间页的内容，每个时间片由时钟中断更新一次
+typedef struct _clock_page_t {
+  volatile uint32_t seq;  // 更新序号，奇数表示正在更新，读取前后序号相同且为偶数时内容有效
+  volatile uint32_t tick;  // 系统启动后经过的时间片数
+  volatile uint32_t sec;   // 最近一次更新时的单调时间
+  volatile uint32_t usec;
+  uint32_t tick_us;  // 时间页的分辨率，即每个时间片的微秒数
+} clock_page_t;
+
+void clock_init(void);
+void clock_tick(uint32_t tick);
+void clock_monotonic(clock_time_t *time);
+int sys_clock_gettime(int clock_id, clock_time_t *time);
+int sys_gettimeofday(clock_time_t *tv, void *tz);
+
+#endif
@@ -17,9 +17,18 @@ enum {
   DEV_UNKNOWN = 0,
   DEV_TTY,   // TTY设备
   DEV_DISK,  // 磁盘设备
+  DEV_KMSG,  // 内核日志设备
+  DEV_MEM,   // 内存字符设备，即null与zero
+
+  DEV_TYPE_COUNT,
 };
 
+// 内存字符设备的设备号
+#define DEV_MEM_NULL 0  // 读取总是到达文件末尾，写入的数据被丢弃
+#define DEV_MEM_ZERO 1  // 读取总是得到0，写入的数据被丢弃
+
 struct _dev_desc_t;
+struct _wait_entry_t;
 // 定义某种特定类型的硬件结构
 typedef struct _device_t {
   int dev_type;   // 指定设备类型
@@ -29,10 +38,12 @@ typedef struct _device_t {
   int open_count;            // 设备打开次数
   struct _dev_desc_t *desc;  // 设备类型描述结构
 } device_t;
+int dev_register(int dev_type, struct _dev_desc_t *desc);
 int dev_open(int dev_type, int dev_code, void *data);
 int dev_read(int dev_id, int addr, char *buf, int size);
 int dev_write(int dev_id, int addr, char *buf, int size);
 int dev_control(int dev_id, int cmd, int arg0, int arg1);
+int dev_poll(int dev_id, struct _wait_entry_t *entry);
 void dev_close(int dev_id);
 
 #define DEV_NAME_SIZE 20
@@ -40,15 +51,23 @@ void dev_close(int dev_id);
 typedef struct _dev_desc_t {
   char dev_name[DEV_NAME_SIZE];                                // 设备名称
   int (*open)(device_t *dev);                                  // 打开设备
+  // 块设备的addr为起始扇区，字符设备没有读写位置，addr为文件的打开标志
   int (*read)(device_t *dev, int addr, char *buf, int size);   // 读取设备
   int (*write)(device_t *dev, int addr, char *buf, int size);  // 写入设备
   int (*control)(device_t *dev, int cmd, int arg0,
                  int arg1);      // 向设备发送控制指令
   void (*close)(device_t *dev);  // 关闭设备
+  // 获取设备当前的可读写状态，entry不为0时将其加入设备的等待队列，可为0
+  int (*poll)(device_t *dev, struct _wait_entry_t *entry);
 
 } dev_desc_t;
 
 // 定义dev控制指令
 #define DEV_CMD_DISK_WRITE_BACK 0x1
+#define DEV_CMD_BLOCK_SIZE 0x2  // 获取块设备的块大小，通过返回值返回
+
+// 内置字符设备的初始化，向设备管理层与设备文件系统注册
+void kmsg_init(void);
+void mem_dev_init(void);
 
 #endif
\ No newline at end of file
@@ -27,6 +27,7 @@
 
 // 定义磁盘控制指令
 #define DISK_CMD_WRITE_BACK DEV_CMD_DISK_WRITE_BACK
+#define DISK_CMD_SECTOR_SIZE DEV_CMD_BLOCK_SIZE
 
 #pragma pack(1)
 // 分区表结构
@@ -64,6 +65,7 @@ typedef struct _partinfo_t {
     FS_INVALID = 0x00,  // 无效分区
     FS_FAT16_0 = 0x6,   // fat16分区，类型1
     FS_FAT16_1 = 0xE,   // fat16分区，类型2
+    FS_SWAP = 0x82,     // 交换分区
 
   } type;
 
@@ -107,5 +109,6 @@ typedef struct _disk_opt_t {
 
 
 void disk_init(void);
+partinfo_t *disk_find_part(int type, int *dev_index);
 
 #endif
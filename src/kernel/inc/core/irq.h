@@ -1,7 +1,9 @@
 #ifndef IRQ_H
 #define IRQ_H
 
+#include "common/os_config.h"
 #include "common/register_addr.h"
+#include "common/types.h"
 
 #define IRQ_NUM_MAX 32
 
@@ -30,6 +32,15 @@
 #define INT_TIMER3  13
 #define INT_TIMER4  14
 
+//DMA中断
+#define INT_DMA0    17
+#define INT_DMA1    18
+#define INT_DMA2    19
+#define INT_DMA3    20
+
+//SD卡控制器中断
+#define INT_SDI     21
+
 //外部中断
 #define EINT8_23    5
 #define EINT4_7    4
@@ -47,13 +58,51 @@ void irq_disable_all();
 void irq_clear(int irq_num_prim, int irq_num_sub);
 void irq_clear_all();
 
-void irq_handler();
+void irq_handler(uint32_t pc, uint32_t spsr);
+uint32_t irq_return_pc(void);
+uint32_t irq_return_spsr(void);
 
 
 
 typedef void(*irq_handler_t)(void);
 
 void irq_handler_register(int irq_num, irq_handler_t handler_for_irq);
+int irq_in_interrupt(void);
+void irq_exit(void);
+
+// 中断统计的控制指令
+#define IRQ_STAT_CMD_READ 0   // 将统计读到arg0指向的irq_stats_t中
+#define IRQ_STAT_CMD_CLEAR 1  // 清空统计
+
+#define IRQ_STAT_NAME_SIZE 12
+// 处理时间的单位，与定时器的分辨率TIMER_RESOLVING_POWER一致
+#define IRQ_STAT_TIME_UNIT_US 20
+// 进入延迟直方图的桶数，第0个桶为[0, 20)us，之后每个桶的上界翻倍，最后一个桶不设上界
+#define IRQ_LAT_BUCKETS 8
+#define IRQ_LAT_BUCKET0_US 20
+
+// 单个中断源的统计
+typedef struct _irq_stat_t {
+  char name[IRQ_STAT_NAME_SIZE];
+  uint32_t count;                     // 中断次数
+  uint32_t time_total;                // 处理函数的总执行时间
+  uint32_t time_min;                  // 最短执行时间
+  uint32_t time_max;                  // 最长执行时间
+  uint32_t latency[IRQ_LAT_BUCKETS];  // 进入延迟直方图，只有提供了延迟测量函数的中断源才有
+} irq_stat_t;
+
+// 所有中断源的统计
+typedef struct _irq_stats_t {
+  uint32_t elapsed;   // 自清空统计以来经过的时间，单位同处理时间
+  uint32_t spurious;  // 伪中断次数，即没有挂起的中断或没有注册处理函数
+  irq_stat_t irq[IRQ_NUM_MAX];
+} irq_stats_t;
+
+// 获取中断源从产生到当前经过的微秒数，用于测量进入延迟
+typedef uint32_t (*irq_latency_t)(void);
+
+void irq_latency_register(int irq_num, irq_latency_t latency);
+int sys_irq_stat(int cmd, int arg0);
 
 
 #endif
\ No newline at end of file
@@ -0,0 +1,38 @@
+/**
+ * @file klib_bench.h
+ * @author kbpoyo (kbpoyo@qq.com)
+ * @brief 内存拷贝、赋值与比较函数的基准测试，对比汇编实现与原逐字节实现
+ * @version 0.1
+ * @date 2023-09-23
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+#ifndef KLIB_BENCH_H
+#define KLIB_BENCH_H
+
+#include "common/types.h"
+
+// 单次测试的最大字节数
+#define KLIB_BENCH_SIZE_MAX (16 * 1024)
+// 耗时的单位，与定时器的分辨率TIMER_RESOLVING_POWER一致
+#define KLIB_BENCH_TIME_UNIT_US 20
+
+// 一次基准测试的参数与结果，参数由调用者填写，结果由内核填写
+typedef struct _klib_bench_t {
+  uint32_t size;    // 每次操作的字节数，不超过KLIB_BENCH_SIZE_MAX
+  uint32_t offset;  // 源地址相对于按字对齐的目的地址的偏移，取0~3
+  uint32_t loops;   // 每个函数重复执行的次数
+
+  // 各函数重复loops次的总耗时
+  uint32_t asm_memcpy;
+  uint32_t byte_memcpy;
+  uint32_t asm_memset;
+  uint32_t byte_memset;
+  uint32_t asm_memcmp;
+  uint32_t byte_memcmp;
+} klib_bench_t;
+
+int sys_klib_bench(klib_bench_t *bench);
+
+#endif
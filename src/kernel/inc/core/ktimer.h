@@ -0,0 +1,39 @@
+/**
+ * @file ktimer.h
+ * @author kbpoyo (kbpoyo@qq.com)
+ * @brief 内核定时器，到期后在下半部中执行回调函数
+ * @version 0.1
+ * @date 2023-09-21
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+#ifndef KTIMER_H
+#define KTIMER_H
+
+#include "common/types.h"
+#include "tools/list.h"
+
+// 轮询等待时的睡眠间隔，从最小值开始每次翻倍，直到最大值
+#define KTIMER_POLL_MIN_US 40
+#define KTIMER_POLL_MAX_US 2000
+
+// 内核定时器，回调函数在下半部中执行，不可睡眠
+typedef struct _ktimer_t {
+  list_node_t node;
+  uint32_t expire;  // 到期时的定时器计数，单位同timer_get_count
+  void (*func)(void *arg);
+  void *arg;
+  int active;  // 是否在定时器队列中等待到期
+} ktimer_t;
+
+void ktimer_init(ktimer_t *timer, void (*func)(void *arg), void *arg);
+void ktimer_start_us(ktimer_t *timer, uint32_t us);
+void ktimer_start_ms(ktimer_t *timer, uint32_t ms);
+int ktimer_cancel(ktimer_t *timer);
+void ktimer_sleep_us(uint32_t us);
+void ktimer_sleep_ms(uint32_t ms);
+int ktimer_wait(int (*done)(void *arg), void *arg, uint32_t timeout_us);
+void ktimer_system_init(void);
+
+#endif
@@ -22,6 +22,25 @@
 #define MEM_TASK_STACK_SIZE (MEM_PAGE_SIZE * 50)
 // 定义分配给每个应用程序的入口参数的空间大小
 #define MEM_TASK_ARG_SIZE (MEM_PAGE_SIZE * 4)
+// 定义应用程序文件映射区的虚拟地址范围，位于堆区与栈区之间
+#define MEM_TASK_MMAP_START 0xA0000000
+#define MEM_TASK_MMAP_END 0xB0000000
+
+// 分配页的用途，用于统计各子系统占用的内存
+typedef enum _mem_tag_t {
+  MEM_TAG_OTHER = 0,
+  MEM_TAG_PAGE_TABLE,  // 页目录表与页表
+  MEM_TAG_TASK,        // 任务对象与pid索引
+  MEM_TAG_KSTACK,      // 任务内核栈
+  MEM_TAG_FILE,        // 系统与任务的文件表
+  MEM_TAG_FAT_TABLE,   // fat表缓存
+  MEM_TAG_FAT_BUF,     // fat文件系统的扇区与簇缓冲区
+  MEM_TAG_PAGE_CACHE,  // 页缓存
+  MEM_TAG_SHM,         // 共享内存
+  MEM_TAG_USER,        // 用户空间的页
+
+  MEM_TAG_COUNT,
+} mem_tag_t;
 
 // 内存分配对象
 typedef struct _addr_alloc_t {
@@ -34,6 +53,8 @@ typedef struct _addr_alloc_t {
       [(MEM_EXT_END - MEM_EXT_START) /
        MEM_PAGE_SIZE];  // TODO,由于引用计数占用空间较大，经计算，在1mb一下加载内核，管理内存大小不能超过1gb
 
+  uint8_t *page_tag;                     // 每一页的用途，紧邻位图存放
+  uint32_t tag_pages[MEM_TAG_COUNT];     // 各用途占用的页数
 } addr_alloc_t;
 
 // 定义内存映射的数据结构
@@ -68,6 +89,10 @@ typedef struct _memory_map_t {
 #define MEM_SD_START  0x5a000000
 #define MEM_SD_END  0x5a000040
 
+// DMA控制器相关寄存器组
+#define MEM_DMA_START 0x4b000000
+#define MEM_DMA_END 0x4b000100
+
 void memory_init();
 uint32_t memory_creat_uvm(void);
 int memory_copy_uvm(uint32_t to_page_dir, uint32_t from_page_dir);
@@ -79,10 +104,19 @@ uint32_t memory_get_paddr(uint32_t page_dir, uint32_t vaddr);
 int memory_alloc_page_for(uint32_t vaddr, uint32_t alloc_size,
                           uint32_t priority);
 
-uint32_t memory_alloc_page(int page_count);
-uint32_t memory_alloc_page_align(int page_count, int align);
+uint32_t memory_alloc_page(int page_count, mem_tag_t tag);
+uint32_t memory_alloc_page_align(int page_count, int align, mem_tag_t tag);
 
 void memory_free_page(uint32_t addr, int page_count);
+pte_t *find_pte(pde_t *page_dir, uint32_t vstart, int is_alloc);
+int memory_creat_map(pde_t *page_dir, uint32_t vstart, uint32_t pstart,
+                     int page_count, uint32_t access_perim);
+void memory_unmap_for_page_dir(uint32_t page_dir, uint32_t vaddr,
+                               int page_count);
+int memory_copy_page(uint32_t page_dir, uint32_t vaddr, uint32_t privilege);
+void memory_page_ref_add(uint32_t paddr);
+int memory_page_ref(uint32_t paddr);
+void memory_set_guard_page(uint32_t addr, int is_guard);
 int memory_copy_uvm_data(uint32_t to_vaddr, uint32_t to_page_dir,
                          uint32_t from_vaddr, uint32_t size);
 
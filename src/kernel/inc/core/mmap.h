@@ -0,0 +1,77 @@
+/**
+ * @file mmap.h
+ * @author kbpoyo (kbpoyo@qq.com)
+ * @brief 进程的文件映射区管理
+ * @version 0.1
+ * @date 2023-09-02
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+#ifndef MMAP_H
+#define MMAP_H
+
+#include "common/types.h"
+#include "fs/file.h"
+#include "tools/list.h"
+
+// 静态分配映射区，定义映射区数量
+#define MMAP_AREA_COUNT 256
+
+// 映射区的访问权限
+#define PROT_NONE 0x0
+#define PROT_READ 0x1
+#define PROT_WRITE 0x2
+#define PROT_EXEC 0x4
+
+// 映射区的映射方式
+#define MAP_SHARED 0x01   // 共享映射，所有进程看到同一份页缓存
+#define MAP_PRIVATE 0x02  // 私有映射，写入时复制出进程私有的页
+
+#define MAP_FAILED ((void *)-1)
+
+// 映射区结构，描述进程虚拟空间中一段被映射的文件内容
+typedef struct _mmap_area_t {
+  uint32_t start;   // 映射区起始虚拟地址，按页对齐
+  uint32_t end;     // 映射区结束虚拟地址，按页对齐
+  int prot;         // 映射区的访问权限
+  int flags;        // 映射方式
+  uint32_t offset;  // 映射区起始地址对应的文件或共享内存段内的偏移量
+  // 被映射文件的快照，使文件描述符关闭后映射依然有效
+  file_t file;
+  // 映射的共享内存段，非0时映射区映射的是共享内存而非文件
+  struct _shm_t *shm;
+
+  list_node_t node;  // 插入任务的映射区链表或空闲链表的节点
+} mmap_area_t;
+
+// mmap系统调用的参数结构，参数个数超过了系统调用的4个参数
+typedef struct _mmap_args_t {
+  void *addr;
+  uint32_t length;
+  int prot;
+  int flags;
+  int fd;
+  uint32_t offset;
+} mmap_args_t;
+
+struct _task_t;
+
+void mmap_init(void);
+mmap_area_t *mmap_area_creat(struct _task_t *task, uint32_t hint,
+                             uint32_t size, int prot, int flags);
+mmap_area_t *mmap_area_find(struct _task_t *task, uint32_t vaddr);
+int mmap_copy(struct _task_t *to, struct _task_t *from);
+void mmap_destroy(struct _task_t *task);
+int mmap_handle_fault(uint32_t vaddr, uint32_t fault_state);
+int mmap_prepare_write(uint32_t vaddr, uint32_t size);
+int copy_to_user(void *dest, const void *src, uint32_t size);
+
+struct _fs_t;
+void mmap_revoke(struct _fs_t *fs, int sblk);
+void mmap_update_file(int sblk, file_t *file);
+
+int sys_mmap(mmap_args_t *args);
+int sys_munmap(void *addr, uint32_t length);
+
+#endif
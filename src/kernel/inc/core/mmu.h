@@ -36,6 +36,22 @@
 // 定义cr3寄存器的位域
 #define CR3_D0 (1 << 0)  // 将D0域的权限控制设置为只由页表项的AP位确定
 
+/**
+ * cache锁定(cr9)：cache分为8个组，每组64路，[31:26]为替换指针与锁定基址，
+ *      低于锁定基址的路不会被替换，锁定一路即在8个组中各锁定一行，共256字节
+ * tlb锁定(cr10)：指令与数据tlb各64项，[31:26]为锁定基址，[25:20]为替换指针，
+ *      [0]为保留位，置位时载入的项不会被使整个tlb无效的操作清除
+ */
+#define CACHE_LOCK_WAY_SIZE 256         // 锁定一路覆盖的连续地址范围
+#define CACHE_LOCK_WAY_MAX 16           // 指令与数据cache各自最多锁定的路数
+#define TLB_LOCK_ENTRY_MAX 16           // 指令与数据tlb各自最多锁定的项数
+#define CACHE_LOCK_VECTOR_SIZE 1024     // 锁定的异常向量与启动代码中异常入口的大小
+#define CR9_INDEX(way) ((way) << 26)
+#define CR10_ENTRY(base, victim, p) (((base) << 26) | ((victim) << 20) | (p))
+
+// 放入锁定段的函数，锁定段在启动时被锁定到指令cache与指令tlb中
+#define LOCKDOWN_TEXT __attribute__((section(".text.lockdown")))
+
 /**
  * 映射关系为：
  *      4GB = 4096x1mb(4096个页目录项)
@@ -184,4 +200,10 @@ static inline void mmu_set_page_dir(uint32_t paddr) {
 
 void enable_mmu();
 
+int cache_lock_text(uint32_t start, uint32_t end);
+int cache_lock_data(uint32_t start, uint32_t end);
+int tlb_lock_text(uint32_t start, uint32_t end);
+int tlb_lock_data(uint32_t start, uint32_t end);
+void mmu_lockdown_init(void);
+
 #endif
\ No newline at end of file
@@ -0,0 +1,60 @@
+/**
+ * @file prof.h
+ * @author kbpoyo (kbpoyo@qq.com)
+ * @brief 采样分析，由定时器3周期性中断记录被中断的指令地址，
+ *        用户程序通过系统调用导出后由主机端工具对照elf文件符号化
+ * @version 0.1
+ * @date 2023-09-18
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+#ifndef PROF_H
+#define PROF_H
+
+#include "common/os_config.h"
+#include "common/types.h"
+
+// 任务名称长度，与TASK_NAME_SIZE一致
+#define PROF_NAME_SIZE 32
+// 可记录的不同任务数量，同一任务加载新程序后视为不同的任务
+#define PROF_TASK_COUNT 64
+#define PROF_NO_TASK 0xffffffff
+
+// 控制指令
+#define PROF_CMD_START 0  // 清空样本并开始采样
+#define PROF_CMD_STOP 1   // 停止采样
+#define PROF_CMD_READ 2  // 将最多arg1个样本读到arg0中，返回读取的个数
+#define PROF_CMD_READ_TASKS 3  // 将最多arg1个任务信息读到arg0中，返回读取的个数
+#define PROF_CMD_DROPPED 4     // 获取样本缓冲区满后丢弃的样本数
+
+// 导出文件的魔数与版本
+#define PROF_FILE_MAGIC 0x4652504b  // "KPRF"
+#define PROF_FILE_VERSION 1
+
+// 样本
+typedef struct _prof_sample_t {
+  uint32_t pc;    // 被中断的指令地址
+  uint32_t task;  // 被中断的任务在任务信息表中的索引，PROF_NO_TASK：尚未运行任务
+  uint32_t mode;  // 被中断时的处理器模式
+} prof_sample_t;
+
+// 采样期间出现过的任务，用于将用户态样本对应到程序文件
+typedef struct _prof_task_t {
+  uint32_t pid;
+  char name[PROF_NAME_SIZE];
+} prof_task_t;
+
+// 导出文件头，其后紧跟task_count个任务信息与sample_count个样本
+typedef struct _prof_file_header_t {
+  uint32_t magic;
+  uint32_t version;
+  uint32_t period_us;     // 采样周期
+  uint32_t task_count;    // 任务信息个数
+  uint32_t sample_count;  // 样本个数
+  uint32_t dropped;       // 丢弃的样本数
+} prof_file_header_t;
+
+int sys_prof(int cmd, int arg0, int arg1);
+
+#endif
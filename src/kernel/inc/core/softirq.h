@@ -0,0 +1,48 @@
+/**
+ * @file softirq.h
+ * @author kbpoyo (kbpoyo@qq.com)
+ * @brief 中断下半部，中断处理函数只做必要的硬件操作，其余工作在中断返回前打开中断执行
+ * @version 0.1
+ * @date 2023-09-20
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+#ifndef SOFTIRQ_H
+#define SOFTIRQ_H
+
+#include "common/types.h"
+#include "tools/list.h"
+
+// 下半部类型，编号越小越先执行
+typedef enum _softirq_nr_t {
+  SOFTIRQ_TIMER,    // 时钟中断的时间片处理
+  SOFTIRQ_KTIMER,   // 内核定时器的到期处理
+  SOFTIRQ_TASKLET,  // 小任务
+
+  SOFTIRQ_COUNT,
+} softirq_nr_t;
+
+// 一次中断返回中重复处理新产生的下半部的最大轮数，剩余的留到下一次中断返回
+#define SOFTIRQ_RESTART_MAX 4
+
+typedef void (*softirq_handler_t)(void);
+
+// 小任务，由中断处理函数调度，在下半部中执行，执行期间不可睡眠
+typedef struct _tasklet_t {
+  list_node_t node;
+  void (*func)(void *arg);
+  void *arg;
+  int scheduled;  // 是否已在待执行队列中
+} tasklet_t;
+
+void softirq_register(softirq_nr_t nr, softirq_handler_t handler);
+void softirq_raise(softirq_nr_t nr);
+int softirq_in_progress(void);
+void softirq_run(void);
+
+void tasklet_init(tasklet_t *tasklet, void (*func)(void *arg), void *arg);
+void tasklet_schedule(tasklet_t *tasklet);
+void softirq_init(void);
+
+#endif
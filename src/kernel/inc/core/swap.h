@@ -0,0 +1,59 @@
+/**
+ * @file swap.h
+ * @author kbpoyo (kbpoyo@qq.com)
+ * @brief 交换空间，内存不足时将进程的匿名页换出到磁盘的交换分区
+ * @version 0.1
+ * @date 2023-09-08
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+#ifndef SWAP_H
+#define SWAP_H
+
+#include "common/types.h"
+#include "core/mmu.h"
+
+// 交换分区最多可使用的槽位数量，每个槽位存放一页，共16MB
+#define SWAP_SLOT_MAX (16 * 1024)
+// 每个槽位占用的扇区数
+#define SWAP_SECTOR_SIZE 512
+#define SWAP_SECTORS_PER_SLOT (MEM_PAGE_SIZE / SWAP_SECTOR_SIZE)
+// 分配页失败时一次回收的页数
+#define SWAP_RECLAIM_BATCH 16
+
+/**
+ * 被换出页的页表项格式：
+ *      [1:0] = 0b00，页表项无效，访问时产生缺页异常
+ *      [2] = 1，标识该页已被换出
+ *      [31:10] 页所在的交换槽位号
+ */
+#define SWAP_PTE_FLAG (1 << 2)
+
+/**
+ * @brief 判断页表项是否记录了一个被换出的页
+ *
+ * @param pte
+ * @return int
+ */
+static inline int pte_is_swap(pte_t *pte) {
+  return pte->domain.flag == 0 && (pte->v & SWAP_PTE_FLAG);
+}
+
+/**
+ * @brief 获取被换出页所在的槽位号
+ *
+ * @param pte
+ * @return int
+ */
+static inline int pte_to_swap_slot(pte_t *pte) { return pte->v >> 10; }
+
+void swap_init(void);
+int swap_reclaim(int page_count);
+void swap_lock(void);
+void swap_unlock(void);
+int swap_read_page(pte_t *pte, uint32_t page);
+void swap_free_slot(pte_t *pte);
+int swap_handle_fault(uint32_t vaddr, uint32_t fault_state);
+
+#endif
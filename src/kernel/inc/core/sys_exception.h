@@ -24,8 +24,11 @@ typedef struct _exception_frame_t {
 
 void undef_handler(exception_frame_t* frame);
 
-void data_abort_handler(exception_frame_t* frame);
+void data_abort_handler(exception_frame_t* frame, uint32_t spsr,
+                        uint32_t fault_addr, uint32_t fault_state);
 
-void prefetch_abort_handler(exception_frame_t* frame);
+void prefetch_abort_handler(exception_frame_t* frame, uint32_t spsr);
+
+void stack_overflow_handler(uint32_t spsr);
 
 #endif
\ No newline at end of file
@@ -50,6 +50,33 @@
 #define SYS_memory_stat 64
 #define SYS_task_stat 65
 
+// 文件映射系统调用
+#define SYS_mmap 66
+#define SYS_munmap 67
+
+// 共享内存系统调用
+#define SYS_shmget 68
+#define SYS_shmat 69
+#define SYS_shmdt 70
+#define SYS_shmctl 71
+
+// 内核事件跟踪系统调用
+#define SYS_trace 72
+#define SYS_prof 73
+#define SYS_lock_stat 74
+#define SYS_irq_stat 75
+
+// 时钟相关系统调用
+#define SYS_clock_gettime 76
+#define SYS_gettimeofday 77
+
+// 文件多路等待相关系统调用
+#define SYS_fcntl 78
+#define SYS_poll 79
+
+// 内存函数基准测试系统调用
+#define SYS_klib_bench 80
+
 #pragma pack(1)
 /**
  * @brief 系统调用的参数结构体
@@ -14,13 +14,12 @@
 
 #include "common/types.h"
 #include "fs/file.h"
+#include "tools/hash.h"
 #include "tools/list.h"
 
 // 定义任务名称缓冲区大小
 #define TASK_NAME_SIZE 32
 
-// 静态分配任务，定义任务数量
-#define TASK_COUNT 128
 
 // 定义每个进程所能拥有的时间切片数量
 #define TASK_TIME_SLICE_DEFAULT 10
@@ -28,9 +27,17 @@
 // 定义空闲进程的栈空间大小
 #define EMPTY_TASK_STACK_SIZE 128
 
-// 定义进程可打开的文件数量大小
+// 定义内核线程的栈空间大小
+#define TASK_KTHREAD_STACK_SIZE (4 * 1024)
+
+// 定义进程可打开的文件数量上限，打开文件表按需扩充
 #define TASK_OFILE_SIZE 128
 
+// 定义pid索引哈希表的初始桶数，任务增多时按需扩容
+#define TASK_PID_BUCKETS 16
+// 定义进程初始的打开文件表大小，内嵌在任务结构中
+#define TASK_OFILE_INIT 8
+
 // 设置任务进程的特权级标志位
 #define TASK_FLAGS_SYSTEM (1 << 0)  // 内核特权级即最高特权级
 #define TASK_FLAGS_USER (0 << 0)    // 用户特权级
@@ -85,12 +92,17 @@ typedef struct _task_t {
   list_node_t task_node;  // 用于插入任务队列的节点，标记task在任务队列中的位置
   list_node_t
       wait_node;  // 用于插入信号量对象的等待队列的节点，标记task正在等待信号量
+  hash_node_t pid_node;  // 用于插入pid索引的节点
 
   task_switch_t task_sw;  // 存放内核栈指针和任务页目录表，随着进程切换而切换
   uint32_t svc_sp_top;  // 记录内核栈的起始位置
 
   register_group_t reg_group;           // 任务寄存器组
-  file_t *file_table[TASK_OFILE_SIZE];  // 任务进程所拥有的文件表
+  file_t **file_table;  // 任务进程所拥有的文件表，指向ofile_init或扩充后的表
+  int ofile_size;       // 文件表的容量
+  int ofile_top;        // 文件表已使用部分的上界，大于所有已打开的文件描述符
+  file_t *ofile_init[TASK_OFILE_INIT];  // 初始的内嵌文件表
+  list_t mmap_list;                     // 任务进程的文件映射区链表
 
 } task_t;
 
@@ -108,10 +120,15 @@ typedef struct _task_manager_t {
   list_t task_list;   // 任务队列，包含所有的任务
   list_t sleep_list;  // 延时队列，包含当前需要延时的任务
 
+  hash_table_t pid_table;  // 以pid为键值的任务索引，与任务队列同步维护
+  hash_node_t *pid_buckets[TASK_PID_BUCKETS];  // pid索引的初始桶数组
+
   task_t first_task;  // 执行的第一个任务
   task_t
       empty_task;  // 一个空的空闲进程，当所有进程都延时运行时，让cpu运行空闲进程
 
+  int need_resched;  // 中断上下文中被推迟的任务切换，中断返回前进行
+
 } task_manager_t;
 
 // 定义任务入口参数的数据结构
@@ -131,10 +148,17 @@ void task_set_sleep(task_t *task, uint32_t slice);
 void task_set_wakeup(task_t *task);
 void task_slice_end(void);
 void task_switch(void);
+void task_resched(void);
 task_t *task_current(void);
-task_t *task_alloc(void);
+file_t *task_file(int fd);
+task_t *task_next(task_t *task);
+task_t *task_find(int pid);
+void task_list_lock(void);
+void task_list_unlock(void);
 
 void task_start(task_t *task);
+task_t *task_create_kernel(const char *name, void (*entry)(void *arg),
+                           void *arg);
 
 // //系统调用函数
 void sys_sleep(uint32_t ms);
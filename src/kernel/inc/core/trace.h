@@ -0,0 +1,86 @@
+/**
+ * @file trace.h
+ * @author kbpoyo (kbpoyo@qq.com)
+ * @brief 内核事件跟踪，静态跟踪点将定长的二进制记录写入环形缓冲区，
+ *        用户程序通过系统调用导出后由主机端工具解析为时间线
+ * @version 0.1
+ * @date 2023-09-17
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+#ifndef TRACE_H
+#define TRACE_H
+
+#include "common/os_config.h"
+#include "common/types.h"
+
+// 事件类型，作为使能掩码中的位号
+#define TRACE_SCHED_SWITCH 0  // 任务切换，arg0：切出任务pid，arg1：切入任务pid
+#define TRACE_SCHED_WAKEUP 1  // 唤醒等待信号量的任务，arg0：被唤醒任务pid，arg1：信号量地址
+#define TRACE_SYSCALL_ENTER 2  // 进入系统调用，arg0：调用id，arg1：第一个参数
+#define TRACE_SYSCALL_EXIT 3   // 退出系统调用，arg0：调用id，arg1：返回值
+#define TRACE_IRQ_ENTER 4      // 进入中断处理，arg0：中断号
+#define TRACE_IRQ_EXIT 5       // 退出中断处理，arg0：中断号
+#define TRACE_DISK_READ 6   // 开始读磁盘，arg0：起始扇区，arg1：扇区数
+#define TRACE_DISK_WRITE 7  // 开始写磁盘，arg0：起始扇区，arg1：扇区数
+#define TRACE_DISK_DONE 8   // 磁盘读写完成，arg0：起始扇区，arg1：结果
+#define TRACE_PAGE_FAULT 9  // 缺页异常，arg0：出错地址，arg1：失效状态
+#define TRACE_EVENT_COUNT 10
+
+#define TRACE_MASK_ALL ((1 << TRACE_EVENT_COUNT) - 1)
+
+// 记录的标志位
+#define TRACE_FLAG_IRQ (1 << 0)  // 在中断上下文中记录
+
+// 控制指令
+#define TRACE_CMD_SET_MASK 0  // 设置使能掩码为arg0，返回原来的掩码
+#define TRACE_CMD_READ 1  // 将最近的最多arg1条记录按时间顺序读到arg0中，返回读取的条数
+#define TRACE_CMD_CLEAR 2  // 清空缓冲区
+
+// 导出文件的魔数与版本
+#define TRACE_FILE_MAGIC 0x4354524b  // "KRTC"
+#define TRACE_FILE_VERSION 1
+// 时间戳的单位，与定时器的分辨率TIMER_RESOLVING_POWER一致
+#define TRACE_TIME_UNIT_US 20
+
+// 事件记录，固定20字节
+typedef struct _trace_record_t {
+  uint32_t time;   // 时间戳，单位为TIMER_RESOLVING_POWER微秒
+  uint16_t event;  // 事件类型
+  uint16_t flags;  // 标志位
+  uint32_t pid;    // 记录时的当前任务pid，0：尚未运行任务
+  uint32_t arg0;
+  uint32_t arg1;
+} trace_record_t;
+
+// 导出文件头，其后紧跟count条记录
+typedef struct _trace_file_header_t {
+  uint32_t magic;
+  uint32_t version;
+  uint32_t record_size;   // 每条记录的字节数
+  uint32_t time_unit_us;  // 时间戳的单位
+  uint32_t count;         // 记录条数
+} trace_file_header_t;
+
+extern uint32_t trace_mask;
+
+void trace_record(int event, uint32_t arg0, uint32_t arg1);
+int sys_trace(int cmd, int arg0, int arg1);
+
+/**
+ * @brief 跟踪点，事件未使能时只有一次判断的开销
+ *
+ * @param event
+ * @param arg0
+ * @param arg1
+ */
+static inline void trace_event(int event, uint32_t arg0, uint32_t arg1) {
+#if TRACE_ENABLE
+  if (trace_mask & (1 << event)) {
+    trace_record(event, arg0, arg1);
+  }
+#endif
+}
+
+#endif
@@ -12,50 +12,88 @@
 #ifndef TTY_H
 #define TTY_H
 
+#include "core/ktimer.h"
+#include "ipc/mutex.h"
 #include "ipc/sem.h"
-
-// tty缓存队列
-typedef struct _tty_fifo_t {
-  char *buf;        // 缓冲区起始地址
-  int size;         // 缓冲区大小
-  int read, write;  // 缓冲区读写位置
-  int count;        // 缓冲区有效数据大小，即未读数据大小
-} tty_fifo_t;
+#include "ipc/wait.h"
+#include "tools/ring.h"
 
 #define TTY_TABLE_SIZE 3    // tty设备表的大小
-#define TTY_OBUF_SIZE 512   // 输出缓存大小
-#define TTY_IBUF_SIZE 512   // 输入缓存大小
-#define TTY_OCRLF (1 << 0)  // 输出的换行符为"\r\n"
-#define TTY_INCLR (1 << 0)  // 输入的换行符是否转换
-#define TTY_IECHO (1 << 1)  // 输入的回显
+#define TTY_OBUF_SIZE 512   // 输出缓存大小，必须为2的幂
+#define TTY_IBUF_SIZE 512   // 输入缓存大小，必须为2的幂
+#define TTY_EBUF_SIZE 64    // 回显缓存大小，必须为2的幂
+#define TTY_LINE_SIZE 256   // 规范模式下行缓存的大小，即一行的最大长度
+#define TTY_OSTAGE_SIZE 64  // 写入时转换字符所用暂存区的大小
+#define TTY_VTIME_MS 100    // vtime的单位，与termios相同为0.1秒
+
+#define TTY_OCRLF (1 << 0)   // 输出的换行符为"\r\n"
+#define TTY_INCLR (1 << 0)   // 输入的回车符转换为换行符
+#define TTY_IECHO (1 << 1)   // 输入的回显
+#define TTY_ICANON (1 << 2)  // 规范模式，按行读取，由tty处理退格
 
 // 外部程序输入的TTY控制指令宏
 // 对tyy回显进行设置
 #define TTY_CMD_ECHO 0x1
-// 获取tty输入缓冲区的字符个数
+// 获取tty输入缓冲区中可读取的字符个数
 #define TTY_CMD_IN_COUNT 0x2
+// 获取tty的工作模式，arg0为tty_mode_t结构的地址
+#define TTY_CMD_GET_MODE 0x3
+// 设置tty的工作模式，arg0为tty_mode_t结构的地址
+#define TTY_CMD_SET_MODE 0x4
+
+// tty的工作模式，对应termios中的标志位与VMIN/VTIME
+typedef struct _tty_mode_t {
+  int oflags;  // 输出模式标志位
+  int iflags;  // 输入模式标志位
+
+  // 非规范模式下read的返回条件，与termios相同：
+  // vmin > 0, vtime = 0：读到vmin个字符后返回
+  // vmin > 0, vtime > 0：读到vmin个字符，或读到字符后vtime内没有新字符时返回
+  // vmin = 0, vtime > 0：读到任意字符，或vtime内没有字符时返回
+  // vmin = 0, vtime = 0：不等待，立即返回已有的字符
+  int vmin;   // 最少读取的字符数
+  int vtime;  // 超时时间，单位为TTY_VTIME_MS毫秒
+} tty_mode_t;
 
 // tty设备结构
 typedef struct _tty_t {
-  int oflags;         // 设备输出状态标志位
-  int iflags;         // 设备输入状态标志位
+  tty_mode_t mode;    // 工作模式
   int console_index;  // tty对应的终端的索引
 
-  tty_fifo_t out_fifo;  // 输出缓存队列
-  tty_fifo_t in_fifo;   // 输入缓存队列
+  // 输入输出缓存队列均为单生产者单消费者的无锁环形缓冲区
+  // 输出队列由写入任务生产、串口发送中断消费，回显队列由串口接收的下半部生产、串口发送中断消费
+  // 输入队列由串口接收的下半部生产、读取任务消费，规范模式下每次放入完整的一行
+  ring_t out_fifo;   // 输出缓存队列
+  ring_t echo_fifo;  // 回显缓存队列
+  ring_t in_fifo;    // 输入缓存队列
 
-  sem_t
-      out_sem;  // 输出缓冲区信号量，这东西应该配合硬件的中断程序用，单进程不需要
-  sem_t in_sem;  // 输入缓冲区信号量，
+  mutex_t out_mutex;  // 多个任务写入时互斥，保证输出队列只有一个生产者
+  mutex_t in_mutex;   // 多个任务读取时互斥，保证输入队列只有一个消费者
 
-  char out_buf[TTY_OBUF_SIZE];  // 输入缓存
-  char in_buf[TTY_IBUF_SIZE];   // 输出缓存
-} tty_t;
+  // 输出队列写满或输入队列为空时，任务在信号量上等待，
+  // 等待的判断与计数均在关中断下进行，发送中断与接收下半部按计数唤醒全部等待的任务
+  sem_t out_sem;    // 输出缓冲区信号量，由串口发送中断释放
+  sem_t in_sem;     // 输入缓冲区信号量，由串口接收的下半部与超时定时器释放
+  int out_waiting;  // 等待输出队列空出位置的任务数
+  int in_waiting;   // 等待输入的任务数
 
-int tty_fifo_put(tty_fifo_t *fifo, char c);
-int tty_fifo_get(tty_fifo_t *fifo, char *c);
+  wait_queue_t poll_queue;  // poll的等待队列，有输入或输出队列空出位置时唤醒
+
+  ktimer_t in_timer;  // 非规范模式下vtime的超时定时器
+  int in_timeout;     // 超时定时器已到期
+
+  int line_len;   // 行缓存中的字符数
+  int line_done;  // 行缓存中的行已完成，因输入队列空间不足尚未放入
+
+  uint8_t out_buf[TTY_OBUF_SIZE];    // 输出缓存
+  uint8_t in_buf[TTY_IBUF_SIZE];     // 输入缓存
+  uint8_t echo_buf[TTY_EBUF_SIZE];   // 回显缓存
+  uint8_t line_buf[TTY_LINE_SIZE];   // 规范模式下正在编辑的行
+} tty_t;
 
+void tty_init(void);
 void tty_in(char ch);
+void tty_out_wakeup(tty_t *tty);
 void tty_select(int tty_index);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,38 @@
+/**
+ * @file workqueue.h
+ * @author kbpoyo (kbpoyo@qq.com)
+ * @brief 工作队列，由内核线程执行可睡眠的推迟工作
+ * @version 0.1
+ * @date 2023-09-20
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+#ifndef WORKQUEUE_H
+#define WORKQUEUE_H
+
+#include "core/task.h"
+#include "ipc/sem.h"
+#include "tools/list.h"
+
+// 工作项，可在中断处理函数、下半部或任务中加入工作队列
+typedef struct _work_t {
+  list_node_t node;
+  void (*func)(struct _work_t *work);
+  int pending;  // 是否已在工作队列中等待执行
+} work_t;
+
+// 工作队列，每个队列由一个内核线程依次执行其中的工作项
+typedef struct _workqueue_t {
+  list_t list;     // 等待执行的工作项
+  sem_t sem;       // 等待执行的工作项数
+  task_t *worker;  // 执行工作项的内核线程
+} workqueue_t;
+
+void work_init(work_t *work, void (*func)(work_t *work));
+int workqueue_init(workqueue_t *wq, const char *name);
+int work_queue(workqueue_t *wq, work_t *work);
+int work_schedule(work_t *work);
+void workqueue_system_init(void);
+
+#endif
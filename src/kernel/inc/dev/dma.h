@@ -0,0 +1,104 @@
+/**
+ * @file dma.h
+ * @author kbpoyo (kbpoyo@qq.com)
+ * @brief S3C2440的4个通用DMA通道，提供通道分配、传输描述与完成通知
+ * @version 0.1
+ * @date 2023-09-22
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+#ifndef DMA_H
+#define DMA_H
+
+#include "common/types.h"
+
+#define DMA_CHANNEL_COUNT 4
+
+// DISRCC/DIDSTC寄存器的设置
+#define DMA_ADDR_FIXED (0x1 << 0)  // 传输后地址不变
+#define DMA_ADDR_APB (0x1 << 1)    // 地址位于APB总线，即外设寄存器
+
+// DCON寄存器的设置
+#define DCON_HANDSHAKE (0x1 << 31)  // 握手模式
+#define DCON_SYNC_HCLK (0x1 << 30)  // 与HCLK同步，两端都在AHB总线上时使用
+#define DCON_INT (0x1 << 29)        // 传输计数减到0时产生中断
+#define DCON_BURST (0x1 << 28)      // 每次传输4个单元
+#define DCON_WHOLE (0x1 << 27)      // 一次请求完成全部传输
+#define DCON_HWSRC(sel) ((sel) << 24)  // 硬件请求源
+#define DCON_HW_REQ (0x1 << 23)     // 由硬件请求源触发
+#define DCON_NO_RELOAD (0x1 << 22)  // 传输计数减到0后关闭通道
+#define DCON_WIDTH(w) ((w) << 20)   // 单元宽度
+#define DCON_COUNT_MAX 0xfffff      // 最大传输次数
+
+// DSTAT寄存器的设置
+#define DSTAT_BUSY (0x3 << 20)  // 通道正在传输
+
+// DMASKTRIG寄存器的设置
+#define DMASKTRIG_STOP (0x1 << 2)    // 停止传输
+#define DMASKTRIG_ON (0x1 << 1)      // 打开通道，传输结束后自动清零
+#define DMASKTRIG_SW_TRIG (0x1 << 0)  // 软件触发
+
+// DMA请求源，每个通道只能连接其中一部分外设
+typedef enum _dma_req_t {
+  DMA_REQ_MEM = 0,  // 软件触发的内存到内存传输，所有通道都支持
+  DMA_REQ_XDREQ0,
+  DMA_REQ_XDREQ1,
+  DMA_REQ_UART0,
+  DMA_REQ_UART1,
+  DMA_REQ_UART2,
+  DMA_REQ_SDI,
+  DMA_REQ_TIMER,
+  DMA_REQ_SPI0,
+  DMA_REQ_SPI1,
+  DMA_REQ_I2SSDO,
+  DMA_REQ_I2SSDI,
+
+  DMA_REQ_COUNT,
+} dma_req_t;
+
+// 传输标志
+#define DMA_SRC_FIXED (0x1 << 0)  // 源地址不递增，如外设的数据寄存器
+#define DMA_SRC_APB (0x1 << 1)    // 源地址位于APB总线
+#define DMA_DST_FIXED (0x1 << 2)  // 目的地址不递增
+#define DMA_DST_APB (0x1 << 3)    // 目的地址位于APB总线
+#define DMA_WIDTH_8 (0x0 << 4)    // 单元宽度为1字节
+#define DMA_WIDTH_16 (0x1 << 4)   // 单元宽度为2字节
+#define DMA_WIDTH_32 (0x2 << 4)   // 单元宽度为4字节
+#define DMA_WIDTH_MASK (0x3 << 4)
+#define DMA_BURST (0x1 << 6)  // 每次传输4个单元，地址需按4个单元对齐
+
+// 一次DMA传输的描述，地址均为物理地址，内核空间物理地址与虚拟地址相同
+typedef struct _dma_xfer_t {
+  uint32_t src;    // 源地址
+  uint32_t dst;    // 目的地址
+  uint32_t count;  // 传输次数，每次传输1个单元，设置DMA_BURST时为4个单元
+  uint32_t flags;  // 传输标志
+
+  // 传输完成后在中断中调用，不可睡眠，可为0
+  void (*done)(void *arg);
+  void *arg;
+} dma_xfer_t;
+
+// DMA通道
+typedef struct _dma_chan_t {
+  int index;          // 通道号
+  int hwsrc;          // 请求源在该通道上的选择值，内存传输为-1
+  const char *owner;  // 使用者名称，为0时空闲
+
+  uint32_t dst;   // 当前传输的目的地址
+  uint32_t size;  // 当前传输的字节数
+  uint32_t flags;
+  void (*done)(void *arg);
+  void *arg;
+} dma_chan_t;
+
+void dma_init(void);
+dma_chan_t *dma_request(dma_req_t req, const char *owner);
+void dma_release(dma_chan_t *chan);
+int dma_start(dma_chan_t *chan, dma_xfer_t *xfer);
+int dma_busy(dma_chan_t *chan);
+int dma_wait(dma_chan_t *chan, uint32_t timeout_us);
+void dma_stop(dma_chan_t *chan);
+
+#endif
@@ -161,11 +161,13 @@ A28 = 0                                        0x01 & (page >> 16)
       ;                           \
   }  // 等待nandflash不忙
 
-#define NF_DETECT_RB()            \
-  {                               \
-    while (!(rNFSTAT & (1 << 2))) \
-      ;                           \
-  }
+#define NF_RB_DETECTED() (rNFSTAT & (1 << 2))  // 检测到RnB信号上升沿，即操作完成
+
+// 等待flash操作完成的超时时间，等待期间睡眠，其他任务可以运行
+#define NAND_RESET_TIMEOUT_US 10000
+#define NAND_READ_TIMEOUT_US 1000
+#define NAND_PROG_TIMEOUT_US 10000
+#define NAND_ERASE_TIMEOUT_US 100000
 
 #define NF_CLEAR_RB() \
   { rNFSTAT |= (1 << 2); }  // 清除RnB信号
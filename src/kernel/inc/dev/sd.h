@@ -43,6 +43,21 @@ void sd_set_4bit_bus(void);
 #define SD_BLOCK_CNT_MAX 4095
 #define SD_BLOCK_SIZE 512
 
+// 数据传输方式
+#define SD_XFER_POL 0  // 轮询fifo，调用者在等待期间持续占用cpu
+#define SD_XFER_INT 1  // 由fifo中断搬运数据，调用者睡眠等待传输结束
+#define SD_XFER_DMA 2  // 由DMA搬运数据，调用者睡眠等待传输结束
+
+#define SD_FIFO_SIZE 64  // 数据fifo的大小
+
+// 等待sd卡状态的超时时间与重试间隔，等待期间睡眠，其他任务可以运行
+#define SD_CMD_TIMEOUT_US 10000      // 命令发送与响应
+#define SD_DATA_TIMEOUT_US 1000000   // 数据传输结束
+#define SD_BUSY_TIMEOUT_US 1000000   // 写入后的忙信号结束
+#define SD_RETRY_US 100              // 命令失败后重试前的等待时间
+#define SD_POWER_UP_MS 10            // 初始化前的上电等待时间
+#define SD_OCR_RETRY_MS 20           // 等待sd卡上电完成的检测间隔
+
 // 定义SDI命令状态寄存器
 #define SD_CMDSTA_CmdOn (1 << 8)     // 命令传输处理中
 #define SD_CMDSTA_RspFin (1 << 9)    // 响应结束
@@ -63,6 +78,7 @@ void sd_set_4bit_bus(void);
 #define SD_DATCON_DatMode_Recv (2 << 12)  // 数据传输模式：接收
 #define SD_DATCON_DatMode_Busy (1 << 12)  // 数据传输模式：只检查忙信号
 #define SD_DATCON_DatTranStart (1 << 14)  // 数据传输开始
+#define SD_DATCON_DMAEn (1 << 15)         // 使能DMA
 #define SD_DATCON_WideBus (1 << 16)       // 宽总线
 #define SD_DATCON_BlockMode (1 << 17)     // 块模式
 #define SD_DATCON_BACMD (1 << 18)         // busy接收在命令发送后开始
@@ -72,18 +88,18 @@ void sd_set_4bit_bus(void);
 
 // 重置数据控制寄存器
 #define SD_DATCON_RESET() (rSDIDCON = rSDIDCON & (~(7 << 12)))
-// 进行读操作
-#define SD_DATCON_DO_READ(block_cnt)                                          \
+// 进行读操作，flags为附加的控制位，如SD_DATCON_DMAEn
+#define SD_DATCON_DO_READ(block_cnt, flags)                                   \
   (rSDIDCON =                                                                 \
        (SD_DATCON_DataSize_Word | SD_DATCON_RACMD | SD_DATCON_BlockMode |     \
         SD_DATCON_WideBus | SD_DATCON_DatTranStart | SD_DATCON_DatMode_Recv | \
-        (block_cnt << 0)))
+        (flags) | (block_cnt << 0)))
 // 进行写操作
-#define SD_DATCON_DO_WRITE(block_cnt)                                         \
+#define SD_DATCON_DO_WRITE(block_cnt, flags)                                  \
   (rSDIDCON =                                                                 \
        (SD_DATCON_DataSize_Word | SD_DATCON_TARSP | SD_DATCON_BlockMode |     \
         SD_DATCON_WideBus | SD_DATCON_DatTranStart | SD_DATCON_DatMode_Sent | \
-        (block_cnt << 0)))
+        (flags) | (block_cnt << 0)))
 // 进行检测忙操作
 #define SD_DATCON_DO_DetectBusy(block_cnt)                                 \
   (rSDIDCON = (SD_DATCON_BACMD | SD_DATCON_BlockMode | SD_DATCON_WideBus | \
@@ -122,6 +138,7 @@ void sd_set_4bit_bus(void);
 #define SD_DATSTA_CLR_CrcSta() (rSDIDSTA = SD_DATSTA_CrcSta)
 
 // 定义fifo状态寄存器位
+#define SD_FIFOSTA_Count 0x7f       // fifo中的数据字节数
 #define SD_FIFOSTA_RFLast (1 << 9)  // fifo中的数据是最后一个数据
 #define SD_FIFOSTA_RxOK (1 << 12)   // fifo中有数据可接收
 #define SD_FIFOSTA_TxOK (1 << 13)   // fifo中有空间可发送
@@ -133,6 +150,17 @@ void sd_set_4bit_bus(void);
 #define SD_FIFO_CAN_WRITE() (rSDIFSTA & SD_FIFOSTA_TxOK)
 #define SD_FIFO_READ_LAST() (rSDIFSTA & SD_FIFOSTA_RFLast)
 #define SD_FIFO_CLEAR_LAST() (rSDIFSTA = SD_FIFOSTA_RFLast)
+#define SD_FIFO_COUNT() (rSDIFSTA & SD_FIFOSTA_Count)
+
+// 定义中断屏蔽寄存器位，置1时使能对应的中断
+#define SD_IMSK_RFHalf (1 << 0)   // 接收fifo半满
+#define SD_IMSK_RFLast (1 << 2)   // 接收fifo中有最后的数据
+#define SD_IMSK_TFHalf (1 << 4)   // 发送fifo半空
+#define SD_IMSK_DatFin (1 << 7)   // 数据传输结束
+#define SD_IMSK_DatTout (1 << 8)  // 数据传输超时
+#define SD_IMSK_DatCrc (1 << 9)   // 接收数据crc失败
+#define SD_IMSK_CrcSta (1 << 10)  // crc状态失败
+#define SD_IMSK_DatErr (SD_IMSK_DatTout | SD_IMSK_DatCrc | SD_IMSK_CrcSta)
 
 int sd_open(disk_t *disk);
 void sd_close(disk_t *disk);
@@ -1,21 +1,45 @@
 #ifndef TIMER_H
 #define TIMER_H
 
+#include "common/os_config.h"
 #include "common/register_addr.h"
+#include "common/types.h"
 
 #define rTCFG0_INIT ((250 - 1) << 8)    //设置定时器4的预分频为250
-#define rTCGG1_INIT (1 << 16)   //设置定时器4的分频通道为1/4
+#define rTCGG1_INIT ((1 << 16) | (1 << 8))   //设置定时器4与定时器2的分频通道为1/4
 
 //定时器4的输入频率为PCLK/(250*4) = 50Mhz/1000 = 5e4 hz
 //即定时器的分辨率为2e-5s = 20us
 //定时器计数器为16位，即最大值为0xffff, 所以定时器支持最大定时时间为1,310,700us = 1.3107s
 #define TIMER_RESOLVING_POWER   20 //us
 
+//每个时间片的计数值，即定时器4的重载值
+#define TIMER_TICK_COUNT ((TASK_TIME_SLICE_MS * 1000) / TIMER_RESOLVING_POWER)
+
 
 #define HAND_REFLASH_4 (1 << 21)
 #define AUTORELOAD_AND_START_4    ((1 << 22) | (1 << 20))
 
+//定时器3与定时器4共用预分频，分频通道为1/2，输入频率为1e5 hz，即分辨率为10us
+#define TIMER3_RESOLVING_POWER  10 //us
+#define TIMER3_CON_MASK (0xf << 16)
+#define HAND_REFLASH_3 (1 << 17)
+#define AUTORELOAD_AND_START_3    ((1 << 19) | (1 << 16))
+
+//定时器2以单次模式为内核定时器产生中断，分辨率与定时器4相同
+#define TIMER2_CON_MASK (0xf << 12)
+#define HAND_REFLASH_2 (1 << 13)
+#define START_2 (1 << 12)
+#define TIMER2_COUNT_MAX 0xffff
+
 void timer_init();
+uint32_t timer_get_count(void);
+void timer_get_tick(uint32_t *tick_count, uint32_t *elapsed_us);
+void timer3_start(uint32_t period_us, void (*handler)(void));
+void timer3_stop(void);
+void timer2_oneshot(uint32_t delay_us, void (*handler)(void));
+void timer2_stop(void);
+void timer_delay_us(uint32_t us);
 
 
 #endif
\ No newline at end of file
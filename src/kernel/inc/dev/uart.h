@@ -12,6 +12,31 @@
 
 #define BAUDRATE 115200  // 波特率
 
+// 串口接收缓冲区大小，中断处理函数存入，下半部取出交给tty设备，必须为2的幂
+// 一次中断最多读出整个接收FIFO，需大于FIFO深度
+#define UART_RX_BUF_SIZE 128
+
+// FIFO控制寄存器的设置，使能并复位收发FIFO，接收触发深度16字节，发送触发深度16字节
+// 接收FIFO达到触发深度或接收超时时产生接收中断，发送FIFO不多于触发深度时产生发送中断
+#define UART_FIFO_SIZE 64
+#define UFCON_FIFO_ENABLE (0x1 << 0)
+#define UFCON_RX_RESET (0x1 << 1)
+#define UFCON_TX_RESET (0x1 << 2)
+#define UFCON_RX_TRIG_16 (0x2 << 4)
+#define UFCON_TX_TRIG_16 (0x1 << 6)
+#define UFCON_INIT                                   \
+  (UFCON_FIFO_ENABLE | UFCON_RX_RESET | UFCON_TX_RESET | \
+   UFCON_RX_TRIG_16 | UFCON_TX_TRIG_16)
+
+// 控制寄存器的设置，收发中断均为电平触发，使能接收超时中断与接收错误中断
+#define UCON_INIT 0x3c5
+
+// FIFO状态寄存器的设置
+#define FIFO_RX_COUNT_MASK 0x3f  // 接收FIFO中的字节数
+#define FIFO_RX_FULL (0x1 << 6)  // 接收FIFO已满
+#define FIFO_TX_COUNT(state) (((state) >> 8) & 0x3f)  // 发送FIFO中的字节数
+#define FIFO_TX_FULL (0x1 << 14)  // 发送FIFO已满
+
 // 接收发送状态寄存器的设置
 #define STATE_REC_BUFF_ISREADY (0x1 << 0)  // 接收缓存是否准备好
 #define STATE_TRA_BUFF_ISEMPTY (0x1 << 1)  // 放送缓存是否为空
@@ -27,6 +52,9 @@ typedef struct _uart_t {
   volatile unsigned *in_addr;     // 串口输入地址
   volatile unsigned *out_addr;    // 串口输出地址
   volatile unsigned *state_addr;  // 串口状态地址
+  volatile unsigned *fifo_addr;   // 串口FIFO状态地址
+
+  tty_t *tty;  // 由发送中断排空输出队列的tty设备，为0时只发送内核日志
 
   mutex_t mutex;  // 保护该串口的互斥锁
 
@@ -36,10 +64,13 @@ void uart_init(int uart_index);
 void uart_send_byte(uart_t *uart, uint8_t data);
 void uart_send_str(uart_t *uart, const char *str);
 void uart_printf(uart_t *uart, char *fmt, ...);
+void uart_tx_start(void);
+void uart_tx_flush(void);
 
 void uart_select(int uart_index);
 
 int uart_write(tty_t *tty);
+void uart_echo(tty_t *tty);
 int uart_control(int cmd, int arg0, int arg1);
 
 #endif
\ No newline at end of file
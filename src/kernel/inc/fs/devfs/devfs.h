@@ -14,12 +14,19 @@
 
 #include "fs/fs.h"
 
-//定义设备文件系统所管理的设备类型
+#define DEVFS_NODE_MAX 32    //设备文件的最大数量
+#define DEVFS_NAME_SIZE 16   //设备文件名的最大长度
+#define DEVFS_MINOR_ANY -1   //设备号由路径给出，如tty0，路径中没有设备号时为0
+
+//定义设备文件系统所管理的设备文件，由驱动初始化时注册
 typedef struct _devfs_type_t {
-    const char *name;
+    char name[DEVFS_NAME_SIZE];
     int dev_type;
+    int minor;      //设备号，为DEVFS_MINOR_ANY时name只是路径的前缀
     int file_type;
 }devfs_type_t;
 
+int devfs_register(const char *name, int dev_type, int minor, int file_type);
+
 
 #endif
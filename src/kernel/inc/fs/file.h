@@ -13,7 +13,10 @@
 
 #include "common/types.h"
 
+// 系统文件表的容量上限，文件结构按块分配
 #define FILE_TABLE_SIZE 2048
+// 每次为系统文件表分配的文件结构数量
+#define FILE_CHUNK_SIZE 64
 #define FILE_NAME_SIZE 32
 
 // 文件类型的枚举
@@ -22,6 +25,8 @@ typedef enum _file_type_t {
   FILE_TTY,
   FILE_DIR,
   FILE_NORMAL,
+  FILE_CHAR,  // 非终端的字符设备
+  FILE_BLOCK,  // 块设备，按整块读写
 
 } file_type_t;
 
@@ -35,7 +40,8 @@ typedef struct _file_t {
   struct _fs_t *fs;                // 文件所属文件系统
 
   // 供设备文件系统使用
-  int dev_id;  // 文件对应的设备id
+  int dev_id;    // 文件对应的设备id
+  int blk_size;  // 块设备的块大小，其余设备为0
 
   // 供fat文件系统使用
   int pos;        // 记录当前文件读取的位置
@@ -4,7 +4,9 @@
 #include "applib/lib_syscall.h"
 #include "fatfs/fatfs.h"
 #include "fs/file.h"
+#include "fs/poll.h"
 #include "ipc/mutex.h"
+#include "ipc/wait.h"
 #include "tools/list.h"
 
 // 类型声明，用以链接newlib库
@@ -23,6 +25,10 @@ typedef struct _fs_op_t {
   int (*seek)(file_t *file, uint32_t offset, int dir);
   int (*stat)(file_t *file, struct stat *st);
   int (*ioctl)(file_t *file, int cmd, int arg0, int arg1);
+  // 将文件offset处的一页内容读入page中，供页缓存使用
+  int (*read_page)(file_t *file, uint32_t offset, char *page);
+  // 获取文件当前的可读写状态，entry不为0时将其加入等待队列，为0时文件总是可读写
+  int (*poll)(file_t *file, wait_entry_t *entry);
 
   int (*unlink)(struct _fs_t *fs, const char *path);
   int (*opendir)(struct _fs_t *fs, const char *name, DIR *dir);
@@ -72,6 +78,8 @@ int sys_isatty(int file);
 int sys_fstat(int file, struct stat *st);
 int sys_dup(int file);
 int sys_ioctl(int file, int cmd, int arg0, int arg1);
+int sys_fcntl(int file, int cmd, int arg);
+int sys_poll(struct pollfd *fds, int nfds, int timeout);
 
 int sys_unlink(const char *path);
 int sys_opendir(const char *path, DIR *dir);
@@ -0,0 +1,41 @@
+/**
+ * @file page_cache.h
+ * @author kbpoyo (kbpoyo@qq.com)
+ * @brief 文件页缓存，以(文件, 页偏移)为索引缓存文件内容，供文件映射共享使用
+ * @version 0.1
+ * @date 2023-09-02
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+#ifndef PAGE_CACHE_H
+#define PAGE_CACHE_H
+
+#include "common/types.h"
+#include "fs/file.h"
+#include "tools/list.h"
+
+// 页缓存最多可缓存的页数
+#define PAGE_CACHE_PAGE_COUNT 512
+// 页缓存散列桶的数量，取2的n次方
+#define PAGE_CACHE_BUCKET_COUNT 64
+
+struct _fs_t;
+
+// 页缓存项，记录文件的一页内容被缓存在哪个物理页中
+typedef struct _page_cache_entry_t {
+  struct _fs_t *fs;  // 文件所属的文件系统
+  int sblk;          // 文件的起始簇号，在同一文件系统中唯一标识一个文件
+  uint32_t index;    // 该页在文件中的页索引，即页偏移 / MEM_PAGE_SIZE
+  uint32_t page;     // 缓存该页内容的物理页地址
+
+  list_node_t hash_node;  // 插入散列桶或空闲链表的节点
+  list_node_t lru_node;   // 插入lru链表的节点，链表头为最久未使用的页
+} page_cache_entry_t;
+
+void page_cache_init(void);
+uint32_t page_cache_get(file_t *file, uint32_t offset);
+void page_cache_invalidate(struct _fs_t *fs, int sblk);
+int page_cache_page_count(void);
+
+#endif
@@ -0,0 +1,31 @@
+/**
+ * @file poll.h
+ * @author kbpoyo (kbpoyo@qq.com)
+ * @brief poll系统调用的事件定义，内核与应用程序共用
+ * @version 0.1
+ * @date 2023-09-23
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+#ifndef POLL_H
+#define POLL_H
+
+// 一次poll最多等待的文件数，等待项分配在内核栈上
+#define POLL_FD_MAX 16
+
+// 文件的事件
+#define POLLIN (1 << 0)    // 有数据可读，读取不会阻塞
+#define POLLOUT (1 << 2)   // 有空间可写，写入不会阻塞
+#define POLLERR (1 << 3)   // 文件出错，总是返回，无需在events中设置
+#define POLLHUP (1 << 4)   // 对端已关闭，总是返回，无需在events中设置
+#define POLLNVAL (1 << 5)  // 文件描述符无效，总是返回，无需在events中设置
+
+// 一个需要等待的文件
+struct pollfd {
+  int fd;         // 文件描述符，为负数时忽略该项
+  short events;   // 需要等待的事件
+  short revents;  // 已发生的事件，由内核填写
+};
+
+#endif
@@ -0,0 +1,44 @@
+/**
+ * @file lock_stat.h
+ * @author kbpoyo (kbpoyo@qq.com)
+ * @brief 互斥锁与信号量的竞争统计，锁按名称注册，同名的锁合并为一项统计
+ * @version 0.1
+ * @date 2023-09-19
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+#ifndef LOCK_STAT_H
+#define LOCK_STAT_H
+
+#include "common/os_config.h"
+#include "common/types.h"
+
+#define LOCK_STAT_NAME_SIZE 16
+
+// 控制指令
+#define LOCK_STAT_CMD_READ 0   // 将最多arg1项统计读到arg0中，返回读取的项数
+#define LOCK_STAT_CMD_CLEAR 1  // 清空所有统计值
+
+// 统计时间的单位，与定时器的分辨率TIMER_RESOLVING_POWER一致
+#define LOCK_STAT_TIME_UNIT_US 20
+
+// 一类锁的统计信息
+typedef struct _lock_stat_t {
+  char name[LOCK_STAT_NAME_SIZE];
+  uint32_t acquired;        // 获取次数
+  uint32_t contended;       // 需要等待的获取次数
+  uint32_t wait_total;      // 总等待时间
+  uint32_t wait_max;        // 最长等待时间
+  uint32_t wait_max_owner;  // 最长等待时锁拥有者的pid，信号量为0
+  uint32_t hold_total;      // 总持有时间，信号量不统计
+  uint32_t hold_max;        // 最长持有时间
+} lock_stat_t;
+
+lock_stat_t *lock_stat_register(const char *name);
+uint32_t lock_stat_now(void);
+void lock_stat_wait(lock_stat_t *stat, uint32_t start, uint32_t owner);
+void lock_stat_hold(lock_stat_t *stat, uint32_t start);
+int sys_lock_stat(int cmd, int arg0, int arg1);
+
+#endif
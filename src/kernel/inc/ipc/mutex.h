@@ -14,15 +14,21 @@
 
 #include "tools/list.h"
 #include "core/task.h"
+#include "ipc/lock_stat.h"
 
 typedef struct  _mutex_t{
     task_t *owner;      //当前锁的拥有者
     int locked_count;   //当前锁被上锁了几次
     list_t wait_list;   //等待该锁的任务队列
+#if LOCK_STAT_ENABLE
+    lock_stat_t *stat;  //竞争统计项，0：未命名，不统计
+    uint32_t lock_time; //拥有者获取到锁的时间
+#endif
 }mutex_t;
 
 
 void mutex_init(mutex_t *mutex);
+void mutex_set_name(mutex_t *mutex, const char *name);
 void mutex_lock(mutex_t *mutex);
 void mutex_unlock(mutex_t *mutex);
 
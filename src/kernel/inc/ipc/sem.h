@@ -13,13 +13,18 @@
 #define SEM_H
 
 #include "tools/list.h"
+#include "ipc/lock_stat.h"
 
 typedef struct  _sem_t {
     int count;
     list_t wait_list;
+#if LOCK_STAT_ENABLE
+    lock_stat_t *stat;  //竞争统计项，0：未命名，不统计
+#endif
 }sem_t;
 
 void sem_init(sem_t *sem, int init_count);
+void sem_set_name(sem_t *sem, const char *name);
 void sem_wait(sem_t *sem);
 void sem_notify(sem_t *sem);
 int sem_count(sem_t *sem);
@@ -0,0 +1,54 @@
+/**
+ * @file shm.h
+ * @author kbpoyo (kbpoyo@qq.com)
+ * @brief 进程间共享内存段，多个进程的页表映射同一组物理页
+ * @version 0.1
+ * @date 2023-09-05
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+#ifndef SHM_H
+#define SHM_H
+
+#include "common/types.h"
+
+// 静态分配共享内存段，定义共享内存段数量
+#define SHM_COUNT 32
+// 单个共享内存段的最大大小
+#define SHM_SIZE_MAX (1024 * 1024)
+
+// 私有键值，总是创建新的共享内存段
+#define IPC_PRIVATE 0
+
+// shmget的标志位
+#define IPC_CREAT 0x200  // 键值不存在时创建
+#define IPC_EXCL 0x400   // 与IPC_CREAT同用，键值已存在时返回失败
+
+// shmctl的命令
+#define IPC_RMID 0  // 删除共享内存段，最后一个进程分离后释放物理页
+
+// shmat的标志位
+#define SHM_RDONLY 0x1000  // 以只读方式挂接
+
+// 共享内存段结构
+typedef struct _shm_t {
+  int key;          // 键值，进程通过相同的键值获取同一共享内存段
+  uint32_t page;    // 物理页的起始地址，物理页连续分配
+  int page_count;   // 物理页数量
+  int ref;          // 挂接该段的映射区数量
+  int removed;      // 已被删除，ref为0时释放物理页
+} shm_t;
+
+void shm_init(void);
+void shm_get(shm_t *shm);
+void shm_put(shm_t *shm);
+int shm_map(shm_t *shm, uint32_t page_dir, uint32_t vaddr, uint32_t offset,
+            int page_count, int prot);
+
+int sys_shmget(int key, uint32_t size, int flags);
+int sys_shmat(int shmid, void *addr, int flags);
+int sys_shmdt(void *addr);
+int sys_shmctl(int shmid, int cmd);
+
+#endif
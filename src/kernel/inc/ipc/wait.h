@@ -0,0 +1,35 @@
+/**
+ * @file wait.h
+ * @author kbpoyo (kbpoyo@qq.com)
+ * @brief 等待队列，对象状态变化时唤醒挂在其上的所有等待者，
+ *        一个任务可同时挂在多个对象的等待队列上，用于poll同时等待多个文件
+ * @version 0.1
+ * @date 2023-09-23
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+#ifndef WAIT_H
+#define WAIT_H
+
+#include "ipc/sem.h"
+#include "tools/list.h"
+
+// 等待队列，由驱动等对象持有，状态变化时调用wait_queue_wakeup
+typedef struct _wait_queue_t {
+  list_t list;
+} wait_queue_t;
+
+// 等待项，由等待者持有，唤醒时释放一次sem，等待者醒来后自行检查对象状态
+typedef struct _wait_entry_t {
+  list_node_t node;
+  wait_queue_t *queue;  // 所在的等待队列，为0时未加入
+  sem_t *sem;
+} wait_entry_t;
+
+void wait_queue_init(wait_queue_t *queue);
+void wait_queue_add(wait_queue_t *queue, wait_entry_t *entry);
+void wait_queue_remove(wait_entry_t *entry);
+void wait_queue_wakeup(wait_queue_t *queue);
+
+#endif
@@ -2,8 +2,13 @@
 #include "common/cpu_instr.h"
 #include "core/dev.h"
 #include "core/irq.h"
+#include "core/ktimer.h"
 #include "core/memory.h"
+#include "core/swap.h"
 #include "core/task.h"
+#include "core/tty.h"
+#include "core/workqueue.h"
+#include "dev/dma.h"
 #include "dev/gpio.h"
 #include "dev/nandflash.h"
 #include "dev/timer.h"
@@ -87,6 +92,12 @@ void move_to_first_task(void) {
 int kernel_init() {
   gpio_init();
 
+  // 注册内置字符设备，磁盘设备在fs_init中检测后注册
+  // 日志输出需要打开tty设备完成串口初始化，需在log_init之前注册
+  tty_init();
+  kmsg_init();
+  mem_dev_init();
+
   log_init();
 
   irq_init();
@@ -95,13 +106,22 @@ int kernel_init() {
 
   memory_init();
 
+  // 磁盘驱动初始化时需要通过定时器计时，先启动定时器
+  timer_init();
+
+  ktimer_system_init();
+
+  dma_init();
+
   task_manager_init();
 
   fs_init();
 
+  swap_init();
+
   task_first_init();
 
-  timer_init();
+  workqueue_system_init();
 
   cpu_irq_start();
 
@@ -0,0 +1,142 @@
+/**
+ * @file lock_stat.c
+ * @author kbpoyo (kbpoyo@qq.com)
+ * @brief 互斥锁与信号量的竞争统计
+ * @version 0.1
+ * @date 2023-09-19
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#include "ipc/lock_stat.h"
+
+#include "core/mmap.h"
+#include "core/task.h"
+#include "dev/timer.h"
+#include "tools/klib.h"
+#include "tools/log.h"
+
+// 锁在内存初始化时就会注册，统计表放在数据段中
+static lock_stat_t lock_stat_table[LOCK_STAT_COUNT]
+    __attribute__((section(".data"), aligned(4))) = {{{0}}};
+static int lock_stat_count __attribute__((section(".data"))) = 0;
+
+/**
+ * @brief 按名称注册一类锁，名称已存在时返回已有的统计项
+ *
+ * @param name
+ * @return lock_stat_t* 统计表已满时返回0，该锁不做统计
+ */
+lock_stat_t *lock_stat_register(const char *name) {
+  lock_stat_t *stat = (lock_stat_t *)0;
+  cpu_state_t state = task_enter_protection();
+
+  for (int i = 0; i < lock_stat_count; ++i) {
+    if (kernel_strncmp(lock_stat_table[i].name, name, LOCK_STAT_NAME_SIZE) ==
+        0) {
+      stat = lock_stat_table + i;
+      goto register_end;
+    }
+  }
+
+  if (lock_stat_count >= LOCK_STAT_COUNT) {
+    log_printf("lock stat: table full, %s not tracked\n", name);
+    goto register_end;
+  }
+
+  stat = lock_stat_table + lock_stat_count++;
+  kernel_strncpy(stat->name, name, LOCK_STAT_NAME_SIZE);
+
+register_end:
+  task_leave_protection(state);
+  return stat;
+}
+
+/**
+ * @brief 获取当前时间，单位为LOCK_STAT_TIME_UNIT_US微秒
+ *
+ * @return uint32_t
+ */
+uint32_t lock_stat_now(void) { return timer_get_count(); }
+
+/**
+ * @brief 记录一次需要等待的获取，需在关中断时调用
+ *
+ * @param stat
+ * @param start 开始等待的时间
+ * @param owner 开始等待时锁拥有者的pid
+ */
+void lock_stat_wait(lock_stat_t *stat, uint32_t start, uint32_t owner) {
+  uint32_t wait = lock_stat_now() - start;
+
+  stat->contended++;
+  stat->wait_total += wait;
+  if (wait >= stat->wait_max) {
+    stat->wait_max = wait;
+    stat->wait_max_owner = owner;
+  }
+}
+
+/**
+ * @brief 记录一次持有，需在关中断时调用
+ *
+ * @param stat
+ * @param start 获取到锁的时间
+ */
+void lock_stat_hold(lock_stat_t *stat, uint32_t start) {
+  uint32_t hold = lock_stat_now() - start;
+
+  stat->hold_total += hold;
+  if (hold > stat->hold_max) {
+    stat->hold_max = hold;
+  }
+}
+
+/**
+ * @brief 读取或清空锁竞争统计
+ *
+ * @param cmd LOCK_STAT_CMD_READ，LOCK_STAT_CMD_CLEAR
+ * @param arg0
+ * @param arg1
+ * @return int -1：失败
+ */
+int sys_lock_stat(int cmd, int arg0, int arg1) {
+  switch (cmd) {
+    case LOCK_STAT_CMD_READ: {
+      int count = lock_stat_count < arg1 ? lock_stat_count : arg1;
+      if (!arg0 || count < 0) {
+        return -1;
+      }
+
+      // 用户缓冲区可能位于文件映射区，先使其成为可写的私有页
+      if (mmap_prepare_write((uint32_t)arg0, count * sizeof(lock_stat_t)) < 0) {
+        return -1;
+      }
+
+      // 逐项在关中断时拷贝出一致的统计值，再写入用户缓冲区，写入时可能产生缺页
+      lock_stat_t *buf = (lock_stat_t *)arg0;
+      for (int i = 0; i < count; ++i) {
+        cpu_state_t state = task_enter_protection();
+        lock_stat_t stat;
+        kernel_memcpy(&stat, lock_stat_table + i, sizeof(lock_stat_t));
+        task_leave_protection(state);
+        kernel_memcpy(buf + i, &stat, sizeof(lock_stat_t));
+      }
+      return count;
+    }
+    case LOCK_STAT_CMD_CLEAR: {
+      cpu_state_t state = task_enter_protection();
+      for (int i = 0; i < lock_stat_count; ++i) {
+        lock_stat_t *stat = lock_stat_table + i;
+        kernel_memset((uint8_t *)stat + LOCK_STAT_NAME_SIZE, 0,
+                      sizeof(lock_stat_t) - LOCK_STAT_NAME_SIZE);
+      }
+      task_leave_protection(state);
+      return 0;
+    }
+    default:
+      log_printf("lock stat: unknown cmd %d\n", cmd);
+      return -1;
+  }
+}
@@ -12,6 +12,21 @@ void mutex_init(mutex_t *mutex) {
   mutex->locked_count = 0;
   mutex->owner = (task_t *)0;
   list_init(&mutex->wait_list);
+#if LOCK_STAT_ENABLE
+  mutex->stat = (lock_stat_t *)0;
+#endif
+}
+
+/**
+ * @brief  为互斥锁命名，命名后的锁才会统计竞争情况
+ *
+ * @param mutex
+ * @param name 同名的锁合并统计
+ */
+void mutex_set_name(mutex_t *mutex, const char *name) {
+#if LOCK_STAT_ENABLE
+  mutex->stat = lock_stat_register(name);
+#endif
 }
 
 /**
@@ -34,14 +49,32 @@ void mutex_lock(mutex_t *mutex) {
     //3.还未被加锁，则加锁并记录拥有该锁的任务
     mutex->locked_count++;
     mutex->owner = curr;
+#if LOCK_STAT_ENABLE
+    if (mutex->stat) {
+      mutex->stat->acquired++;
+      mutex->lock_time = lock_stat_now();
+    }
+#endif
   } else if (mutex->owner == curr) {
     //4.已被加锁，但当前加锁请求的任务为当前锁的拥有者，直接再加锁即可
     mutex->locked_count++;
   } else {  
     //5.已被加锁，且当前任务不是锁的拥有者，则当前任务进入锁的等待队列，被阻塞住
+#if LOCK_STAT_ENABLE
+    uint32_t wait_start = mutex->stat ? lock_stat_now() : 0;
+    uint32_t owner_pid = mutex->owner->pid;
+#endif
     task_set_unready(curr);
     list_insert_last(&mutex->wait_list, &curr->wait_node);
     task_switch();
+
+    //6.被唤醒时锁已由解锁的任务转交给当前任务
+#if LOCK_STAT_ENABLE
+    if (mutex->stat) {
+      mutex->stat->acquired++;
+      lock_stat_wait(mutex->stat, wait_start, owner_pid);
+    }
+#endif
   }
 
   task_leave_protection(state);  // TODO:解锁
@@ -67,6 +100,11 @@ void mutex_unlock(mutex_t *mutex) {
     if (--mutex->locked_count == 0) {
       //3.锁已被完全解锁,将锁的所有者置空
       mutex->owner = (task_t*)0;
+#if LOCK_STAT_ENABLE
+      if (mutex->stat) {
+        lock_stat_hold(mutex->stat, mutex->lock_time);
+      }
+#endif
       //4.判断当前等待队列是否为空
       if (!list_is_empty(&mutex->wait_list)) { 
         //5.当前等待队列不为空,对锁进行加锁，并交给等待队列的第一个任务
@@ -74,6 +112,9 @@ void mutex_unlock(mutex_t *mutex) {
         task_t *task_wait = list_node_parent(node, task_t, wait_node);
         mutex->locked_count = 1;
         mutex->owner = task_wait;
+#if LOCK_STAT_ENABLE
+        mutex->lock_time = lock_stat_now();
+#endif
         //6.让该任务进入就绪队列
         task_set_ready(task_wait);
       }
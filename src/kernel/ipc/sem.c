@@ -4,6 +4,7 @@
 
 #include "core/irq.h"
 #include "core/task.h"
+#include "core/trace.h"
 
 /**
  * @brief  初始化信号量对象
@@ -15,6 +16,21 @@ void sem_init(sem_t *sem, int init_count) {
   ASSERT(sem != (sem_t *)0);
   sem->count = init_count;
   list_init(&sem->wait_list);
+#if LOCK_STAT_ENABLE
+  sem->stat = (lock_stat_t *)0;
+#endif
+}
+
+/**
+ * @brief  为信号量命名，命名后的信号量才会统计等待情况
+ *
+ * @param sem
+ * @param name 同名的信号量合并统计
+ */
+void sem_set_name(sem_t *sem, const char *name) {
+#if LOCK_STAT_ENABLE
+  sem->stat = lock_stat_register(name);
+#endif
 }
 
 /**
@@ -35,15 +51,28 @@ void sem_wait(sem_t *sem) {
   }
 
   // 1.判断信号量是否还有剩余
+#if LOCK_STAT_ENABLE
+  if (sem->stat) {
+    sem->stat->acquired++;
+  }
+#endif
   if (sem->count > 0) {  // 有剩余，直接使用，任务获取信号量继续执行
     --sem->count;
   } else {  // 没有剩余，任务进入延时队列等待信号量
+#if LOCK_STAT_ENABLE
+    uint32_t wait_start = sem->stat ? lock_stat_now() : 0;
+#endif
     // 2.将当前任务从就绪队列中取下
     task_set_unready(curr);
     // 3.将当前任务加入到信号量等待队列
     list_insert_last(&sem->wait_list, &curr->wait_node);
     // 4.切换任务
     task_switch();
+#if LOCK_STAT_ENABLE
+    if (sem->stat) {
+      lock_stat_wait(sem->stat, wait_start, 0);
+    }
+#endif
   }
 
   task_leave_protection(state);  // TODO:解锁
@@ -68,6 +97,7 @@ void sem_notify(sem_t *sem) {
   if (!list_is_empty(&sem->wait_list)) {
     list_node_t *node = list_remove_first(&sem->wait_list);
     task_t *task = list_node_parent(node, task_t, wait_node);
+    trace_event(TRACE_SCHED_WAKEUP, task->pid, (uint32_t)sem);
     task_set_ready(task);
     task_switch();
   } else {
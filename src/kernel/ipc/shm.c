@@ -0,0 +1,270 @@
+/**
+ * @file shm.c
+ * @author kbpoyo (kbpoyo@qq.com)
+ * @brief 进程间共享内存段，多个进程的页表映射同一组物理页，
+ *        物理页的生命周期由页引用计数管理
+ * @version 0.1
+ * @date 2023-09-05
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#include "ipc/shm.h"
+
+#include "core/memory.h"
+#include "core/mmap.h"
+#include "core/task.h"
+#include "ipc/mutex.h"
+#include "tools/klib.h"
+#include "tools/log.h"
+
+// 静态分配的共享内存段表
+static shm_t shm_table[SHM_COUNT];
+// 保护共享内存段表的互斥锁
+static mutex_t shm_mutex;
+
+/**
+ * @brief 释放共享内存段持有的物理页，映射这些页的进程各自持有页引用
+ *        因此物理页在最后一个映射解除后才真正被回收
+ *
+ * @param shm
+ */
+static void shm_destroy(shm_t *shm) {
+  memory_free_page(shm->page, shm->page_count);
+  kernel_memset(shm, 0, sizeof(shm_t));
+}
+
+/**
+ * @brief 获取共享内存段标识对应的共享内存段
+ *
+ * @param shmid
+ * @return shm_t*
+ */
+static shm_t *shm_from_id(int shmid) {
+  if (shmid < 0 || shmid >= SHM_COUNT) {
+    return (shm_t *)0;
+  }
+
+  shm_t *shm = shm_table + shmid;
+  if (shm->page == 0 || shm->removed) {
+    return (shm_t *)0;
+  }
+
+  return shm;
+}
+
+/**
+ * @brief 初始化共享内存段表
+ *
+ */
+void shm_init(void) {
+  kernel_memset(shm_table, 0, sizeof(shm_table));
+  mutex_init(&shm_mutex);
+}
+
+/**
+ * @brief 增加共享内存段的引用
+ *
+ * @param shm
+ */
+void shm_get(shm_t *shm) {
+  mutex_lock(&shm_mutex);
+  shm->ref++;
+  mutex_unlock(&shm_mutex);
+}
+
+/**
+ * @brief 减少共享内存段的引用，段已被删除且无人引用时释放
+ *
+ * @param shm
+ */
+void shm_put(shm_t *shm) {
+  mutex_lock(&shm_mutex);
+
+  if (--shm->ref == 0 && shm->removed) {
+    shm_destroy(shm);
+  }
+
+  mutex_unlock(&shm_mutex);
+}
+
+/**
+ * @brief 将共享内存段从offset开始的page_count页映射到页目录表的vaddr处
+ *        每个映射都会增加物理页的引用计数
+ *
+ * @param shm
+ * @param page_dir
+ * @param vaddr
+ * @param offset 段内偏移量，按页对齐
+ * @param page_count
+ * @param prot 映射区的访问权限
+ * @return int
+ */
+int shm_map(shm_t *shm, uint32_t page_dir, uint32_t vaddr, uint32_t offset,
+            int page_count, int prot) {
+  uint32_t privilege =
+      PTE_FLAG | ((prot & PROT_WRITE) ? PTE_AP_USR : PTE_AP_USR_READONLY);
+
+  return memory_creat_map((pde_t *)page_dir, vaddr, shm->page + offset,
+                          page_count, privilege);
+}
+
+/**
+ * @brief 获取键值对应的共享内存段，不存在时按标志位创建
+ *
+ * @param key 键值，IPC_PRIVATE总是创建新的共享内存段
+ * @param size 共享内存段大小
+ * @param flags IPC_CREAT，IPC_EXCL
+ * @return int 共享内存段标识，-1：失败
+ */
+int sys_shmget(int key, uint32_t size, int flags) {
+  int shmid = -1;
+
+  mutex_lock(&shm_mutex);
+
+  // 1.查找键值相同的共享内存段
+  if (key != IPC_PRIVATE) {
+    for (int i = 0; i < SHM_COUNT; ++i) {
+      shm_t *shm = shm_table + i;
+      if (shm->page && !shm->removed && shm->key == key) {
+        if ((flags & IPC_CREAT) && (flags & IPC_EXCL)) {
+          goto shmget_end;
+        }
+        if (size > shm->page_count * MEM_PAGE_SIZE) {
+          goto shmget_end;
+        }
+
+        shmid = i;
+        goto shmget_end;
+      }
+    }
+
+    if (!(flags & IPC_CREAT)) {
+      goto shmget_end;
+    }
+  }
+
+  // 2.分配空闲的共享内存段
+  if (size == 0 || size > SHM_SIZE_MAX) {
+    goto shmget_end;
+  }
+
+  for (int i = 0; i < SHM_COUNT; ++i) {
+    shm_t *shm = shm_table + i;
+    if (shm->page) {
+      continue;
+    }
+
+    // 3.分配连续的物理页并清零，共享内存段自身持有每页的一次引用
+    int page_count = up2(size, MEM_PAGE_SIZE) / MEM_PAGE_SIZE;
+    uint32_t page = memory_alloc_page(page_count, MEM_TAG_SHM);
+    if (page == 0) {
+      log_printf("shmget: no memory.\n");
+      goto shmget_end;
+    }
+
+    kernel_memset((void *)page, 0, page_count * MEM_PAGE_SIZE);
+    for (int j = 0; j < page_count; ++j) {
+      memory_page_ref_add(page + j * MEM_PAGE_SIZE);
+    }
+
+    shm->key = key;
+    shm->page = page;
+    shm->page_count = page_count;
+    shm->ref = 0;
+    shm->removed = 0;
+    shmid = i;
+    goto shmget_end;
+  }
+
+  log_printf("shmget: no shm segment.\n");
+
+shmget_end:
+  mutex_unlock(&shm_mutex);
+  return shmid;
+}
+
+/**
+ * @brief 将共享内存段挂接到当前进程的映射区中，并立即建立所有页的映射
+ *
+ * @param shmid 共享内存段标识
+ * @param addr 期望的挂接地址，为0时由内核选择
+ * @param flags SHM_RDONLY
+ * @return int 挂接的起始地址，-1：失败
+ */
+int sys_shmat(int shmid, void *addr, int flags) {
+  shm_t *shm = shm_from_id(shmid);
+  if (!shm) {
+    return -1;
+  }
+
+  // 1.在映射区范围内分配虚拟空间
+  task_t *task = task_current();
+  int prot = (flags & SHM_RDONLY) ? PROT_READ : (PROT_READ | PROT_WRITE);
+  mmap_area_t *area =
+      mmap_area_creat(task, (uint32_t)addr, shm->page_count * MEM_PAGE_SIZE,
+                      prot, MAP_SHARED);
+  if (!area) {
+    return -1;
+  }
+
+  // 2.记录映射区引用的共享内存段，映射区释放时自动释放该引用
+  shm_get(shm);
+  area->shm = shm;
+  area->offset = 0;
+
+  // 3.将共享内存段的物理页映射到进程的虚拟空间
+  if (shm_map(shm, task->task_sw.page_dir, area->start, 0, shm->page_count,
+              prot) < 0) {
+    sys_munmap((void *)area->start, area->end - area->start);
+    return -1;
+  }
+
+  return area->start;
+}
+
+/**
+ * @brief 将挂接在addr处的共享内存段从当前进程中分离
+ *
+ * @param addr shmat返回的挂接地址
+ * @return int
+ */
+int sys_shmdt(void *addr) {
+  mmap_area_t *area = mmap_area_find(task_current(), (uint32_t)addr);
+  if (!area || !area->shm || area->start != (uint32_t)addr) {
+    return -1;
+  }
+
+  return sys_munmap(addr, area->end - area->start);
+}
+
+/**
+ * @brief 控制共享内存段，目前仅支持IPC_RMID
+ *
+ * @param shmid
+ * @param cmd
+ * @return int
+ */
+int sys_shmctl(int shmid, int cmd) {
+  if (cmd != IPC_RMID) {
+    return -1;
+  }
+
+  mutex_lock(&shm_mutex);
+
+  shm_t *shm = shm_from_id(shmid);
+  if (!shm) {
+    mutex_unlock(&shm_mutex);
+    return -1;
+  }
+
+  // 标记删除后键值不可再被获取，无人挂接时立即释放
+  shm->removed = 1;
+  if (shm->ref == 0) {
+    shm_destroy(shm);
+  }
+
+  mutex_unlock(&shm_mutex);
+  return 0;
+}
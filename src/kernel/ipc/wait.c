@@ -0,0 +1,73 @@
+/**
+ * @file wait.c
+ * @author kbpoyo (kbpoyo@qq.com)
+ * @brief 等待队列
+ * @version 0.1
+ * @date 2023-09-23
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#include "ipc/wait.h"
+
+#include "core/task.h"
+
+/**
+ * @brief 初始化等待队列
+ *
+ * @param queue
+ */
+void wait_queue_init(wait_queue_t *queue) { list_init(&queue->list); }
+
+/**
+ * @brief 将等待项加入等待队列，已加入时不做处理，等待项在移出之前不可释放
+ *
+ * @param queue
+ * @param entry 需已设置sem
+ */
+void wait_queue_add(wait_queue_t *queue, wait_entry_t *entry) {
+  cpu_state_t state = task_enter_protection();
+
+  if (!entry->queue) {
+    list_node_init(&entry->node);
+    list_insert_last(&queue->list, &entry->node);
+    entry->queue = queue;
+  }
+
+  task_leave_protection(state);
+}
+
+/**
+ * @brief 将等待项移出其所在的等待队列，未加入时不做处理
+ *
+ * @param entry
+ */
+void wait_queue_remove(wait_entry_t *entry) {
+  cpu_state_t state = task_enter_protection();
+
+  if (entry->queue) {
+    list_remove(&entry->queue->list, &entry->node);
+    entry->queue = (wait_queue_t *)0;
+  }
+
+  task_leave_protection(state);
+}
+
+/**
+ * @brief 唤醒等待队列上的所有等待者，等待项仍留在队列中，由等待者自行移出
+ *        可在中断与下半部中调用，被唤醒的任务插入就绪队列尾部，遍历期间不会被抢占
+ *
+ * @param queue
+ */
+void wait_queue_wakeup(wait_queue_t *queue) {
+  cpu_state_t state = task_enter_protection();
+
+  for (list_node_t *node = list_get_first(&queue->list); node;
+       node = list_node_next(node)) {
+    wait_entry_t *entry = list_node_parent(node, wait_entry_t, node);
+    sem_notify(entry->sem);
+  }
+
+  task_leave_protection(state);
+}
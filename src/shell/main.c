@@ -213,8 +213,14 @@ static int do_less(int argc, const char **argv) {
   } else {
     // 取消输入行缓存，使输入及时写入key中
     setvbuf(stdin, NULL, _IONBF, 0);
-    // 关闭TTY设备回显
-    ioctl(0, TTY_CMD_ECHO, 0, 0);
+    // TTY设备切换到非规范模式并关闭回显，按键无需回车即可读到
+    tty_mode_t mode, raw;
+    ioctl(0, TTY_CMD_GET_MODE, (int)&mode, 0);
+    raw = mode;
+    raw.iflags &= ~(TTY_ICANON | TTY_IECHO);
+    raw.vmin = 1;
+    raw.vtime = 0;
+    ioctl(0, TTY_CMD_SET_MODE, (int)&raw, 0);
     while (1) {
       char *b = fgets(buf, buf_len, file);
       if (b == NULL) {
@@ -233,8 +239,8 @@ static int do_less(int argc, const char **argv) {
   less_quit:
     // 恢复输入行缓存
     setvbuf(stdin, NULL, _IOLBF, BUFSIZ);
-    // 打开TTY设备回显
-    ioctl(0, TTY_CMD_ECHO, 1, 0);
+    // 恢复TTY设备原来的模式
+    ioctl(0, TTY_CMD_SET_MODE, (int)&mode, 0);
   }
 
   free(buf);
@@ -327,7 +333,7 @@ static int do_show_task_stat(int argc, const char **argv) {
 
   char *temp_buf = buf;
   printf(ESC_COLOR_SHELL);
-  printf("name\t\tpid\t\tppid\t\tmem\n");
+  printf("name\t\tpid\t\tppid\t\tmem\t\tkstack\n");
   for (int i = 0; i < task_count; ++i) {
     puts(temp_buf);
     temp_buf += (strlen(temp_buf) + 1);
@@ -346,7 +352,7 @@ static int do_show_task_stat(int argc, const char **argv) {
  * @return int
  */
 static int do_show_mem_stat(int argc, const char **argv) {
-  int buf_size = 1024;
+  int buf_size = 4096;
   char *buf = malloc(buf_size);
   memset(buf, 0, buf_size);
 
@@ -366,6 +372,338 @@ static int do_show_mem_stat(int argc, const char **argv) {
   return 0;
 }
 
+/**
+ * @brief 控制内核事件跟踪，或将跟踪记录导出到文件中供主机端解析
+ *
+ * @param argc
+ * @param argv
+ * @return int
+ */
+static int do_trace(int argc, const char **argv) {
+  if (argc < 2) {
+    fprintf(stderr, "no trace command\n");
+    return -1;
+  }
+
+  if (strcmp(argv[1], "on") == 0) {
+    // 默认使能所有事件
+    int mask = argc > 2 ? strtol(argv[2], NULL, 0) : TRACE_MASK_ALL;
+    trace_ctl(TRACE_CMD_SET_MASK, mask, 0);
+    return 0;
+  } else if (strcmp(argv[1], "off") == 0) {
+    trace_ctl(TRACE_CMD_SET_MASK, 0, 0);
+    return 0;
+  } else if (strcmp(argv[1], "clear") == 0) {
+    return trace_ctl(TRACE_CMD_CLEAR, 0, 0);
+  } else if (strcmp(argv[1], "dump") != 0 || argc < 3) {
+    fprintf(stderr, "unknown trace command or no file input\n");
+    return -1;
+  }
+
+  // 1.读取内核中的跟踪记录
+  trace_record_t *records = malloc(TRACE_BUF_COUNT * sizeof(trace_record_t));
+  if (!records) {
+    fprintf(stderr, "no memory\n");
+    return -1;
+  }
+
+  int count = trace_ctl(TRACE_CMD_READ, (int)records, TRACE_BUF_COUNT);
+  if (count < 0) {
+    fprintf(stderr, "read trace failed\n");
+    free(records);
+    return -1;
+  }
+
+  // 2.写入文件头与记录
+  FILE *file = fopen(argv[2], "wb");
+  if (!file) {
+    fprintf(stderr, "open file failed: %s\n", argv[2]);
+    free(records);
+    return -1;
+  }
+
+  trace_file_header_t header = {
+      .magic = TRACE_FILE_MAGIC,
+      .version = TRACE_FILE_VERSION,
+      .record_size = sizeof(trace_record_t),
+      .time_unit_us = TRACE_TIME_UNIT_US,
+      .count = count,
+  };
+  fwrite(&header, sizeof(header), 1, file);
+  fwrite(records, sizeof(trace_record_t), count, file);
+  fclose(file);
+  free(records);
+
+  printf("%d trace records saved to %s\n", count, argv[2]);
+  return 0;
+}
+
+/**
+ * @brief 控制内核采样分析，或将样本导出到文件中供主机端符号化
+ *
+ * @param argc
+ * @param argv
+ * @return int
+ */
+static int do_prof(int argc, const char **argv) {
+  if (argc < 2) {
+    fprintf(stderr, "no prof command\n");
+    return -1;
+  }
+
+  if (strcmp(argv[1], "start") == 0) {
+    return prof_ctl(PROF_CMD_START, 0, 0);
+  } else if (strcmp(argv[1], "stop") == 0) {
+    printf("%d samples\n", prof_ctl(PROF_CMD_STOP, 0, 0));
+    return 0;
+  } else if (strcmp(argv[1], "dump") != 0 || argc < 3) {
+    fprintf(stderr, "unknown prof command or no file input\n");
+    return -1;
+  }
+
+  // 1.停止采样并读取任务信息与样本
+  prof_ctl(PROF_CMD_STOP, 0, 0);
+  prof_task_t *tasks = malloc(PROF_TASK_COUNT * sizeof(prof_task_t));
+  prof_sample_t *samples = malloc(PROF_SAMPLE_COUNT * sizeof(prof_sample_t));
+  if (!tasks || !samples) {
+    fprintf(stderr, "no memory\n");
+    free(tasks);
+    free(samples);
+    return -1;
+  }
+
+  int task_count = prof_ctl(PROF_CMD_READ_TASKS, (int)tasks, PROF_TASK_COUNT);
+  int sample_count = prof_ctl(PROF_CMD_READ, (int)samples, PROF_SAMPLE_COUNT);
+  if (task_count < 0 || sample_count < 0) {
+    fprintf(stderr, "read prof samples failed\n");
+    free(tasks);
+    free(samples);
+    return -1;
+  }
+
+  // 2.写入文件头、任务信息与样本
+  FILE *file = fopen(argv[2], "wb");
+  if (!file) {
+    fprintf(stderr, "open file failed: %s\n", argv[2]);
+    free(tasks);
+    free(samples);
+    return -1;
+  }
+
+  prof_file_header_t header = {
+      .magic = PROF_FILE_MAGIC,
+      .version = PROF_FILE_VERSION,
+      .period_us = PROF_SAMPLE_PERIOD_US,
+      .task_count = task_count,
+      .sample_count = sample_count,
+      .dropped = prof_ctl(PROF_CMD_DROPPED, 0, 0),
+  };
+  fwrite(&header, sizeof(header), 1, file);
+  fwrite(tasks, sizeof(prof_task_t), task_count, file);
+  fwrite(samples, sizeof(prof_sample_t), sample_count, file);
+  fclose(file);
+  free(tasks);
+  free(samples);
+
+  printf("%d samples saved to %s\n", sample_count, argv[2]);
+  return 0;
+}
+
+/**
+ * @brief 显示各中断源的次数、处理时间、cpu占用与进入延迟直方图，或清空统计
+ *
+ * @param argc
+ * @param argv
+ * @return int
+ */
+static int do_interrupts(int argc, const char **argv) {
+  if (argc > 1) {
+    if (strcmp(argv[1], "clear") == 0) {
+      return irq_stat_ctl(IRQ_STAT_CMD_CLEAR, NULL);
+    }
+    fprintf(stderr, "unknown interrupts command\n");
+    return -1;
+  }
+
+  static irq_stats_t stats;
+  if (irq_stat_ctl(IRQ_STAT_CMD_READ, &stats) < 0) {
+    fprintf(stderr, "read irq stat failed\n");
+    return -1;
+  }
+
+  // 1.各中断源的次数与处理时间，时间单位为微秒，cpu占用以万分之一为单位计算
+  uint32_t elapsed = stats.elapsed / 100 ? stats.elapsed / 100 : 1;
+  printf("%-3s %-9s %10s %8s %8s %8s %7s\n", "irq", "name", "count",
+         "min(us)", "avg(us)", "max(us)", "cpu(%)");
+  for (int i = 0; i < IRQ_NUM_MAX; ++i) {
+    irq_stat_t *stat = stats.irq + i;
+    if (stat->count == 0) {
+      continue;
+    }
+
+    uint32_t cpu = stat->time_total * 100 / elapsed;
+    printf("%-3d %-9s %10d %8d %8d %8d %4d.%02d\n", i, stat->name, stat->count,
+           stat->time_min * IRQ_STAT_TIME_UNIT_US,
+           stat->time_total / stat->count * IRQ_STAT_TIME_UNIT_US,
+           stat->time_max * IRQ_STAT_TIME_UNIT_US, cpu / 100, cpu % 100);
+  }
+  printf("spurious: %d, elapsed: %dms\n", stats.spurious,
+         stats.elapsed * IRQ_STAT_TIME_UNIT_US / 1000);
+
+  // 2.有延迟测量的中断源的进入延迟直方图
+  for (int i = 0; i < IRQ_NUM_MAX; ++i) {
+    irq_stat_t *stat = stats.irq + i;
+    uint32_t total = 0;
+    for (int j = 0; j < IRQ_LAT_BUCKETS; ++j) {
+      total += stat->latency[j];
+    }
+    if (total == 0) {
+      continue;
+    }
+
+    printf("\n%s entry latency:\n", stat->name);
+    uint32_t bound = IRQ_LAT_BUCKET0_US;
+    for (int j = 0; j < IRQ_LAT_BUCKETS; ++j, bound <<= 1) {
+      if (j < IRQ_LAT_BUCKETS - 1) {
+        printf("  < %6dus: %d\n", bound, stat->latency[j]);
+      } else {
+        printf("  >=%6dus: %d\n", bound >> 1, stat->latency[j]);
+      }
+    }
+  }
+
+  return 0;
+}
+
+/**
+ * @brief 按总等待时间从大到小显示内核锁的竞争统计，或清空统计
+ *
+ * @param argc
+ * @param argv
+ * @return int
+ */
+static int do_lock_stat(int argc, const char **argv) {
+  if (argc > 1) {
+    if (strcmp(argv[1], "clear") == 0) {
+      return lock_stat_ctl(LOCK_STAT_CMD_CLEAR, 0, 0);
+    }
+    fprintf(stderr, "unknown lockstat command\n");
+    return -1;
+  }
+
+  static lock_stat_t stats[LOCK_STAT_COUNT];
+  int count = lock_stat_ctl(LOCK_STAT_CMD_READ, (int)stats, LOCK_STAT_COUNT);
+  if (count < 0) {
+    fprintf(stderr, "read lock stat failed\n");
+    return -1;
+  }
+
+  // 1.按总等待时间排序，锁的数量很少，直接选择排序
+  for (int i = 0; i < count; ++i) {
+    int max = i;
+    for (int j = i + 1; j < count; ++j) {
+      if (stats[j].wait_total > stats[max].wait_total) {
+        max = j;
+      }
+    }
+    lock_stat_t tmp = stats[i];
+    stats[i] = stats[max];
+    stats[max] = tmp;
+  }
+
+  // 2.输出统计，时间单位为微秒
+  printf("%-16s %8s %8s %10s %10s %6s %10s %10s\n", "name", "acquired",
+         "contend", "wait_avg", "wait_max", "owner", "hold_avg", "hold_max");
+  for (int i = 0; i < count; ++i) {
+    lock_stat_t *stat = stats + i;
+    printf("%-16s %8d %8d %10d %10d %6d %10d %10d\n", stat->name,
+           stat->acquired, stat->contended,
+           stat->contended
+               ? stat->wait_total / stat->contended * LOCK_STAT_TIME_UNIT_US
+               : 0,
+           stat->wait_max * LOCK_STAT_TIME_UNIT_US, stat->wait_max_owner,
+           stat->acquired
+               ? stat->hold_total / stat->acquired * LOCK_STAT_TIME_UNIT_US
+               : 0,
+           stat->hold_max * LOCK_STAT_TIME_UNIT_US);
+  }
+
+  return 0;
+}
+
+/**
+ * @brief 显示系统启动后经过的时间，分别通过系统调用与时间页读取
+ *
+ * @param argc
+ * @param argv
+ * @return int
+ */
+static int do_uptime(int argc, const char **argv) {
+  struct timespec now, coarse;
+  if (clock_gettime(CLOCK_MONOTONIC, &now) < 0) {
+    fprintf(stderr, "clock_gettime failed\n");
+    return -1;
+  }
+  clock_gettime_coarse(&coarse);
+
+  printf("up %d.%06ds, time page %d.%06ds\n", (int)now.tv_sec,
+         (int)(now.tv_nsec / 1000), (int)coarse.tv_sec,
+         (int)(coarse.tv_nsec / 1000));
+  return 0;
+}
+
+/**
+ * @brief 计算吞吐量，单位为MB/s，即每微秒处理的字节数
+ *
+ * @param bytes
+ * @param time 耗时，单位为KLIB_BENCH_TIME_UNIT_US
+ * @return int
+ */
+static int bench_rate(uint32_t bytes, uint32_t time) {
+  return time ? bytes / (time * KLIB_BENCH_TIME_UNIT_US) : 0;
+}
+
+/**
+ * @brief 在内核中对比内存函数的汇编实现与原逐字节实现，
+ *        每种大小分别测试源地址对齐与不对齐的情况，输出吞吐量MB/s
+ *
+ * @param argc
+ * @param argv
+ * @return int
+ */
+static int do_membench(int argc, const char **argv) {
+  static const uint32_t size_list[] = {16, 64, 256, 1024, 4096, 16384};
+  // 每项测试处理的总字节数，默认1MB
+  uint32_t total = argc > 1 ? atoi(argv[1]) * 1024 : 1024 * 1024;
+
+  printf("%-6s %-3s %15s %15s %15s\n", "size", "off", "memcpy asm/byte",
+         "memset asm/byte", "memcmp asm/byte");
+  for (int i = 0; i < sizeof(size_list) / sizeof(size_list[0]); ++i) {
+    for (uint32_t offset = 0; offset < 2; ++offset) {
+      klib_bench_t bench;
+      bench.size = size_list[i];
+      bench.offset = offset;
+      bench.loops = total / bench.size ? total / bench.size : 1;
+      if (klib_bench(&bench) < 0) {
+        fprintf(stderr, "membench failed\n");
+        return -1;
+      }
+
+      uint32_t bytes = bench.size * bench.loops;
+      printf("%-6d %-3d %7d/%-7d %7d/%-7d %7d/%-7d\n", (int)bench.size,
+             (int)offset,
+             bench_rate(bytes, bench.asm_memcpy),
+             bench_rate(bytes, bench.byte_memcpy),
+             bench_rate(bytes, bench.asm_memset),
+             bench_rate(bytes, bench.byte_memset),
+             bench_rate(bytes, bench.asm_memcmp),
+             bench_rate(bytes, bench.byte_memcmp));
+    }
+  }
+
+  return 0;
+}
+
 // 终端命令表
 static const cli_cmd_t cmd_list[] = {
     {
@@ -418,6 +756,36 @@ static const cli_cmd_t cmd_list[] = {
         .usage = "mem_status\t\t\t\t--show the status of memory",
         .do_func = do_show_mem_stat,
 
+    },
+    {
+        .name = "trace",
+        .usage = "trace on [mask]|off|clear|dump file\t\t--kernel event trace",
+        .do_func = do_trace,
+    },
+    {
+        .name = "prof",
+        .usage = "prof start|stop|dump file\t\t--kernel sampling profiler",
+        .do_func = do_prof,
+    },
+    {
+        .name = "lockstat",
+        .usage = "lockstat [clear]\t\t\t--kernel lock contention",
+        .do_func = do_lock_stat,
+    },
+    {
+        .name = "interrupts",
+        .usage = "interrupts [clear]\t\t\t--kernel interrupt statistics",
+        .do_func = do_interrupts,
+    },
+    {
+        .name = "uptime",
+        .usage = "uptime\t\t\t\t--time since boot",
+        .do_func = do_uptime,
+    },
+    {
+        .name = "membench",
+        .usage = "membench [kbytes]\t\t\t--kernel memcpy/memset/memcmp speed",
+        .do_func = do_membench,
     }};
 
 /**
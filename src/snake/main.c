@@ -262,21 +262,25 @@ int main(int argc, char **argv) {
   row_max = 25;
   col_max = 80;
 
-  ioctl(0, TTY_CMD_ECHO, 0, 0);
+  // 切换到非规范模式并关闭回显，按键无需回车即可读到
+  tty_mode_t mode, raw;
+  ioctl(0, TTY_CMD_GET_MODE, (int)&mode, 0);
+  raw = mode;
+  raw.iflags &= ~(TTY_ICANON | TTY_IECHO);
+  raw.vmin = 1;
+  raw.vtime = 0;
+  ioctl(0, TTY_CMD_SET_MODE, (int)&raw, 0);
 
   show_welcome();
   begin_game();
 
-  int count;
-  int cnt = 0;
+  // 等待键盘输入期间睡眠，超时仍没有按键时自动往前移
+  struct pollfd pfd = {.fd = 0, .events = POLLIN};
   do {
-    // 检查是否有键盘输入
-    ioctl(0, TTY_CMD_IN_COUNT, (int)&count, 0);
-    if (count) {
+    if (poll(&pfd, 1, SNAKE_STEP_MS) > 0) {
       int ch = getchar();
       move_forward(ch);
-    } else if (++cnt % 50 == 0) {
-      // 每隔一段时间自动往前移
+    } else {
       move_forward(snake.dir);
     }
 
@@ -289,12 +293,10 @@ int main(int argc, char **argv) {
       getchar();
       break;
     }
-
-    msleep(10);
   } while (1);
 
-  // 这里是有危险的，如果进程异常退出，将导致回显失败
-  ioctl(0, TTY_CMD_ECHO, 1, 0);
+  // 这里是有危险的，如果进程异常退出，将导致tty模式无法恢复
+  ioctl(0, TTY_CMD_SET_MODE, (int)&mode, 0);
   clear_map();
   // 光标移回0行0列
   printf("\x1b[%d;%dH", 0, 0);
@@ -10,6 +10,8 @@
 #define PLAYER1_KEY_RIGHT 'd'
 #define PLAYER1_KEY_QUITE 'q'
 
+#define SNAKE_STEP_MS 500  // 没有按键时蛇自动往前移的间隔
+
 // clang-format off
 #define ESC_COLOR_SNAKE ESC_CMD2(38;2;255;255;0, m) 
 #define ESC_COLOR_FOOD ESC_CMD2(38;2;0;255;0, m)
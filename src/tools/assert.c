@@ -24,6 +24,7 @@
 void pannic(const char *file, int line, const char *func, const char *reason) {
     log_printf("assert faild! %s\n", reason);
     log_printf("file:\t%s\nline:\t%d\nfunc:\t%s\n", file, line, func);
+    log_flush();
     for (;;) {
     }
 
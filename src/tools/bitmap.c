@@ -2,6 +2,8 @@
  * @file bitmap.c
  * @author kbpoyo (kbpoyo.com)
  * @brief  定义位图相关操作
+ *         位图按32位的字访问，全满或全空的字整体跳过，
+ *         第二级摘要记录哪些字中还有值为0的位，查找空闲位时可跳过整段已满的字
  * @version 0.1
  * @date 2023-02-04
  *
@@ -15,20 +17,132 @@
 #include "tools/klib.h"
 
 /**
- * @brief  向上取整获取位图数组中有多少字节
+ * @brief  计算字中值为1的位数
+ *
+ * @param v
+ * @return int
+ */
+static inline int word_popcount(uint32_t v) {
+  v = v - ((v >> 1) & 0x55555555);
+  v = (v & 0x33333333) + ((v >> 2) & 0x33333333);
+  v = (v + (v >> 4)) & 0x0f0f0f0f;
+  return (v * 0x01010101) >> 24;
+}
+
+/**
+ * @brief  获取字中最低的值为1的位的索引，v不能为0
+ *
+ * @param v
+ * @return int
+ */
+static inline int word_lowest_bit(uint32_t v) {
+  int index = 0;
+  if ((v & 0xffff) == 0) {
+    v >>= 16;
+    index += 16;
+  }
+  if ((v & 0xff) == 0) {
+    v >>= 8;
+    index += 8;
+  }
+  if ((v & 0xf) == 0) {
+    v >>= 4;
+    index += 4;
+  }
+  if ((v & 0x3) == 0) {
+    v >>= 2;
+    index += 2;
+  }
+  if ((v & 0x1) == 0) {
+    index += 1;
+  }
+
+  return index;
+}
+
+/**
+ * @brief  根据第word个字的值更新摘要中对应的位
+ *
+ * @param bitmap
+ * @param word
+ */
+static inline void summary_update(bitmap_t *bitmap, uint32_t word) {
+  if (bitmap->bits[word] != 0xffffffff) {
+    bitmap->summary[word / 32] |= (1u << (word % 32));
+  } else {
+    bitmap->summary[word / 32] &= ~(1u << (word % 32));
+  }
+}
+
+/**
+ * @brief  通过摘要查找从第word个字开始第一个含有值为0的位的字
+ *
+ * @param bitmap
+ * @param word
+ * @return uint32_t 字的索引，不存在时返回word_count
+ */
+static uint32_t summary_find(bitmap_t *bitmap, uint32_t word) {
+  uint32_t summary_count = (bitmap->word_count + 31) / 32;
+
+  for (uint32_t i = word / 32; i < summary_count; ++i) {
+    uint32_t s = bitmap->summary[i];
+    if (i == word / 32) {  // 忽略第一个摘要字中word之前的部分
+      s &= ~((1u << (word % 32)) - 1);
+    }
+
+    if (s) {
+      return i * 32 + word_lowest_bit(s);
+    }
+  }
+
+  return bitmap->word_count;
+}
+
+/**
+ * @brief  查找[index, end)范围内第一个值为bit的位
+ *
+ * @param bitmap
+ * @param index
+ * @param end
+ * @param bit
+ * @return uint32_t 位的索引，不存在时返回end
+ */
+static uint32_t bitmap_find(bitmap_t *bitmap, uint32_t index, uint32_t end,
+                            int bit) {
+  while (index < end) {
+    uint32_t word = index / 32;
+    uint32_t v = bit ? bitmap->bits[word] : ~bitmap->bits[word];
+    v &= ~((1u << (index % 32)) - 1);  // 忽略字中index之前的位
+
+    if (v) {
+      index = word * 32 + word_lowest_bit(v);
+      return index < end ? index : end;
+    }
+
+    // 该字中没有值为bit的位，查找空闲位时通过摘要跳过已满的字
+    word = bit ? word + 1 : summary_find(bitmap, word + 1);
+    index = word * 32;
+  }
+
+  return end;
+}
+
+/**
+ * @brief  向上取整获取位图数组中有多少字节，包括位图本身和第二级摘要
  *
  * @param bit_count  位图数组拥有的bit位数
  * @return int 向上取整得到的字节数
  */
 uint32_t bitmap_byte_count(uint32_t bit_count) {
-  return (bit_count + 8 - 1) / 8;
+  return BITMAP_BYTES(bit_count);
 }
 
 /**
  * @brief  初始化位图数据结构
  *
  * @param bitmap 需要初始化的位图
- * @param bits 位图所包含的位图数组的起始地址
+ * @param bits 位图所包含的位图数组的起始地址，需按4字节对齐，
+ *             大小为bitmap_byte_count(count)
  * @param count 页的数量
  * @param init_bit 将位图数组的每一位设置为init_bit
  */
@@ -36,14 +150,30 @@ void bitmap_init(bitmap_t *bitmap, uint8_t *bits, uint32_t count,
                  int init_bit) {
   ASSERT(bitmap != (bitmap_t *)0);
   ASSERT(bits != (uint8_t *)0);
+  ASSERT(((uint32_t)bits & 0x3) == 0);
 
   bitmap->bit_count = count;
-  bitmap->bits = bits;
+  bitmap->word_count = BITMAP_WORDS(count);
+  bitmap->bits = (uint32_t *)bits;
+  bitmap->summary = bitmap->bits + bitmap->word_count;
+  bitmap->hint = 0;
 
-  // 计算该位图需要多少字节
-  uint32_t bytes = bitmap_byte_count(bitmap->bit_count);
+  // 1.设置所有位
+  kernel_memset(bitmap->bits, init_bit ? 0xff : 0,
+                bitmap->word_count * sizeof(uint32_t));
+  bitmap->set_count = init_bit ? count : 0;
 
-  kernel_memset(bitmap->bits, init_bit ? 0xff : 0, bytes);
+  // 2.最后一个字中超出count的位始终置1，使其不会被当作空闲位
+  if (count % 32) {
+    bitmap->bits[bitmap->word_count - 1] |= ~((1u << (count % 32)) - 1);
+  }
+
+  // 3.建立摘要
+  kernel_memset(bitmap->summary, 0,
+                BITMAP_SUMMARY_WORDS(count) * sizeof(uint32_t));
+  for (uint32_t i = 0; i < bitmap->word_count; ++i) {
+    summary_update(bitmap, i);
+  }
 }
 
 /**
@@ -57,11 +187,12 @@ uint8_t bitmap_get_bit(bitmap_t *bitmap, int index) {
   ASSERT(bitmap != (bitmap_t *)0);
   ASSERT(index >= 0);
 
-  return (bitmap->bits[index / 8] & (1 << (index % 8)));
+  return (bitmap->bits[index / 32] >> (index % 32)) & 0x1;
 }
 
 /**
  * @brief  将bitmap中的位图数组从index位开始一共count位，设置为bit
+ *         按字批量设置，并同步更新摘要与值为1的位数
  *
  * @param bitmap
  * @param index
@@ -71,12 +202,30 @@ uint8_t bitmap_get_bit(bitmap_t *bitmap, int index) {
 void bitmap_set_bit(bitmap_t *bitmap, int index, uint32_t count, int bit) {
   ASSERT(bitmap != (bitmap_t *)0);
   ASSERT(index >= 0 && count >= 0);
-  for (int i = 0; i < count && index < bitmap->bit_count; ++i, ++index) {
-    if (bit) {
-      bitmap->bits[index / 8] |= (1 << (index % 8));
-    } else {
-      bitmap->bits[index / 8] &= ~(1 << (index % 8));
+
+  // 超出位图的部分被忽略
+  uint32_t start = index;
+  if (start >= bitmap->bit_count) {
+    return;
+  }
+  uint32_t end = count > bitmap->bit_count - start ? bitmap->bit_count
+                                                    : start + count;
+
+  while (start < end) {
+    uint32_t word = start / 32;
+    uint32_t offset = start % 32;
+    uint32_t n = 32 - offset < end - start ? 32 - offset : end - start;
+    uint32_t mask = (n == 32 ? 0xffffffff : ((1u << n) - 1)) << offset;
+
+    uint32_t old = bitmap->bits[word];
+    uint32_t value = bit ? (old | mask) : (old & ~mask);
+    if (value != old) {
+      bitmap->set_count += word_popcount(value) - word_popcount(old);
+      bitmap->bits[word] = value;
+      summary_update(bitmap, word);
     }
+
+    start += n;
   }
 }
 
@@ -91,8 +240,52 @@ int bitmap_is_set(bitmap_t *bitmap, int index) {
   return bitmap_get_bit(bitmap, index) ? 1 : 0;
 }
 
+/**
+ * @brief  返回bitmap中值为1的位的数量
+ *
+ * @param bitmap
+ * @return uint32_t
+ */
+uint32_t bitmap_count_set(bitmap_t *bitmap) { return bitmap->set_count; }
+
+/**
+ * @brief  在[start, end)范围内寻找count个连续的值为bit的位，且起始位索引按align对齐
+ *
+ * @param bitmap
+ * @param bit
+ * @param count
+ * @param align
+ * @param start
+ * @param end
+ * @return int 起始索引，-1:没有满足要求的空间
+ */
+static int bitmap_search(bitmap_t *bitmap, int bit, uint32_t count,
+                         uint32_t align, uint32_t start, uint32_t end) {
+  uint32_t index = start;
+  while (index < end) {
+    // 1.寻找第一个值为bit的位，并按align对齐
+    index = bitmap_find(bitmap, index, end, bit);
+    index = up2(index, align);
+    if (index >= end || end - index < count) {
+      return -1;
+    }
+
+    // 2.寻找该位之后第一个值不为bit的位，二者之间即为一段连续的可分配空间
+    uint32_t run_end = bitmap_find(bitmap, index, index + count, !bit);
+    if (run_end == index + count) {
+      return index;
+    }
+
+    // 3.空间不足，从不满足要求的位之后继续寻找
+    index = run_end + 1;
+  }
+
+  return -1;
+}
+
 /**
  * @brief  在bitmap中分配一块大小为count个位的空间, 并且起始位索引按align对齐
+ *         从上次分配结束的位置开始寻找（下次适应），到达末尾后再从头寻找
  *
  * @param bitmap
  * @param bit 当某一位的值为bit时表示该位空闲，可供分配
@@ -104,38 +297,34 @@ int bitmap_alloc_nbits_align(bitmap_t *bitmap, int bit, uint32_t count,
   ASSERT(bitmap != (bitmap_t *)0);
   ASSERT(count >= 0 && align >= 0);
 
-  int search_index = 0;
-  int ok_index = -1;
-  while (search_index < bitmap->bit_count) {
-    // 确定可分配空间的起始索引
-    if (bitmap_get_bit(bitmap, search_index) != bit) {
-      search_index += align;
-      continue;
-    }
+  bit = bit ? 1 : 0;
+  if (count == 0) {
+    return -1;
+  }
+  if (align <= 0) {
+    align = 1;
+  }
 
-    // 记录可分配空间的起始索引
-    ok_index = search_index++;
-
-    // 判断该空间是否大小满足要求
-    for (int i = 1; i < count; ++i) {
-      // 空间大小不满足要求, 分配失败
-      if (search_index >= bitmap->bit_count ||
-          bitmap_get_bit(bitmap, search_index++) != bit) {
-        ok_index = -1;
-        search_index = up2(search_index, align);
-        break;
-      }
-    }
+  // 1.从下次适应的位置开始寻找，未找到时再从头寻找
+  uint32_t start = bitmap->hint * 32;
+  if (start >= bitmap->bit_count) {
+    start = 0;
+  }
 
-    if (ok_index != -1) {  // 分配成功
-      // 将该片空间标记为已分配状态, 并返回起始索引
-      bitmap_set_bit(bitmap, ok_index, count, ~bit);
-      return ok_index;
-    }
+  int index = bitmap_search(bitmap, bit, count, align, start, bitmap->bit_count);
+  if (index < 0 && start > 0) {
+    index = bitmap_search(bitmap, bit, count, align, 0, bitmap->bit_count);
   }
 
-  // 遍历完整个位图也没有满足要求的空间则返回-1
-  return -1;
+  if (index < 0) {
+    // 遍历完整个位图也没有满足要求的空间则返回-1
+    return -1;
+  }
+
+  // 2.将该片空间标记为已分配状态, 记录下次适应的位置并返回起始索引
+  bitmap_set_bit(bitmap, index, count, !bit);
+  bitmap->hint = (index + count) / 32;
+  return index;
 }
 
 /**
@@ -148,4 +337,4 @@ int bitmap_alloc_nbits_align(bitmap_t *bitmap, int bit, uint32_t count,
  */
 int bitmap_alloc_nbits(bitmap_t *bitmap, int bit, uint32_t count) {
   return bitmap_alloc_nbits_align(bitmap, bit, count, 1);
-}
\ No newline at end of file
+}
@@ -0,0 +1,189 @@
+/**
+ * @file hash.c
+ * @author kbpoyo (kbpoyo@qq.com)
+ * @brief  侵入式哈希表，桶数为2的幂，以键值的低位选择桶
+ *         哈希表本身不分配内存，扩容时由使用者提供新的桶数组并释放旧的桶数组，
+ *         因此内核与用户程序均可使用
+ * @version 0.1
+ * @date 2023-09-15
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#include "tools/hash.h"
+
+#include "tools/assert.h"
+
+/**
+ * @brief  计算字符串的哈希值(FNV-1a)
+ *
+ * @param str
+ * @return uint32_t
+ */
+uint32_t hash_string(const char *str) {
+  uint32_t hash = 2166136261u;
+  while (*str) {
+    hash ^= (uint8_t)*str++;
+    hash *= 16777619u;
+  }
+
+  return hash;
+}
+
+/**
+ * @brief  计算一段内存的哈希值(FNV-1a)
+ *
+ * @param buf
+ * @param size
+ * @return uint32_t
+ */
+uint32_t hash_mem(const void *buf, int size) {
+  const uint8_t *p = (const uint8_t *)buf;
+  uint32_t hash = 2166136261u;
+  while (size-- > 0) {
+    hash ^= *p++;
+    hash *= 16777619u;
+  }
+
+  return hash;
+}
+
+/**
+ * @brief  获取键值所在的桶
+ *
+ * @param table
+ * @param key
+ * @return hash_node_t**
+ */
+static inline hash_node_t **hash_bucket(hash_table_t *table, uint32_t key) {
+  return table->buckets + (key & (table->bucket_count - 1));
+}
+
+/**
+ * @brief  初始化哈希表
+ *
+ * @param table
+ * @param buckets 桶数组的存储空间
+ * @param bucket_count 桶数，必须为2的幂
+ */
+void hash_init(hash_table_t *table, hash_node_t **buckets,
+               uint32_t bucket_count) {
+  ASSERT(table != (hash_table_t *)0 && buckets != (hash_node_t **)0);
+  ASSERT(bucket_count && (bucket_count & (bucket_count - 1)) == 0);
+
+  table->buckets = buckets;
+  table->bucket_count = bucket_count;
+  table->size = 0;
+  for (uint32_t i = 0; i < bucket_count; ++i) {
+    buckets[i] = (hash_node_t *)0;
+  }
+}
+
+/**
+ * @brief  将节点以key为键值插入哈希表，允许键值重复
+ *
+ * @param table
+ * @param node
+ * @param key
+ */
+void hash_insert(hash_table_t *table, hash_node_t *node, uint32_t key) {
+  ASSERT(table != (hash_table_t *)0 && node != (hash_node_t *)0);
+
+  hash_node_t **bucket = hash_bucket(table, key);
+  node->key = key;
+  node->next = *bucket;
+  *bucket = node;
+  table->size++;
+}
+
+/**
+ * @brief  将节点从哈希表中移除
+ *
+ * @param table
+ * @param node
+ * @return hash_node_t* 被移除的节点，节点不在哈希表中时返回0
+ */
+hash_node_t *hash_remove(hash_table_t *table, hash_node_t *node) {
+  ASSERT(table != (hash_table_t *)0 && node != (hash_node_t *)0);
+
+  for (hash_node_t **link = hash_bucket(table, node->key); *link;
+       link = &(*link)->next) {
+    if (*link == node) {
+      *link = node->next;
+      node->next = (hash_node_t *)0;
+      table->size--;
+      return node;
+    }
+  }
+
+  return (hash_node_t *)0;
+}
+
+/**
+ * @brief  查找第一个键值为key的节点
+ *
+ * @param table
+ * @param key
+ * @return hash_node_t* 不存在时返回0
+ */
+hash_node_t *hash_find(hash_table_t *table, uint32_t key) {
+  ASSERT(table != (hash_table_t *)0);
+
+  hash_node_t *node = *hash_bucket(table, key);
+  while (node && node->key != key) {
+    node = node->next;
+  }
+
+  return node;
+}
+
+/**
+ * @brief  查找node之后下一个与node键值相同的节点，用于遍历键值冲突的节点
+ *
+ * @param node
+ * @return hash_node_t* 不存在时返回0
+ */
+hash_node_t *hash_find_next(hash_node_t *node) {
+  ASSERT(node != (hash_node_t *)0);
+
+  uint32_t key = node->key;
+  node = node->next;
+  while (node && node->key != key) {
+    node = node->next;
+  }
+
+  return node;
+}
+
+/**
+ * @brief  将哈希表中的所有节点迁移到新的桶数组中
+ *
+ * @param table
+ * @param buckets 新的桶数组
+ * @param bucket_count 新的桶数，必须为2的幂
+ * @return hash_node_t** 旧的桶数组，由调用者释放
+ */
+hash_node_t **hash_resize(hash_table_t *table, hash_node_t **buckets,
+                          uint32_t bucket_count) {
+  ASSERT(table != (hash_table_t *)0 && buckets != (hash_node_t **)0);
+  ASSERT(bucket_count && (bucket_count & (bucket_count - 1)) == 0);
+
+  hash_node_t **old_buckets = table->buckets;
+  uint32_t old_count = table->bucket_count;
+
+  // 1.初始化新的桶数组
+  hash_init(table, buckets, bucket_count);
+
+  // 2.逐个将旧桶中的节点重新插入
+  for (uint32_t i = 0; i < old_count; ++i) {
+    hash_node_t *node = old_buckets[i];
+    while (node) {
+      hash_node_t *next = node->next;
+      hash_insert(table, node, node->key);
+      node = next;
+    }
+  }
+
+  return old_buckets;
+}
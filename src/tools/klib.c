@@ -96,70 +96,7 @@ int kernel_strlen(const char *str) {
     return len;
 }
 
-/**
- * @brief  内存复制
- *
- * @param dest 目的内存的起始地址
- * @param src 原内存的起始地址
- * @param size 复制的内存字节大小
- */
-void kernel_memcpy(void *dest, const void *src, int size) {
-    if (!dest || !src || !size)
-        return;
-
-    uint8_t *d = (uint8_t *)dest;
-    uint8_t *s = (uint8_t *)src;
-
-    while (size--) {
-        *(d++) = *(s++);
-    }
-}
-
-/**
- * @brief  对内存区域每一个字节赋值置
- *
- * @param dest 区域起始地址
- * @param v 每个字节的值
- * @param size 赋值的内存的大小
- */
-void kernel_memset(void *dest, uint8_t v, int size) {
-    if (!dest || !size)
-        return;
-
-    uint8_t *d = (uint8_t *)dest;
-
-    while (size--) {
-        *(d++) = v;
-    }
-}
-
-/**
- * @brief  按按内存区域从低地址到高地址逐字节比较大小
- *
- * @param d1 区域1的起始地址
- * @param d2 区域2的起始地址
- * @param size 比较的字节数量
- * @return int ==:0, >:1, <:-1
- */
-int kernel_memcmp(const void *dest1, const void *dest2, int size) {
-    if (!dest1 || !dest2 || !size)
-        return 0;
-
-    uint8_t *d1 = (uint8_t *)dest1;
-    uint8_t *d2 = (uint8_t *)dest2;
-
-    while (--size && *d1 == *d2) {
-        d1++;
-        d2++;
-    }
-
-    if (*d1 > *d2)
-        return 1;
-    else if (*d1 < *d2)
-        return -1;
-    else
-        return 0;
-}
+// kernel_memcpy、kernel_memset与kernel_memcmp在klib_mem.S中用汇编实现
 
 void kernel_sprintf(char *buf, const char *formate, ...) {
     // 获取可变参数并将其格式化到缓冲区中
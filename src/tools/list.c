@@ -48,6 +48,22 @@ void list_insert_last(list_t *list, list_node_t *node) {
 
 }
 
+void list_insert_before(list_t *list, list_node_t *next, list_node_t *node) {
+    ASSERT(list != (list_t *)0 && next != (list_node_t*)0 && node != (list_node_t*)0);
+
+    if (next == list->first) {
+        list_insert_first(list, node);
+        return;
+    }
+
+    node->pre = next->pre;
+    node->next = next;
+    next->pre->next = node;
+    next->pre = node;
+
+    list->size++;
+}
+
 list_node_t* list_remove_first(list_t *list){
     ASSERT(list != (list_t *)0);
 
@@ -1,33 +1,224 @@
+/**
+ * @file log.c
+ * @author kbpoyo (kbpoyo@qq.com)
+ * @brief  内核日志，日志先写入内存中的环形缓冲区，再由串口发送中断逐字节发出，
+ *         写日志不再等待串口，可在中断处理程序中调用
+ * @version 0.1
+ * @date 2023-09-16
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
 #include "tools/log.h"
 
 #include <stdarg.h>
 
 #include "core/dev.h"
+#include "core/task.h"
 #include "dev/uart.h"
 #include "tools/klib.h"
 
-// 定义互斥锁保护输出资源，确保输出为原子操作
-static mutex_t mutex;
+#define LOG_BUF_MASK (LOG_BUF_SIZE - 1)
 
-// 日志打印需要的设备id
-static int log_dev_id;
+// 日志环形缓冲区，位置均单调递增，与LOG_BUF_MASK相与得到实际位置
+// 写入者在关中断的情况下预留空间，在开中断的情况下拷贝日志内容，
+// 所有写入者都完成后才推进commit，使发送中断与读取者只看到完整的日志
+static struct {
+  char buf[LOG_BUF_SIZE];
+  uint32_t head;    // 已预留空间的结束位置
+  uint32_t commit;  // 已写入完成的结束位置
+  uint32_t tx;      // 已由串口发出的结束位置，其后的内容不能被覆盖
+  uint32_t rd;      // /dev/kmsg的读取位置，可能已被覆盖
+  int writers;      // 正在拷贝日志内容的写入者数量
+  int dropped;      // 缓冲区已满时被丢弃的日志条数
+  int cr_pending;   // 当前发送的'\n'之前已补发'\r'
+  int tx_ready;     // 串口是否已初始化
+} klog __attribute__((section(".data"), aligned(4)));
 
 /**
- * @brief  初始化串行端口寄存器COM1
+ * @brief  初始化日志输出
  *
  */
 void log_init(void) {
-  // 初始化互斥锁
-  mutex_init(&mutex);
+  // 打开一个tty设备，由其完成串口的初始化
+  if (dev_open(DEV_TTY, 0, (void *)0) < 0) {
+    // 串口未初始化，日志保留在缓冲区中，不启动发送
+    log_error("log_init: open tty0 failed\n");
+    return;
+  }
 
-  // 打开一个tty设备用于日志打印
-  log_dev_id = dev_open(DEV_TTY, 0, (void *)0);
+  // 串口就绪，发出初始化前缓存的日志
+  klog.tx_ready = 1;
+  uart_tx_start();
 
   log_printf(ESC_COLOR_DEFAULT "log_init success...\n");
 }
 
 /**
- * @brief  格式化输出到串口
+ * @brief  将data拷贝到环形缓冲区的pos位置
+ *
+ * @param pos
+ * @param data
+ * @param size
+ */
+static void log_copy_in(uint32_t pos, const char *data, int size) {
+  uint32_t offset = pos & LOG_BUF_MASK;
+  int first = LOG_BUF_SIZE - offset;
+  if (first > size) {
+    first = size;
+  }
+
+  kernel_memcpy(klog.buf + offset, data, first);
+  kernel_memcpy(klog.buf, data + first, size - first);
+}
+
+/**
+ * @brief  将一条日志写入环形缓冲区，并启动串口发送
+ *         缓冲区中未发出的内容不被覆盖，空间不足时丢弃该条日志并计数，
+ *         之后写入的第一条日志前会补充一条丢弃计数，连续的丢弃只报告一次
+ *
+ * @param str
+ * @param size
+ */
+static void log_write(const char *str, int size) {
+  char notice[32];
+  int notice_size = 0;
+
+  // 1.关中断预留空间
+  cpu_state_t state = task_enter_protection();
+  if (klog.dropped) {
+    kernel_sprintf(notice, "log: %d dropped\n", klog.dropped);
+    notice_size = kernel_strlen(notice);
+  }
+
+  if (klog.head + notice_size + size - klog.tx > LOG_BUF_SIZE) {
+    klog.dropped++;
+    task_leave_protection(state);
+    return;
+  }
+
+  uint32_t pos = klog.head;
+  klog.head += notice_size + size;
+  klog.dropped = 0;
+  klog.writers++;
+  task_leave_protection(state);
+
+  // 2.开中断拷贝日志内容，期间其他任务或中断可继续写入
+  log_copy_in(pos, notice, notice_size);
+  log_copy_in(pos + notice_size, str, size);
+
+  // 3.最后一个完成的写入者提交全部已预留的空间
+  state = task_enter_protection();
+  if (--klog.writers == 0) {
+    klog.commit = klog.head;
+  }
+  task_leave_protection(state);
+
+  if (klog.tx_ready) {
+    uart_tx_start();
+  }
+}
+
+/**
+ * @brief  取出下一个需要由串口发送的字节，'\n'之前补发'\r'
+ *         只由串口发送中断或关中断的log_flush调用
+ *
+ * @param c
+ * @return int 0：成功，-1：没有待发送的内容
+ */
+int log_tx_byte(char *c) {
+  if (klog.tx == klog.commit) {
+    return -1;
+  }
+
+  *c = klog.buf[klog.tx & LOG_BUF_MASK];
+  if (*c == '\n' && !klog.cr_pending) {
+    klog.cr_pending = 1;
+    *c = '\r';
+    return 0;
+  }
+
+  klog.cr_pending = 0;
+  klog.tx++;
+  return 0;
+}
+
+/**
+ * @brief  关中断并同步发出缓冲区中剩余的日志，用于系统停止运行前
+ *
+ */
+void log_flush(void) {
+  if (!klog.tx_ready) {
+    return;
+  }
+
+  cpu_state_t state = task_enter_protection();
+  klog.commit = klog.head;  // 被打断的写入者不会再继续，直接提交
+  uart_tx_flush();
+  task_leave_protection(state);
+}
+
+/**
+ * @brief  读取日志，供/dev/kmsg使用，所有读取者共享同一个读取位置
+ *         读取位置的内容已被覆盖时，跳到最早的完整一行并报告丢失的字节数
+ *
+ * @param buf
+ * @param size
+ * @return int 读取的字节数，0：没有新的日志
+ */
+int log_read(char *buf, int size) {
+  char chunk[64];
+  int len = 0;
+
+  while (len < size) {
+    int n = 0;
+
+    // 1.关中断从环形缓冲区拷贝一小段，期间预留的空间不会覆盖读取的内容
+    cpu_state_t state = task_enter_protection();
+    uint32_t oldest = klog.head > LOG_BUF_SIZE ? klog.head - LOG_BUF_SIZE : 0;
+    if (klog.rd < oldest) {
+      uint32_t lost = oldest - klog.rd;
+      klog.rd = oldest;
+      while (klog.rd < klog.commit &&
+             klog.buf[(klog.rd++) & LOG_BUF_MASK] != '\n') {
+        lost++;
+      }
+      kernel_sprintf(chunk, "kmsg: %d bytes lost\n", lost);
+      n = kernel_strlen(chunk);
+    } else {
+      n = klog.commit - klog.rd;
+      if (n > sizeof(chunk)) {
+        n = sizeof(chunk);
+      }
+      if (n > size - len) {
+        n = size - len;
+      }
+      for (int i = 0; i < n; ++i) {
+        chunk[i] = klog.buf[(klog.rd + i) & LOG_BUF_MASK];
+      }
+      klog.rd += n;
+    }
+    task_leave_protection(state);
+
+    // 剩余空间不足时丢失提示被截断
+    if (n > size - len) {
+      n = size - len;
+    }
+    if (n == 0) {
+      break;
+    }
+
+    // 2.开中断拷贝到buf，buf可能位于用户空间
+    kernel_memcpy(buf + len, chunk, n);
+    len += n;
+  }
+
+  return len;
+}
+
+/**
+ * @brief  格式化输出到日志缓冲区
  *
  * @param formate
  * @param ...
@@ -43,12 +234,8 @@ void log_printf(const char *formate, ...) {
   kernel_vsprintf(str_buf, formate, args);
   va_end(args);
 
-  mutex_lock(&mutex);  // TODO:加锁
-
-  // tty设备在显示器上写入时是根据当前光标位置来的，所以不需要传入addr参数
-  dev_write(log_dev_id, 0, str_buf, kernel_strlen(str_buf));
-
-  mutex_unlock(&mutex);  // TODO:解锁
+  // 3.写入日志缓冲区，由串口发送中断异步发出
+  log_write(str_buf, kernel_strlen(str_buf));
 }
 
 /**
@@ -69,4 +256,4 @@ void log_error(const char *fmt, ...) {
   va_end(ap);
 
   log_printf(ESC_COLOR_ERROR "error: %s" ESC_COLOR_DEFAULT "\n", string);
-}
\ No newline at end of file
+}
@@ -0,0 +1,414 @@
+/**
+ * @file rbtree.c
+ * @author kbpoyo (kbpoyo@qq.com)
+ * @brief  侵入式红黑树，插入、删除与查找均为O(log n)
+ *         空指针视为黑色的叶子节点
+ * @version 0.1
+ * @date 2023-09-15
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#include "tools/rbtree.h"
+
+#include "tools/assert.h"
+
+/**
+ * @brief  判断节点是否为红色，空节点为黑色
+ *
+ * @param node
+ * @return int
+ */
+static inline int is_red(rbtree_node_t *node) {
+  return node && node->color == RBTREE_RED;
+}
+
+/**
+ * @brief  用new_node替换old_node在其父节点中的位置
+ *
+ * @param tree
+ * @param old_node
+ * @param new_node
+ */
+static void replace_child(rbtree_t *tree, rbtree_node_t *old_node,
+                          rbtree_node_t *new_node) {
+  rbtree_node_t *parent = old_node->parent;
+  if (!parent) {
+    tree->root = new_node;
+  } else if (parent->left == old_node) {
+    parent->left = new_node;
+  } else {
+    parent->right = new_node;
+  }
+
+  if (new_node) {
+    new_node->parent = parent;
+  }
+}
+
+/**
+ * @brief  以node为支点左旋，node的右子节点成为其父节点
+ *
+ * @param tree
+ * @param node
+ */
+static void rotate_left(rbtree_t *tree, rbtree_node_t *node) {
+  rbtree_node_t *right = node->right;
+
+  node->right = right->left;
+  if (right->left) {
+    right->left->parent = node;
+  }
+
+  replace_child(tree, node, right);
+  right->left = node;
+  node->parent = right;
+}
+
+/**
+ * @brief  以node为支点右旋，node的左子节点成为其父节点
+ *
+ * @param tree
+ * @param node
+ */
+static void rotate_right(rbtree_t *tree, rbtree_node_t *node) {
+  rbtree_node_t *left = node->left;
+
+  node->left = left->right;
+  if (left->right) {
+    left->right->parent = node;
+  }
+
+  replace_child(tree, node, left);
+  left->right = node;
+  node->parent = left;
+}
+
+/**
+ * @brief  插入节点，与已有节点相等时插入到其右侧
+ *
+ * @param tree
+ * @param node
+ */
+void rbtree_insert(rbtree_t *tree, rbtree_node_t *node) {
+  ASSERT(tree != (rbtree_t *)0 && node != (rbtree_node_t *)0);
+
+  // 1.按二叉搜索树的方式找到插入位置
+  rbtree_node_t *parent = (rbtree_node_t *)0;
+  rbtree_node_t **link = &tree->root;
+  while (*link) {
+    parent = *link;
+    link = tree->cmp(node, parent) < 0 ? &parent->left : &parent->right;
+  }
+
+  node->parent = parent;
+  node->left = node->right = (rbtree_node_t *)0;
+  node->color = RBTREE_RED;
+  *link = node;
+  tree->size++;
+
+  // 2.新节点为红色，父节点也为红色时向上修复
+  while (is_red(node->parent)) {
+    parent = node->parent;
+    rbtree_node_t *grand = parent->parent;  // 父节点为红色，必然不是根节点
+
+    if (parent == grand->left) {
+      rbtree_node_t *uncle = grand->right;
+      if (is_red(uncle)) {
+        // 2.1叔节点为红色，父、叔节点变黑，祖父节点变红后继续向上修复
+        parent->color = uncle->color = RBTREE_BLACK;
+        grand->color = RBTREE_RED;
+        node = grand;
+        continue;
+      }
+
+      // 2.2叔节点为黑色，node为右子节点时先转换为左子节点的情况
+      if (node == parent->right) {
+        rotate_left(tree, parent);
+        node = parent;
+        parent = node->parent;
+      }
+
+      // 2.3父节点变黑，祖父节点变红后右旋
+      parent->color = RBTREE_BLACK;
+      grand->color = RBTREE_RED;
+      rotate_right(tree, grand);
+    } else {
+      // 与上面对称
+      rbtree_node_t *uncle = grand->left;
+      if (is_red(uncle)) {
+        parent->color = uncle->color = RBTREE_BLACK;
+        grand->color = RBTREE_RED;
+        node = grand;
+        continue;
+      }
+
+      if (node == parent->left) {
+        rotate_right(tree, parent);
+        node = parent;
+        parent = node->parent;
+      }
+
+      parent->color = RBTREE_BLACK;
+      grand->color = RBTREE_RED;
+      rotate_left(tree, grand);
+    }
+  }
+
+  tree->root->color = RBTREE_BLACK;
+}
+
+/**
+ * @brief  删除黑色节点后修复红黑树，node所在的子树比其兄弟子树少一个黑色节点
+ *
+ * @param tree
+ * @param node 可能为空
+ * @param parent node的父节点
+ */
+static void remove_fixup(rbtree_t *tree, rbtree_node_t *node,
+                         rbtree_node_t *parent) {
+  while (node != tree->root && !is_red(node)) {
+    if (node == parent->left) {
+      rbtree_node_t *sibling = parent->right;
+
+      // 1.兄弟节点为红色，旋转后转换为兄弟节点为黑色的情况
+      if (is_red(sibling)) {
+        sibling->color = RBTREE_BLACK;
+        parent->color = RBTREE_RED;
+        rotate_left(tree, parent);
+        sibling = parent->right;
+      }
+
+      // 2.兄弟节点的子节点均为黑色，兄弟节点变红，缺少的黑色节点移到父节点上
+      if (!is_red(sibling->left) && !is_red(sibling->right)) {
+        sibling->color = RBTREE_RED;
+        node = parent;
+        parent = node->parent;
+        continue;
+      }
+
+      // 3.兄弟节点的右子节点为黑色，先旋转使其右子节点为红色
+      if (!is_red(sibling->right)) {
+        sibling->left->color = RBTREE_BLACK;
+        sibling->color = RBTREE_RED;
+        rotate_right(tree, sibling);
+        sibling = parent->right;
+      }
+
+      // 4.兄弟节点的右子节点为红色，旋转父节点后补足黑色节点，修复完成
+      sibling->color = parent->color;
+      parent->color = RBTREE_BLACK;
+      sibling->right->color = RBTREE_BLACK;
+      rotate_left(tree, parent);
+      node = tree->root;
+    } else {
+      // 与上面对称
+      rbtree_node_t *sibling = parent->left;
+
+      if (is_red(sibling)) {
+        sibling->color = RBTREE_BLACK;
+        parent->color = RBTREE_RED;
+        rotate_right(tree, parent);
+        sibling = parent->left;
+      }
+
+      if (!is_red(sibling->left) && !is_red(sibling->right)) {
+        sibling->color = RBTREE_RED;
+        node = parent;
+        parent = node->parent;
+        continue;
+      }
+
+      if (!is_red(sibling->left)) {
+        sibling->right->color = RBTREE_BLACK;
+        sibling->color = RBTREE_RED;
+        rotate_left(tree, sibling);
+        sibling = parent->left;
+      }
+
+      sibling->color = parent->color;
+      parent->color = RBTREE_BLACK;
+      sibling->left->color = RBTREE_BLACK;
+      rotate_right(tree, parent);
+      node = tree->root;
+    }
+  }
+
+  if (node) {
+    node->color = RBTREE_BLACK;
+  }
+}
+
+/**
+ * @brief  从红黑树中移除节点
+ *
+ * @param tree
+ * @param node
+ */
+void rbtree_remove(rbtree_t *tree, rbtree_node_t *node) {
+  ASSERT(tree != (rbtree_t *)0 && node != (rbtree_node_t *)0);
+
+  rbtree_node_t *child, *parent;
+  int color;
+
+  if (node->left && node->right) {
+    // 1.有两个子节点，用后继节点替换node的位置，转换为删除后继节点原来的位置
+    rbtree_node_t *next = node->right;
+    while (next->left) {
+      next = next->left;
+    }
+
+    child = next->right;
+    color = next->color;
+    if (next->parent == node) {
+      parent = next;
+    } else {
+      parent = next->parent;
+      replace_child(tree, next, child);
+      next->right = node->right;
+      next->right->parent = next;
+    }
+
+    replace_child(tree, node, next);
+    next->left = node->left;
+    next->left->parent = next;
+    next->color = node->color;
+  } else {
+    // 2.最多一个子节点，直接用子节点替换
+    child = node->left ? node->left : node->right;
+    parent = node->parent;
+    color = node->color;
+    replace_child(tree, node, child);
+  }
+
+  tree->size--;
+  node->parent = node->left = node->right = (rbtree_node_t *)0;
+
+  // 3.删除的是黑色节点时需要修复
+  if (color == RBTREE_BLACK) {
+    remove_fixup(tree, child, parent);
+  }
+}
+
+/**
+ * @brief  查找与key相等的节点
+ *
+ * @param tree
+ * @param key
+ * @param key_cmp 键值比较函数
+ * @return rbtree_node_t* 不存在时返回0
+ */
+rbtree_node_t *rbtree_find(rbtree_t *tree, const void *key,
+                           rbtree_key_cmp_t key_cmp) {
+  ASSERT(tree != (rbtree_t *)0);
+
+  rbtree_node_t *node = tree->root;
+  while (node) {
+    int ret = key_cmp(key, node);
+    if (ret == 0) {
+      return node;
+    }
+    node = ret < 0 ? node->left : node->right;
+  }
+
+  return (rbtree_node_t *)0;
+}
+
+/**
+ * @brief  查找第一个不小于key的节点
+ *
+ * @param tree
+ * @param key
+ * @param key_cmp 键值比较函数
+ * @return rbtree_node_t* 不存在时返回0
+ */
+rbtree_node_t *rbtree_lower_bound(rbtree_t *tree, const void *key,
+                                  rbtree_key_cmp_t key_cmp) {
+  ASSERT(tree != (rbtree_t *)0);
+
+  rbtree_node_t *node = tree->root;
+  rbtree_node_t *bound = (rbtree_node_t *)0;
+  while (node) {
+    if (key_cmp(key, node) <= 0) {
+      bound = node;
+      node = node->left;
+    } else {
+      node = node->right;
+    }
+  }
+
+  return bound;
+}
+
+/**
+ * @brief  获取最小的节点
+ *
+ * @param tree
+ * @return rbtree_node_t*
+ */
+rbtree_node_t *rbtree_first(rbtree_t *tree) {
+  rbtree_node_t *node = tree->root;
+  while (node && node->left) {
+    node = node->left;
+  }
+
+  return node;
+}
+
+/**
+ * @brief  获取最大的节点
+ *
+ * @param tree
+ * @return rbtree_node_t*
+ */
+rbtree_node_t *rbtree_last(rbtree_t *tree) {
+  rbtree_node_t *node = tree->root;
+  while (node && node->right) {
+    node = node->right;
+  }
+
+  return node;
+}
+
+/**
+ * @brief  获取中序遍历中node的下一个节点
+ *
+ * @param node
+ * @return rbtree_node_t* 不存在时返回0
+ */
+rbtree_node_t *rbtree_next(rbtree_node_t *node) {
+  if (node->right) {
+    node = node->right;
+    while (node->left) {
+      node = node->left;
+    }
+    return node;
+  }
+
+  while (node->parent && node == node->parent->right) {
+    node = node->parent;
+  }
+  return node->parent;
+}
+
+/**
+ * @brief  获取中序遍历中node的上一个节点
+ *
+ * @param node
+ * @return rbtree_node_t* 不存在时返回0
+ */
+rbtree_node_t *rbtree_prev(rbtree_node_t *node) {
+  if (node->left) {
+    node = node->left;
+    while (node->right) {
+      node = node->right;
+    }
+    return node;
+  }
+
+  while (node->parent && node == node->parent->left) {
+    node = node->parent;
+  }
+  return node->parent;
+}
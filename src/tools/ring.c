@@ -0,0 +1,139 @@
+/**
+ * @file ring.c
+ * @author kbpoyo (kbpoyo@qq.com)
+ * @brief  单生产者单消费者的无锁环形缓冲区
+ *         生产者先写入数据再更新head，消费者先读出数据再更新tail，
+ *         中断处理程序与任务分别作为生产者和消费者时无需关中断
+ * @version 0.1
+ * @date 2023-09-14
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#include "tools/ring.h"
+
+#include "tools/assert.h"
+#include "tools/klib.h"
+
+/**
+ * @brief  编译器屏障，防止对缓冲区的访问与head、tail的更新被重排
+ *         ARM920T为单核且按序执行访存指令，不需要硬件内存屏障
+ *
+ */
+static inline void ring_barrier(void) { __asm__ __volatile__("" ::: "memory"); }
+
+/**
+ * @brief  初始化环形缓冲区
+ *
+ * @param ring
+ * @param buf 缓冲区起始地址
+ * @param size 缓冲区大小，必须为2的幂
+ */
+void ring_init(ring_t *ring, uint8_t *buf, uint32_t size) {
+  ASSERT(ring != (ring_t *)0 && buf != (uint8_t *)0);
+  ASSERT(size && (size & (size - 1)) == 0);
+
+  ring->buf = buf;
+  ring->mask = size - 1;
+  ring->head = ring->tail = 0;
+}
+
+/**
+ * @brief  生产者向环形缓冲区写入一个字节
+ *
+ * @param ring
+ * @param c
+ * @return int 0：成功，-1：缓冲区已满
+ */
+int ring_put(ring_t *ring, uint8_t c) {
+  uint32_t head = ring->head;
+  if (head - ring->tail > ring->mask) {
+    return -1;
+  }
+
+  ring->buf[head & ring->mask] = c;
+  ring_barrier();
+  ring->head = head + 1;
+  return 0;
+}
+
+/**
+ * @brief  消费者从环形缓冲区读取一个字节
+ *
+ * @param ring
+ * @param c
+ * @return int 0：成功，-1：缓冲区为空
+ */
+int ring_get(ring_t *ring, uint8_t *c) {
+  uint32_t tail = ring->tail;
+  if (ring->head == tail) {
+    return -1;
+  }
+
+  ring_barrier();
+  *c = ring->buf[tail & ring->mask];
+  ring_barrier();
+  ring->tail = tail + 1;
+  return 0;
+}
+
+/**
+ * @brief  生产者向环形缓冲区写入最多size个字节
+ *
+ * @param ring
+ * @param buf
+ * @param size
+ * @return uint32_t 实际写入的字节数
+ */
+uint32_t ring_put_bulk(ring_t *ring, const uint8_t *buf, uint32_t size) {
+  uint32_t head = ring->head;
+  uint32_t free = ring->mask + 1 - (head - ring->tail);
+  if (size > free) {
+    size = free;
+  }
+
+  // 写入位置到缓冲区末尾的部分不够时，剩余部分从缓冲区头部开始写入
+  uint32_t offset = head & ring->mask;
+  uint32_t first = ring->mask + 1 - offset;
+  if (first > size) {
+    first = size;
+  }
+  kernel_memcpy(ring->buf + offset, buf, first);
+  kernel_memcpy(ring->buf, buf + first, size - first);
+
+  ring_barrier();
+  ring->head = head + size;
+  return size;
+}
+
+/**
+ * @brief  消费者从环形缓冲区读取最多size个字节
+ *
+ * @param ring
+ * @param buf
+ * @param size
+ * @return uint32_t 实际读取的字节数
+ */
+uint32_t ring_get_bulk(ring_t *ring, uint8_t *buf, uint32_t size) {
+  uint32_t tail = ring->tail;
+  uint32_t count = ring->head - tail;
+  if (size > count) {
+    size = count;
+  }
+
+  ring_barrier();
+
+  // 读取位置到缓冲区末尾的部分不够时，剩余部分从缓冲区头部开始读取
+  uint32_t offset = tail & ring->mask;
+  uint32_t first = ring->mask + 1 - offset;
+  if (first > size) {
+    first = size;
+  }
+  kernel_memcpy(buf, ring->buf + offset, first);
+  kernel_memcpy(buf + first, ring->buf, size - first);
+
+  ring_barrier();
+  ring->tail = tail + size;
+  return size;
+}